@@ -0,0 +1,570 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+
+#include "MemoryPool.h"
+#include <mutex>
+#include <type_traits>
+
+namespace AppShift::Memory {
+	/**
+	 * Policies choosing the features of a BasicMemoryPool at compile time.
+	 * Features that are turned off are compiled out, and using their functions fails to compile.
+	 */
+	namespace Policies {
+		struct SUnitHeadersKind {};
+		struct SFreeSupportKind {};
+		struct SScopesKind {};
+		struct SThreadSafetyKind {};
+		struct SStatisticsKind {};
+		struct SBlockProviderKind {};
+
+		// Write a header before every unit, needed to free & re-allocate units
+		template<bool Enabled>
+		struct UnitHeaders { using kind = SUnitHeadersKind; static constexpr bool enabled = Enabled; };
+
+		// Count the units of every block so units can be freed & empty blocks released
+		template<bool Enabled>
+		struct FreeSupport { using kind = SFreeSupportKind; static constexpr bool enabled = Enabled; };
+
+		// Support startScope & endScope
+		template<bool Enabled>
+		struct Scopes { using kind = SScopesKind; static constexpr bool enabled = Enabled; };
+
+		// Lock the pool in every call so it can be shared between threads
+		template<bool Enabled>
+		struct ThreadSafety { using kind = SThreadSafetyKind; static constexpr bool enabled = Enabled; };
+
+		// Count allocations, frees & blocks, returned by getStats
+		template<bool Enabled>
+		struct Statistics { using kind = SStatisticsKind; static constexpr bool enabled = Enabled; };
+
+		// Type of the provider of the blocks, held by value so its calls are not virtual
+		template<typename Provider>
+		struct BlockProvider { using kind = SBlockProviderKind; using type = Provider; };
+
+		// Find the policy of a kind in a list of policies, or use the default
+		template<typename Kind, typename Default, typename... List>
+		struct SSelectPolicy { using type = Default; };
+
+		template<typename Kind, typename Default, typename First, typename... Rest>
+		struct SSelectPolicy<Kind, Default, First, Rest...> {
+			using type = std::conditional_t<std::is_same_v<typename First::kind, Kind>, First, typename SSelectPolicy<Kind, Default, Rest...>::type>;
+		};
+	}
+
+	// Header of a unit in a BasicMemoryPool, which always keeps the block of the unit
+	struct SBasicMemoryUnitHeader {
+		size_t length;
+		SMemoryBlockHeader* container;
+	};
+
+	// Counters of a BasicMemoryPool with statistics
+	struct SBasicMemoryPoolStats {
+		size_t allocations;
+		size_t frees;
+		size_t bytesAllocated;
+		size_t blocksCreated;
+		size_t blocksFreed;
+	};
+
+	/**
+	 * A memory pool with its features chosen at compile time, by default:
+	 * UnitHeaders<true>, FreeSupport<true>, Scopes<true>, ThreadSafety<false>, Statistics<false>, BlockProvider<MallocBlockProvider>
+	 */
+	template<typename... PoolPolicies>
+	class BasicMemoryPool {
+	public:
+		static constexpr bool hasUnitHeaders = Policies::SSelectPolicy<Policies::SUnitHeadersKind, Policies::UnitHeaders<true>, PoolPolicies...>::type::enabled;
+		static constexpr bool hasFreeSupport = Policies::SSelectPolicy<Policies::SFreeSupportKind, Policies::FreeSupport<true>, PoolPolicies...>::type::enabled;
+		static constexpr bool hasScopes = Policies::SSelectPolicy<Policies::SScopesKind, Policies::Scopes<true>, PoolPolicies...>::type::enabled;
+		static constexpr bool hasThreadSafety = Policies::SSelectPolicy<Policies::SThreadSafetyKind, Policies::ThreadSafety<false>, PoolPolicies...>::type::enabled;
+		static constexpr bool hasStatistics = Policies::SSelectPolicy<Policies::SStatisticsKind, Policies::Statistics<false>, PoolPolicies...>::type::enabled;
+		using Provider = typename Policies::SSelectPolicy<Policies::SBlockProviderKind, Policies::BlockProvider<MallocBlockProvider>, PoolPolicies...>::type::type;
+
+		static_assert(!hasFreeSupport || hasUnitHeaders, "Freeing units needs unit headers");
+
+		// Size of the header written before every unit
+		static constexpr size_t unitHeaderSize = hasUnitHeaders ? sizeof(SBasicMemoryUnitHeader) : 0;
+
+		/**
+		 * Creates a memory pool and its first block
+		 *
+		 * @param size_t block_size Defines the default size of a block in the pool, by default uses MEMORYPOOL_DEFAULT_BLOCK_SIZE
+		 */
+		BasicMemoryPool(size_t block_size = MEMORYPOOL_DEFAULT_BLOCK_SIZE);
+		// Destructor
+		~BasicMemoryPool();
+
+		BasicMemoryPool(const BasicMemoryPool&) = delete;
+		BasicMemoryPool& operator=(const BasicMemoryPool&) = delete;
+
+		/**
+		 * Allocates memory in the pool
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocate(size_t size);
+
+		/**
+		 * Allocates memory in the pool with its start aligned
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 * @param size_t alignment Alignment of the allocated space, must be a power of 2
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocateAligned(size_t size, size_t alignment);
+
+		// Templated allocation, aligned to the type
+		template<typename T>
+		T* allocate(size_t instances);
+
+		/**
+		 * Re-allocates memory in the pool, grows in place if it is the last unit. Needs unit headers
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to re-allocate
+		 * @param size_t new_size New size to allocate in memory pool
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* reallocate(void* unit_pointer_start, size_t new_size);
+
+		/**
+		 * Re-allocates memory in the pool, keeping the alignment if the space is moved. Needs unit headers
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to re-allocate
+		 * @param size_t new_size New size to allocate in memory pool
+		 * @param size_t alignment Alignment of the allocated space, must be a power of 2
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* reallocateAligned(void* unit_pointer_start, size_t new_size, size_t alignment);
+
+		// Templated re-allocation, aligned to the type
+		template<typename T>
+		T* reallocate(T* unit_pointer_start, size_t instances);
+
+		/**
+		 * Frees memory in the pool. Needs free support
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to free
+		 */
+		void free(void* unit_pointer_start);
+
+		/**
+		 * Start a scope, all the allocations until the matching endScope are freed by it. Needs scopes
+		 */
+		void startScope();
+
+		/**
+		 * End the last scope started. Needs scopes
+		 */
+		void endScope();
+
+		/**
+		 * Free all the allocations at once, keeping the first block
+		 */
+		void reset();
+
+		/**
+		 * Get the counters of the pool. Needs statistics
+		 *
+		 * @returns SBasicMemoryPoolStats Counters since the pool was created
+		 */
+		SBasicMemoryPoolStats getStats();
+
+		// Blocks of the pool, the current block is the last one
+		SMemoryBlockHeader* firstBlock;
+		SMemoryBlockHeader* currentBlock;
+		size_t defaultBlockSize;
+
+	private:
+		// Lock that compiles to nothing without thread safety
+		struct SNoLock {
+			void lock() {}
+			void unlock() {}
+		};
+		// Counters that take no work without statistics
+		struct SNoStats {};
+
+		// Next unit & end of the usable space of the current block, the offset of the current block is kept here
+		char* cursor;
+		char* end;
+		// Empty block kept for reuse
+		SMemoryBlockHeader* spareBlock;
+		SMemoryScopeHeader* currentScope;
+		Provider provider;
+		std::conditional_t<hasThreadSafety, std::mutex, SNoLock> poolLock;
+		std::conditional_t<hasStatistics, SBasicMemoryPoolStats, SNoStats> stats;
+
+		// Round a size so the next unit stays aligned
+		static size_t roundUnitSize(size_t size) {
+			return (size + alignof(SBasicMemoryUnitHeader) - 1) & ~(size_t)(alignof(SBasicMemoryUnitHeader) - 1);
+		}
+
+		static char* getBlockData(SMemoryBlockHeader* block) {
+			return reinterpret_cast<char*>(block + 1);
+		}
+
+		// Allocation without locking
+		void* allocateUnit(size_t size);
+
+		// Allocation in a new block, when the current block is full
+		MEMORYPOOL_NOINLINE void* allocateInNewBlock(size_t size);
+
+		// Write a unit at the cursor, the space must be checked
+		void* placeUnit(size_t size, bool deleted = false);
+
+		// Create a block big enough for a unit & make it current
+		void createMemoryBlock(size_t block_size);
+
+		// Make a block the current one, keeping the offset of the previous one
+		void useBlock(SMemoryBlockHeader* block, size_t offset);
+
+		// Remove a block that is not the current one from the chain & free it
+		void releaseMemoryBlock(SMemoryBlockHeader* block);
+
+		// Keep an empty block as the spare block, or give it back to the provider
+		void freeMemoryBlock(SMemoryBlockHeader* block);
+	};
+
+	// A pool with every feature of the MemoryPool that can be chosen at compile time
+	using StandardMemoryPool = BasicMemoryPool<>;
+
+	// A pure arena: no headers, no frees & no scopes - allocation is a pointer bump
+	using PerformanceMemoryPool = BasicMemoryPool<Policies::UnitHeaders<false>, Policies::FreeSupport<false>, Policies::Scopes<false>>;
+
+	template<typename... PoolPolicies>
+	inline BasicMemoryPool<PoolPolicies...>::BasicMemoryPool(size_t block_size)
+	{
+		this->firstBlock = this->currentBlock = nullptr;
+		this->cursor = this->end = nullptr;
+		this->defaultBlockSize = block_size;
+		this->spareBlock = nullptr;
+		this->currentScope = nullptr;
+		if constexpr (hasStatistics) this->stats = SBasicMemoryPoolStats{ 0, 0, 0, 0, 0 };
+		this->createMemoryBlock(block_size);
+	}
+
+	template<typename... PoolPolicies>
+	inline BasicMemoryPool<PoolPolicies...>::~BasicMemoryPool()
+	{
+		SMemoryBlockHeader* block = this->firstBlock;
+		while (block != nullptr) {
+			SMemoryBlockHeader* next_block = block->next;
+			this->provider.freeBlock(block, sizeof(SMemoryBlockHeader) + block->blockSize);
+			block = next_block;
+		}
+		if (this->spareBlock != nullptr) this->provider.freeBlock(this->spareBlock, sizeof(SMemoryBlockHeader) + this->spareBlock->blockSize);
+	}
+
+	template<typename... PoolPolicies>
+	inline void* BasicMemoryPool<PoolPolicies...>::allocate(size_t size)
+	{
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+		return this->allocateUnit(size);
+	}
+
+	template<typename... PoolPolicies>
+	inline void* BasicMemoryPool<PoolPolicies...>::allocateUnit(size_t size)
+	{
+		size = roundUnitSize(size);
+		if (size + unitHeaderSize <= static_cast<size_t>(this->end - this->cursor)) return this->placeUnit(size);
+		return this->allocateInNewBlock(size);
+	}
+
+	template<typename... PoolPolicies>
+	void* BasicMemoryPool<PoolPolicies...>::allocateInNewBlock(size_t size)
+	{
+		// Units bigger than a block get a block of their own
+		this->createMemoryBlock(size + unitHeaderSize > this->defaultBlockSize ? size + unitHeaderSize : this->defaultBlockSize);
+		return this->placeUnit(size);
+	}
+
+	template<typename... PoolPolicies>
+	inline void* BasicMemoryPool<PoolPolicies...>::placeUnit(size_t size, bool deleted)
+	{
+		char* unit_start = this->cursor;
+		this->cursor += unitHeaderSize + size;
+
+		if constexpr (hasUnitHeaders) {
+			SBasicMemoryUnitHeader* unit = reinterpret_cast<SBasicMemoryUnitHeader*>(unit_start);
+			unit->length = deleted ? size | MEMORYPOOL_UNIT_DELETED : size;
+			unit->container = this->currentBlock;
+		}
+		if constexpr (hasFreeSupport) {
+			this->currentBlock->numberOfAllocated++;
+			if (deleted) this->currentBlock->numberOfDeleted++;
+		}
+		if constexpr (hasStatistics) {
+			if (!deleted) {
+				this->stats.allocations++;
+				this->stats.bytesAllocated += size;
+			}
+		}
+
+		return unit_start + unitHeaderSize;
+	}
+
+	template<typename... PoolPolicies>
+	inline void* BasicMemoryPool<PoolPolicies...>::allocateAligned(size_t size, size_t alignment)
+	{
+		if (alignment <= alignof(SBasicMemoryUnitHeader)) return this->allocate(size);
+		if (alignment & (alignment - 1)) throw EMemoryErrors::INVALID_ALIGNMENT;
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+		size = roundUnitSize(size);
+
+		for (;;) {
+			// A padding unit needs room for its own header
+			uintptr_t unit_data = reinterpret_cast<uintptr_t>(this->cursor) + unitHeaderSize;
+			size_t padding = (alignment - unit_data % alignment) % alignment;
+			if (padding != 0 && padding < unitHeaderSize) padding += alignment;
+
+			if (padding + unitHeaderSize + size <= static_cast<size_t>(this->end - this->cursor)) {
+				// Headers are kept contiguous with a deleted unit over the padding
+				if constexpr (hasUnitHeaders) {
+					if (padding != 0) this->placeUnit(padding - unitHeaderSize, true);
+				}
+				else this->cursor += padding;
+				return this->placeUnit(size);
+			}
+
+			size_t worst_case = size + 2 * unitHeaderSize + alignment;
+			this->createMemoryBlock(worst_case > this->defaultBlockSize ? worst_case : this->defaultBlockSize);
+		}
+	}
+
+	template<typename... PoolPolicies>
+	template<typename T>
+	inline T* BasicMemoryPool<PoolPolicies...>::allocate(size_t instances)
+	{
+		return reinterpret_cast<T*>(this->allocateAligned(instances * sizeof(T), alignof(T)));
+	}
+
+	template<typename... PoolPolicies>
+	inline void* BasicMemoryPool<PoolPolicies...>::reallocate(void* unit_pointer_start, size_t new_size)
+	{
+		return this->reallocateAligned(unit_pointer_start, new_size, alignof(SBasicMemoryUnitHeader));
+	}
+
+	template<typename... PoolPolicies>
+	template<typename T>
+	inline T* BasicMemoryPool<PoolPolicies...>::reallocate(T* unit_pointer_start, size_t instances)
+	{
+		return reinterpret_cast<T*>(this->reallocateAligned(reinterpret_cast<void*>(unit_pointer_start), instances * sizeof(T), alignof(T)));
+	}
+
+	template<typename... PoolPolicies>
+	inline void* BasicMemoryPool<PoolPolicies...>::reallocateAligned(void* unit_pointer_start, size_t new_size, size_t alignment)
+	{
+		static_assert(hasUnitHeaders, "Re-allocating units needs unit headers");
+		if (unit_pointer_start == nullptr) return nullptr;
+
+		SBasicMemoryUnitHeader* unit = reinterpret_cast<SBasicMemoryUnitHeader*>(unit_pointer_start) - 1;
+		size_t length = unit->length & MEMORYPOOL_UNIT_LENGTH_MASK;
+		new_size = roundUnitSize(new_size);
+		{
+			std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+
+			// Only the current block can end at the cursor, so the last unit grows in place
+			if (reinterpret_cast<char*>(unit_pointer_start) + length == this->cursor && new_size <= length + static_cast<size_t>(this->end - this->cursor)) {
+				this->cursor += new_size - length;
+				unit->length = new_size;
+				return unit_pointer_start;
+			}
+		}
+
+		void* temp_point = this->allocateAligned(new_size, alignment);
+		std::memcpy(temp_point, unit_pointer_start, length < new_size ? length : new_size);
+		if constexpr (hasFreeSupport) this->free(unit_pointer_start);
+
+		return temp_point;
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::free(void* unit_pointer_start)
+	{
+		static_assert(hasFreeSupport, "Freeing units needs free support");
+		if (unit_pointer_start == nullptr) return;
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+
+		SBasicMemoryUnitHeader* unit = reinterpret_cast<SBasicMemoryUnitHeader*>(unit_pointer_start) - 1;
+		SMemoryBlockHeader* block = unit->container;
+		char* unit_end = reinterpret_cast<char*>(unit_pointer_start) + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+		if constexpr (hasStatistics) this->stats.frees++;
+
+		// The last unit of a block gives its space back
+		if (unit_end == this->cursor) {
+			this->cursor = reinterpret_cast<char*>(unit);
+			block->numberOfAllocated--;
+			return;
+		}
+		if (block != this->currentBlock && unit_end == getBlockData(block) + block->offset) {
+			block->offset -= unitHeaderSize + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+			block->numberOfAllocated--;
+		}
+		else {
+			unit->length |= MEMORYPOOL_UNIT_DELETED;
+			block->numberOfDeleted++;
+		}
+
+		// Blocks are kept while a scope is open, the scope may start in them
+		if (block != this->currentBlock && this->currentScope == nullptr && block->numberOfAllocated == block->numberOfDeleted)
+			this->releaseMemoryBlock(block);
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::startScope()
+	{
+		static_assert(hasScopes, "Starting a scope needs scopes");
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+
+		// The scope header is the first unit of the scope, so units before it never become the last unit
+		SMemoryScopeHeader* scope = reinterpret_cast<SMemoryScopeHeader*>(this->allocateUnit(sizeof(SMemoryScopeHeader)));
+		scope->scopeOffset = reinterpret_cast<char*>(scope) - unitHeaderSize - getBlockData(this->currentBlock);
+		scope->firstScopeBlock = this->currentBlock;
+		scope->prevScope = this->currentScope;
+		this->currentScope = scope;
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::endScope()
+	{
+		static_assert(hasScopes, "Ending a scope needs scopes");
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+
+		SMemoryScopeHeader* scope = this->currentScope;
+		SMemoryBlockHeader* scope_block = scope->firstScopeBlock;
+		size_t scope_offset = scope->scopeOffset;
+		[[maybe_unused]] char* scope_end = this->currentBlock == scope_block ? this->cursor : getBlockData(scope_block) + scope_block->offset;
+		this->currentScope = scope->prevScope;
+
+		// Free all blocks until the start of scope
+		while (this->currentBlock != scope_block) {
+			SMemoryBlockHeader* block = this->currentBlock;
+			this->currentBlock = block->prev;
+			this->currentBlock->next = nullptr;
+			this->freeMemoryBlock(block);
+		}
+
+		// Units of the scope are no longer counted
+		if constexpr (hasFreeSupport) {
+			for (char* unit_start = getBlockData(scope_block) + scope_offset; unit_start < scope_end;) {
+				SBasicMemoryUnitHeader* unit = reinterpret_cast<SBasicMemoryUnitHeader*>(unit_start);
+				scope_block->numberOfAllocated--;
+				if (unit->length & MEMORYPOOL_UNIT_DELETED) scope_block->numberOfDeleted--;
+				unit_start += unitHeaderSize + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+			}
+		}
+
+		this->useBlock(scope_block, scope_offset);
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::reset()
+	{
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+
+		while (this->currentBlock != this->firstBlock) {
+			SMemoryBlockHeader* block = this->currentBlock;
+			this->currentBlock = block->prev;
+			this->currentBlock->next = nullptr;
+			this->freeMemoryBlock(block);
+		}
+
+		this->currentScope = nullptr;
+		this->firstBlock->numberOfAllocated = 0;
+		this->firstBlock->numberOfDeleted = 0;
+		this->useBlock(this->firstBlock, 0);
+	}
+
+	template<typename... PoolPolicies>
+	inline SBasicMemoryPoolStats BasicMemoryPool<PoolPolicies...>::getStats()
+	{
+		static_assert(hasStatistics, "Getting the statistics needs statistics");
+		std::lock_guard<decltype(this->poolLock)> guard(this->poolLock);
+		return this->stats;
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::createMemoryBlock(size_t block_size)
+	{
+		// Take the spare block if it is big enough
+		SMemoryBlockHeader* block = nullptr;
+		if (this->spareBlock != nullptr && this->spareBlock->blockSize >= block_size) {
+			block = this->spareBlock;
+			this->spareBlock = nullptr;
+		}
+		else {
+			block = reinterpret_cast<SMemoryBlockHeader*>(this->provider.allocateBlock(sizeof(SMemoryBlockHeader) + block_size));
+			if (block == nullptr) throw EMemoryErrors::CANNOT_CREATE_BLOCK;
+			block->blockSize = block_size;
+			if constexpr (hasStatistics) this->stats.blocksCreated++;
+		}
+
+		block->numberOfAllocated = 0;
+		block->numberOfDeleted = 0;
+		block->pool = nullptr;
+		block->next = nullptr;
+		block->prev = this->currentBlock;
+		if (this->currentBlock != nullptr) this->currentBlock->next = block;
+		else this->firstBlock = block;
+
+		this->useBlock(block, 0);
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::useBlock(SMemoryBlockHeader* block, size_t offset)
+	{
+		if (this->currentBlock != nullptr && this->currentBlock != block)
+			this->currentBlock->offset = this->cursor - getBlockData(this->currentBlock);
+
+		this->currentBlock = block;
+		block->offset = offset;
+		this->cursor = getBlockData(block) + offset;
+		this->end = getBlockData(block) + block->blockSize;
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::releaseMemoryBlock(SMemoryBlockHeader* block)
+	{
+		if (block == this->firstBlock) this->firstBlock = block->next;
+		else block->prev->next = block->next;
+		block->next->prev = block->prev;
+
+		this->freeMemoryBlock(block);
+	}
+
+	template<typename... PoolPolicies>
+	inline void BasicMemoryPool<PoolPolicies...>::freeMemoryBlock(SMemoryBlockHeader* block)
+	{
+		if constexpr (hasStatistics) this->stats.blocksFreed++;
+		if (this->spareBlock == nullptr) {
+			this->spareBlock = block;
+			return;
+		}
+
+		if (this->spareBlock->blockSize < block->blockSize) std::swap(this->spareBlock, block);
+		this->provider.freeBlock(block, sizeof(SMemoryBlockHeader) + block->blockSize);
+	}
+}
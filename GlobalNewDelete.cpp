@@ -0,0 +1,201 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include "GlobalNewDelete.h"
+#include <atomic>
+
+namespace {
+	// The pool & its provider live in static storage & are never destroyed,
+	// objects of other static destructors may still be deleted after main returns
+	alignas(AppShift::Memory::RegionBlockProvider) char providerStorage[sizeof(AppShift::Memory::RegionBlockProvider)];
+	alignas(AppShift::Memory::ThreadSafeMemoryPool) char poolStorage[sizeof(AppShift::Memory::ThreadSafeMemoryPool)];
+	std::atomic<AppShift::Memory::RegionBlockProvider*> globalProvider(nullptr);
+
+	// State of the calling thread with the global pool
+	enum EThreadState : char {
+		THREAD_NEW,
+		THREAD_ACTIVE,
+		THREAD_EXITED
+	};
+	thread_local EThreadState threadState = THREAD_NEW;
+	// Set while the pool is working for the calling thread, allocations made meanwhile go to malloc
+	thread_local bool insidePool = false;
+
+	// Destroyed when the thread exits, before the thread slot of the pool is released
+	struct SThreadExitGuard {
+		~SThreadExitGuard() {
+			threadState = THREAD_EXITED;
+		}
+	};
+	thread_local SThreadExitGuard threadExitGuard;
+
+	void* poolAllocate(size_t size, size_t alignment) {
+		if (size > MEMORYPOOL_GLOBAL_MAX_SIZE || insidePool || threadState == THREAD_EXITED) return nullptr;
+
+		insidePool = true;
+		void* unit_pointer_start = nullptr;
+		try {
+			AppShift::Memory::ThreadSafeMemoryPool* pool = AppShift::Memory::getGlobalMemoryPool();
+			if (threadState == THREAD_NEW) {
+				// Take a slot before the exit guard is created, so the guard is destroyed first
+				pool->getShard()->enableFreeLists();
+				(void) &threadExitGuard;
+				threadState = THREAD_ACTIVE;
+			}
+			unit_pointer_start = pool->allocateAligned(size, alignment);
+		}
+		catch (AppShift::Memory::EMemoryErrors) {
+			unit_pointer_start = nullptr;
+		}
+		insidePool = false;
+
+		return unit_pointer_start;
+	}
+
+	void* allocate(size_t size, size_t alignment) {
+		void* unit_pointer_start = poolAllocate(size, alignment);
+		if (unit_pointer_start != nullptr) return unit_pointer_start;
+
+		// Fall back to malloc
+		if (alignment <= alignof(std::max_align_t)) return std::malloc(size == 0 ? 1 : size);
+		if (posix_memalign(&unit_pointer_start, alignment, size == 0 ? 1 : size) != 0) return nullptr;
+		return unit_pointer_start;
+	}
+
+	void* allocateOrThrow(size_t size, size_t alignment) {
+		void* unit_pointer_start = allocate(size, alignment);
+		if (unit_pointer_start == nullptr) throw std::bad_alloc();
+		return unit_pointer_start;
+	}
+
+	void deallocate(void* unit_pointer_start) {
+		if (unit_pointer_start == nullptr) return;
+		if (!AppShift::Memory::isGlobalMemoryPoolPointer(unit_pointer_start)) {
+			std::free(unit_pointer_start);
+			return;
+		}
+
+		// Threads without a shard of their own hand the unit to its owner
+		if (threadState != THREAD_ACTIVE || insidePool) {
+			AppShift::Memory::MemoryPool::freeRemote(unit_pointer_start);
+			return;
+		}
+
+		insidePool = true;
+		AppShift::Memory::getGlobalMemoryPool()->free(unit_pointer_start);
+		insidePool = false;
+	}
+}
+
+AppShift::Memory::ThreadSafeMemoryPool* AppShift::Memory::getGlobalMemoryPool()
+{
+	static ThreadSafeMemoryPool* pool = []() {
+		RegionBlockProvider* provider = new (providerStorage) RegionBlockProvider(MEMORYPOOL_GLOBAL_REGION_SIZE);
+		globalProvider.store(provider, std::memory_order_release);
+		return new (poolStorage) ThreadSafeMemoryPool(MEMORYPOOL_DEFAULT_BLOCK_SIZE, provider);
+	}();
+	return pool;
+}
+
+bool AppShift::Memory::isGlobalMemoryPoolPointer(const void* pointer)
+{
+	RegionBlockProvider* provider = globalProvider.load(std::memory_order_acquire);
+	return provider != nullptr && provider->contains(pointer);
+}
+
+void* operator new(size_t size) {
+	return allocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](size_t size) {
+	return allocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* unit_pointer_start) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete[](void* unit_pointer_start) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete(void* unit_pointer_start, size_t) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete[](void* unit_pointer_start, size_t) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete(void* unit_pointer_start, const std::nothrow_t&) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete[](void* unit_pointer_start, const std::nothrow_t&) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete(void* unit_pointer_start, std::align_val_t) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete[](void* unit_pointer_start, std::align_val_t) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete(void* unit_pointer_start, size_t, std::align_val_t) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete[](void* unit_pointer_start, size_t, std::align_val_t) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete(void* unit_pointer_start, std::align_val_t, const std::nothrow_t&) noexcept {
+	deallocate(unit_pointer_start);
+}
+
+void operator delete[](void* unit_pointer_start, std::align_val_t, const std::nothrow_t&) noexcept {
+	deallocate(unit_pointer_start);
+}
@@ -0,0 +1,52 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_GLOBAL_REGION_SIZE ((size_t) 64 * 1024 * 1024 * 1024)
+#define MEMORYPOOL_GLOBAL_MAX_SIZE 64 * 1024
+
+#include "ThreadSafeMemoryPool.h"
+#include "MMapBlockProvider.h"
+
+/**
+ * Linking GlobalNewDelete.cpp into a program replaces the global operator new & delete,
+ * so every allocation made with new in the program goes to a global thread safe memory pool.
+ *
+ * Allocations bigger than MEMORYPOOL_GLOBAL_MAX_SIZE, and allocations made while the pool
+ * itself is allocating, go to malloc. The pool blocks come from a single reserved region,
+ * which is how delete tells pool memory from malloc memory.
+ */
+namespace AppShift::Memory {
+	/**
+	 * Get the memory pool used by the global operator new, creating it if needed.
+	 * The pool is never destroyed, so objects can be deleted until the program exits.
+	 *
+	 * @returns ThreadSafeMemoryPool* The global memory pool
+	 */
+	ThreadSafeMemoryPool* getGlobalMemoryPool();
+
+	/**
+	 * Check if a pointer was allocated by the global memory pool
+	 *
+	 * @param const void* pointer Pointer to check
+	 *
+	 * @returns bool True if the pointer is inside the region of the global memory pool
+	 */
+	bool isGlobalMemoryPoolPointer(const void* pointer);
+}
@@ -0,0 +1,299 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include "InterProcessMemoryPool.h"
+#include <iostream>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+	// Round a size so the headers after it stay aligned
+	size_t roundSize(size_t size) {
+		return (size + alignof(AppShift::Memory::SSharedUnitHeader) - 1) & ~(alignof(AppShift::Memory::SSharedUnitHeader) - 1);
+	}
+}
+
+AppShift::Memory::InterProcessMemoryPool::InterProcessMemoryPool(const char* name, size_t size, size_t block_size)
+{
+	// Create the segment
+	int descriptor = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (descriptor < 0) throw EMemoryErrors::CANNOT_MAP_SHARED_MEMORY;
+	if (ftruncate(descriptor, size) != 0) {
+		close(descriptor);
+		shm_unlink(name);
+		throw EMemoryErrors::CANNOT_MAP_SHARED_MEMORY;
+	}
+	this->map(descriptor, size);
+	close(descriptor);
+
+	// Initialize pool data
+	this->header->segmentSize = size;
+	this->header->segmentOffset = roundSize(sizeof(SSharedPoolHeader));
+	this->header->firstBlock = this->header->currentBlock = 0;
+	this->header->freeBlocks = 0;
+	this->header->defaultBlockSize = block_size;
+	this->header->root = 0;
+
+	// The lock is shared by the processes, and is recovered when a process dies while holding it
+	pthread_mutexattr_t lock_attributes;
+	pthread_mutexattr_init(&lock_attributes);
+	pthread_mutexattr_setpshared(&lock_attributes, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust(&lock_attributes, PTHREAD_MUTEX_ROBUST);
+	pthread_mutex_init(&this->header->lock, &lock_attributes);
+	pthread_mutexattr_destroy(&lock_attributes);
+
+	this->createMemoryBlock(block_size);
+
+	// Processes can attach only once the pool is ready
+	this->header->version = MEMORYPOOL_SHARED_VERSION;
+	__atomic_store_n(&this->header->magic, MEMORYPOOL_SHARED_MAGIC, __ATOMIC_RELEASE);
+}
+
+AppShift::Memory::InterProcessMemoryPool::InterProcessMemoryPool(const char* name)
+{
+	int descriptor = shm_open(name, O_RDWR, 0600);
+	if (descriptor < 0) throw EMemoryErrors::CANNOT_MAP_SHARED_MEMORY;
+
+	struct stat segment_stat;
+	if (fstat(descriptor, &segment_stat) != 0 || (size_t) segment_stat.st_size < sizeof(SSharedPoolHeader)) {
+		close(descriptor);
+		throw EMemoryErrors::INVALID_SHARED_MEMORY;
+	}
+	this->map(descriptor, segment_stat.st_size);
+	close(descriptor);
+
+	if (__atomic_load_n(&this->header->magic, __ATOMIC_ACQUIRE) != MEMORYPOOL_SHARED_MAGIC || this->header->version != MEMORYPOOL_SHARED_VERSION) {
+		munmap(this->base, segment_stat.st_size);
+		throw EMemoryErrors::INVALID_SHARED_MEMORY;
+	}
+}
+
+AppShift::Memory::InterProcessMemoryPool::~InterProcessMemoryPool()
+{
+	munmap(this->base, this->header->segmentSize);
+}
+
+void AppShift::Memory::InterProcessMemoryPool::remove(const char* name)
+{
+	shm_unlink(name);
+}
+
+void AppShift::Memory::InterProcessMemoryPool::map(int descriptor, size_t size)
+{
+	void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	if (mapping == MAP_FAILED) {
+		close(descriptor);
+		throw EMemoryErrors::CANNOT_MAP_SHARED_MEMORY;
+	}
+
+	this->base = reinterpret_cast<char*>(mapping);
+	this->header = reinterpret_cast<SSharedPoolHeader*>(mapping);
+}
+
+void AppShift::Memory::InterProcessMemoryPool::lock()
+{
+	// Take over the lock of a process that died while holding it
+	if (pthread_mutex_lock(&this->header->lock) == EOWNERDEAD) pthread_mutex_consistent(&this->header->lock);
+}
+
+void AppShift::Memory::InterProcessMemoryPool::unlock()
+{
+	pthread_mutex_unlock(&this->header->lock);
+}
+
+AppShift::Memory::SSharedBlockHeader* AppShift::Memory::InterProcessMemoryPool::getBlock(size_t offset) const
+{
+	return reinterpret_cast<SSharedBlockHeader*>(this->base + offset);
+}
+
+void AppShift::Memory::InterProcessMemoryPool::createMemoryBlock(size_t block_size)
+{
+	// Take a freed block if one is big enough
+	size_t block_offset = 0;
+	for (size_t* free_block = &this->header->freeBlocks; *free_block != 0; free_block = &this->getBlock(*free_block)->next) {
+		if (this->getBlock(*free_block)->blockSize < block_size) continue;
+		block_offset = *free_block;
+		*free_block = this->getBlock(block_offset)->next;
+		break;
+	}
+
+	// Carve a new block from the segment
+	if (block_offset == 0) {
+		size_t total_size = roundSize(sizeof(SSharedBlockHeader) + block_size);
+		if (total_size > this->header->segmentSize - this->header->segmentOffset) throw EMemoryErrors::OUT_OF_POOL;
+		block_offset = this->header->segmentOffset;
+		this->header->segmentOffset += total_size;
+		this->getBlock(block_offset)->blockSize = block_size;
+	}
+
+	// Initalize block data
+	SSharedBlockHeader* block = this->getBlock(block_offset);
+	block->offset = 0;
+	block->numberOfAllocated = 0;
+	block->numberOfDeleted = 0;
+	block->next = 0;
+	block->prev = this->header->currentBlock;
+
+	if (this->header->firstBlock != 0) this->getBlock(this->header->currentBlock)->next = block_offset;
+	else this->header->firstBlock = block_offset;
+	this->header->currentBlock = block_offset;
+}
+
+void* AppShift::Memory::InterProcessMemoryPool::allocate(size_t size)
+{
+	size = roundSize(size);
+	this->lock();
+
+	// If there is enough space in current block then use the current block
+	SSharedBlockHeader* block = this->getBlock(this->header->currentBlock);
+	if (size + sizeof(SSharedUnitHeader) >= block->blockSize - block->offset) {
+		// Create new block if not enough space
+		try {
+			if (size + sizeof(SSharedUnitHeader) >= this->header->defaultBlockSize) this->createMemoryBlock(size + sizeof(SSharedUnitHeader));
+			else this->createMemoryBlock(this->header->defaultBlockSize);
+		}
+		catch (EMemoryErrors error) {
+			this->unlock();
+			throw error;
+		}
+		block = this->getBlock(this->header->currentBlock);
+	}
+
+	// Add unit
+	SSharedUnitHeader* unit = reinterpret_cast<SSharedUnitHeader*>(reinterpret_cast<char*>(block + 1) + block->offset);
+	unit->length = size;
+	unit->container = this->header->currentBlock;
+	block->numberOfAllocated++;
+	block->offset += sizeof(SSharedUnitHeader) + size;
+
+	this->unlock();
+	return unit + 1;
+}
+
+void* AppShift::Memory::InterProcessMemoryPool::reallocate(void* unit_pointer_start, size_t new_size)
+{
+	if (unit_pointer_start == nullptr) return nullptr;
+	new_size = roundSize(new_size);
+
+	// Find unit
+	SSharedUnitHeader* unit = reinterpret_cast<SSharedUnitHeader*>(unit_pointer_start) - 1;
+	this->lock();
+	SSharedBlockHeader* block = this->getBlock(unit->container);
+
+	// If last in block && enough space in block, then reset length
+	if (reinterpret_cast<char*>(block + 1) + block->offset == reinterpret_cast<char*>(unit + 1) + unit->length
+		&& block->blockSize > block->offset + new_size - unit->length) {
+		block->offset += new_size - unit->length;
+		unit->length = new_size;
+		this->unlock();
+		return unit_pointer_start;
+	}
+	this->unlock();
+
+	// Allocate new and free previous
+	void* temp_point = this->allocate(new_size);
+	std::memcpy(temp_point, unit_pointer_start, unit->length < new_size ? unit->length : new_size);
+	this->free(unit_pointer_start);
+
+	return temp_point;
+}
+
+void AppShift::Memory::InterProcessMemoryPool::free(void* unit_pointer_start)
+{
+	if (unit_pointer_start == nullptr) return;
+
+	// Find unit
+	SSharedUnitHeader* unit = reinterpret_cast<SSharedUnitHeader*>(unit_pointer_start) - 1;
+	this->lock();
+	size_t block_offset = unit->container;
+	SSharedBlockHeader* block = this->getBlock(block_offset);
+
+	// If last in block, then reset offset
+	if (reinterpret_cast<char*>(block + 1) + block->offset == reinterpret_cast<char*>(unit + 1) + unit->length) {
+		block->offset -= sizeof(SSharedUnitHeader) + unit->length;
+		block->numberOfAllocated--;
+	}
+	else {
+		unit->length |= MEMORYPOOL_UNIT_DELETED;
+		block->numberOfDeleted++;
+	}
+
+	// If block is empty move it to the free blocks if not the only one left
+	if (this->header->currentBlock != this->header->firstBlock && (block->offset == 0 || block->numberOfAllocated == block->numberOfDeleted)) {
+		if (block_offset == this->header->firstBlock) {
+			this->header->firstBlock = block->next;
+			this->getBlock(block->next)->prev = 0;
+		}
+		else if (block_offset == this->header->currentBlock) {
+			this->header->currentBlock = block->prev;
+			this->getBlock(block->prev)->next = 0;
+		}
+		else {
+			this->getBlock(block->prev)->next = block->next;
+			this->getBlock(block->next)->prev = block->prev;
+		}
+		block->next = this->header->freeBlocks;
+		this->header->freeBlocks = block_offset;
+	}
+
+	this->unlock();
+}
+
+size_t AppShift::Memory::InterProcessMemoryPool::toOffset(const void* pointer) const
+{
+	return pointer == nullptr ? 0 : reinterpret_cast<const char*>(pointer) - this->base;
+}
+
+void* AppShift::Memory::InterProcessMemoryPool::fromOffset(size_t offset) const
+{
+	return offset == 0 ? nullptr : this->base + offset;
+}
+
+void AppShift::Memory::InterProcessMemoryPool::setRoot(void* root)
+{
+	__atomic_store_n(&this->header->root, this->toOffset(root), __ATOMIC_RELEASE);
+}
+
+void* AppShift::Memory::InterProcessMemoryPool::getRoot() const
+{
+	return this->fromOffset(__atomic_load_n(&this->header->root, __ATOMIC_ACQUIRE));
+}
+
+void AppShift::Memory::InterProcessMemoryPool::dumpPoolData()
+{
+	this->lock();
+	size_t block_counter = 1;
+
+	for (size_t block_offset = this->header->firstBlock; block_offset != 0; block_offset = this->getBlock(block_offset)->next) {
+		SSharedBlockHeader* block = this->getBlock(block_offset);
+
+		// Dump block data
+		std::cout << "Block " << block_counter << " (offset " << block_offset << "): " << std::endl;
+		std::cout << "\t" << "Used: " << (float)(block->offset) / (float)(block->blockSize) * 100 << "% " << "(" << block->offset << "/" << block->blockSize << ")" << std::endl;
+		std::cout << "\t" << "Live units: " << block->numberOfAllocated - block->numberOfDeleted << ", Deleted units: " << block->numberOfDeleted << std::endl;
+		block_counter++;
+	}
+
+	std::cout << "Segment used: " << this->header->segmentOffset << "/" << this->header->segmentSize << std::endl;
+	this->unlock();
+}
@@ -0,0 +1,213 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_SHARED_MAGIC 0x4C4F4F5050494D41ULL
+#define MEMORYPOOL_SHARED_VERSION 1
+
+#include "MemoryPool.h"
+#include <pthread.h>
+
+namespace AppShift::Memory {
+	// Header of a block in a shared segment, blocks are linked by their offset in the segment
+	struct SSharedBlockHeader {
+		// Block data
+		size_t blockSize;
+		size_t offset;
+
+		// Movement to other blocks
+		size_t next;
+		size_t prev;
+
+		// Garbage management data
+		size_t numberOfAllocated;
+		size_t numberOfDeleted;
+	};
+
+	// Header of a unit in a shared segment, pointing to its block by offset
+	struct SSharedUnitHeader {
+		size_t length;
+		size_t container;
+	};
+
+	// Header at the start of a shared segment, holding the pool data
+	struct SSharedPoolHeader {
+		// Identification of the layout
+		uint64_t magic;
+		uint32_t version;
+
+		// Segment data, offset is where the next block is carved from
+		size_t segmentSize;
+		size_t segmentOffset;
+
+		// Data about the memory pool blocks, 0 when there is no block
+		size_t firstBlock;
+		size_t currentBlock;
+		size_t freeBlocks;
+		size_t defaultBlockSize;
+
+		// Object shared by the processes
+		size_t root;
+
+		// Lock shared by the processes using the pool
+		pthread_mutex_t lock;
+	};
+
+	/**
+	 * A memory pool in a named shared memory segment, which several processes can use together.
+	 * All the headers hold offsets in the segment instead of pointers, so every process can map it
+	 * at a different address - pointers between shared objects should be stored as offsets too.
+	 */
+	class InterProcessMemoryPool {
+	public:
+		/**
+		 * Creates a named shared memory segment & a memory pool in it
+		 *
+		 * @param const char* name Name of the shared memory segment, e.g. "/my_pool"
+		 * @param size_t size Size of the whole segment, the pool can't grow beyond it
+		 * @param size_t block_size Defines the default size of a block in the pool, by default uses MEMORYPOOL_DEFAULT_BLOCK_SIZE
+		 */
+		InterProcessMemoryPool(const char* name, size_t size, size_t block_size = MEMORYPOOL_DEFAULT_BLOCK_SIZE);
+
+		/**
+		 * Attaches to a memory pool created by another process
+		 *
+		 * @param const char* name Name of the shared memory segment
+		 */
+		InterProcessMemoryPool(const char* name);
+
+		// Unmaps the segment, the pool stays until removed
+		~InterProcessMemoryPool();
+
+		/**
+		 * Removes a named segment, processes which already attached to it keep using it
+		 *
+		 * @param const char* name Name of the shared memory segment
+		 */
+		static void remove(const char* name);
+
+		// Start of the segment in this process
+		char* base;
+		SSharedPoolHeader* header;
+
+		/**
+		 * Allocates memory in the pool
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocate(size_t size);
+
+		// Templated allocation
+		template<typename T>
+		T* allocate(size_t instances);
+
+		/**
+		 * Re-allocates memory in the pool
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to re-allocate
+		 * @param size_t new_size New size to allocate in memory pool
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* reallocate(void* unit_pointer_start, size_t new_size);
+
+		// Templated re-allocation
+		template<typename T>
+		T* reallocate(T* unit_pointer_start, size_t new_size);
+
+		/**
+		 * Frees memory in the pool, from any process
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to free
+		 */
+		void free(void* unit_pointer_start);
+
+		/**
+		 * Convert a pointer in the segment to an offset that is valid in every process
+		 *
+		 * @param const void* pointer Pointer in the segment, nullptr gives 0
+		 *
+		 * @returns size_t Offset of the pointer in the segment
+		 */
+		size_t toOffset(const void* pointer) const;
+
+		/**
+		 * Convert an offset in the segment to a pointer in this process
+		 *
+		 * @param size_t offset Offset in the segment, 0 gives nullptr
+		 *
+		 * @returns void* Pointer in this process
+		 */
+		void* fromOffset(size_t offset) const;
+
+		// Templated offset conversion
+		template<typename T>
+		T* fromOffset(size_t offset) const;
+
+		/**
+		 * Set the object shared by the processes, so attached processes can find it
+		 *
+		 * @param void* root Object allocated in the pool
+		 */
+		void setRoot(void* root);
+
+		/**
+		 * Get the object shared by the processes
+		 *
+		 * @returns void* Object set by setRoot, nullptr if none
+		 */
+		void* getRoot() const;
+
+		/**
+		 * Dump the data of the blocks in the pool to stream
+		 */
+		void dumpPoolData();
+
+	private:
+		// Map a shared memory segment of the given size
+		void map(int descriptor, size_t size);
+
+		// Lock the pool for the calling process
+		void lock();
+		void unlock();
+
+		// Create a new block of at least the given size and make it the current block
+		void createMemoryBlock(size_t block_size);
+
+		// Get the header of a block by its offset
+		SSharedBlockHeader* getBlock(size_t offset) const;
+	};
+
+	template<typename T>
+	inline T* InterProcessMemoryPool::allocate(size_t instances) {
+		return reinterpret_cast<T*>(this->allocate(instances * sizeof(T)));
+	}
+
+	template<typename T>
+	inline T* InterProcessMemoryPool::reallocate(T* unit_pointer_start, size_t instances) {
+		return reinterpret_cast<T*>(this->reallocate(reinterpret_cast<void*>(unit_pointer_start), instances * sizeof(T)));
+	}
+
+	template<typename T>
+	inline T* InterProcessMemoryPool::fromOffset(size_t offset) const {
+		return reinterpret_cast<T*>(this->fromOffset(offset));
+	}
+}
@@ -0,0 +1,227 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include "MMapBlockProvider.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MEMORYPOOL_HAS_MMAP
+#endif
+
+namespace {
+	// Round a size up to a multiple of a power of 2
+	size_t roundUp(size_t size, size_t multiple) {
+		return (size + multiple - 1) & ~(multiple - 1);
+	}
+
+	// Header of a freed block in a region, kept until a block of the same size is needed
+	struct SRegionFreeBlock {
+		SRegionFreeBlock* next;
+		size_t size;
+	};
+
+#ifdef MEMORYPOOL_HAS_MMAP
+	size_t getPageSize() {
+		static size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return page_size;
+	}
+
+	// Over-map & trim so the mapping starts at a multiple of the alignment, nullptr on failure
+	void* mapAligned(size_t size, size_t alignment, int flags) {
+		char* mapping = reinterpret_cast<char*>(mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE, flags, -1, 0));
+		if (mapping == MAP_FAILED) return nullptr;
+
+		char* block = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(mapping), alignment));
+		if (block != mapping) munmap(mapping, block - mapping);
+		munmap(block + size, mapping + alignment - block);
+		return block;
+	}
+#endif
+}
+
+AppShift::Memory::MMapBlockProvider::MMapBlockProvider(bool populate, bool huge_pages)
+{
+	this->populate = populate;
+	this->hugePages = huge_pages;
+}
+
+void* AppShift::Memory::MMapBlockProvider::allocateBlock(size_t size)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	return this->allocateAlignedBlock(size, getPageSize());
+#else
+	return std::malloc(size);
+#endif
+}
+
+void* AppShift::Memory::MMapBlockProvider::allocateAlignedBlock(size_t size, size_t alignment)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	if (this->hugePages && alignment < MEMORYPOOL_HUGE_PAGE_SIZE) alignment = MEMORYPOOL_HUGE_PAGE_SIZE;
+	size = roundUp(size, this->hugePages ? MEMORYPOOL_HUGE_PAGE_SIZE : getPageSize());
+
+	if (alignment <= getPageSize()) {
+#ifdef MAP_POPULATE
+		if (this->populate) flags |= MAP_POPULATE;
+#endif
+		void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+		return block == MAP_FAILED ? nullptr : block;
+	}
+
+	// Aligned blocks are populated after trimming, and after madvise so they are faulted in huge pages
+	char* block = reinterpret_cast<char*>(mapAligned(size, alignment, flags));
+	if (block == nullptr) return nullptr;
+
+#ifdef MADV_HUGEPAGE
+	if (this->hugePages) madvise(block, size, MADV_HUGEPAGE);
+#endif
+	if (this->populate) for (size_t i = 0; i < size; i += getPageSize()) block[i] = 0;
+
+	return block;
+#else
+	return MemoryBlockProvider::allocateAlignedBlock(size, alignment);
+#endif
+}
+
+void AppShift::Memory::MMapBlockProvider::freeBlock(void* block, size_t size)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	munmap(block, roundUp(size, this->hugePages ? MEMORYPOOL_HUGE_PAGE_SIZE : getPageSize()));
+#else
+	std::free(block);
+#endif
+}
+
+AppShift::Memory::HugeTLBBlockProvider::HugeTLBBlockProvider(bool fallback)
+{
+	this->fallback = fallback;
+}
+
+void* AppShift::Memory::HugeTLBBlockProvider::allocateBlock(size_t size)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	return this->allocateAlignedBlock(size, MEMORYPOOL_HUGE_PAGE_SIZE);
+#else
+	return this->fallback ? std::malloc(size) : nullptr;
+#endif
+}
+
+void* AppShift::Memory::HugeTLBBlockProvider::allocateAlignedBlock(size_t size, size_t alignment)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	size = roundUp(size, MEMORYPOOL_HUGE_PAGE_SIZE);
+	if (alignment < MEMORYPOOL_HUGE_PAGE_SIZE) alignment = MEMORYPOOL_HUGE_PAGE_SIZE;
+	void* block = nullptr;
+#ifdef MAP_HUGETLB
+	block = mapAligned(size, alignment, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB);
+#endif
+	if (block == nullptr && this->fallback) block = mapAligned(size, alignment, MAP_PRIVATE | MAP_ANONYMOUS);
+	return block;
+#else
+	return MemoryBlockProvider::allocateAlignedBlock(size, alignment);
+#endif
+}
+
+void AppShift::Memory::HugeTLBBlockProvider::freeBlock(void* block, size_t size)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	munmap(block, roundUp(size, MEMORYPOOL_HUGE_PAGE_SIZE));
+#else
+	std::free(block);
+#endif
+}
+
+AppShift::Memory::RegionBlockProvider::RegionBlockProvider(size_t size)
+{
+	this->regionStart = nullptr;
+	this->regionSize = 0;
+	this->regionOffset = 0;
+	this->freeBlocks = nullptr;
+
+#ifdef MEMORYPOOL_HAS_MMAP
+	// Reserve the address space only, pages get memory when touched
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+	flags |= MAP_NORESERVE;
+#endif
+	void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (region == MAP_FAILED) return;
+	this->regionStart = reinterpret_cast<char*>(region);
+	this->regionSize = size;
+#endif
+}
+
+AppShift::Memory::RegionBlockProvider::~RegionBlockProvider()
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	if (this->regionStart != nullptr) munmap(this->regionStart, this->regionSize);
+#endif
+}
+
+void* AppShift::Memory::RegionBlockProvider::allocateBlock(size_t size)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	return this->allocateAlignedBlock(size, getPageSize());
+#else
+	return nullptr;
+#endif
+}
+
+void* AppShift::Memory::RegionBlockProvider::allocateAlignedBlock(size_t size, size_t alignment)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	size = roundUp(size, getPageSize());
+	std::lock_guard<std::mutex> guard(this->lock);
+
+	// Reuse a freed block of the same size
+	for (SRegionFreeBlock** free_block = reinterpret_cast<SRegionFreeBlock**>(&this->freeBlocks); *free_block != nullptr; free_block = &(*free_block)->next) {
+		if ((*free_block)->size != size || reinterpret_cast<uintptr_t>(*free_block) % alignment != 0) continue;
+		SRegionFreeBlock* block = *free_block;
+		*free_block = block->next;
+		return block;
+	}
+
+	// Carve a new block, the skipped address space is never backed
+	size_t block_offset = roundUp(reinterpret_cast<uintptr_t>(this->regionStart) + this->regionOffset, alignment) - reinterpret_cast<uintptr_t>(this->regionStart);
+	if (block_offset > this->regionSize || size > this->regionSize - block_offset) return nullptr;
+	this->regionOffset = block_offset + size;
+	return this->regionStart + block_offset;
+#else
+	return nullptr;
+#endif
+}
+
+void AppShift::Memory::RegionBlockProvider::freeBlock(void* block, size_t size)
+{
+#ifdef MEMORYPOOL_HAS_MMAP
+	size = roundUp(size, getPageSize());
+
+	// Give the pages back to the OS but keep the address space
+	madvise(block, size, MADV_DONTNEED);
+
+	std::lock_guard<std::mutex> guard(this->lock);
+	SRegionFreeBlock* free_block = reinterpret_cast<SRegionFreeBlock*>(block);
+	free_block->size = size;
+	free_block->next = reinterpret_cast<SRegionFreeBlock*>(this->freeBlocks);
+	this->freeBlocks = free_block;
+#endif
+}
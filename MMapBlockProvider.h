@@ -0,0 +1,104 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_HUGE_PAGE_SIZE 2 * 1024 * 1024
+
+#include "MemoryPool.h"
+#include <mutex>
+
+namespace AppShift::Memory {
+	/**
+	 * Provides blocks mapped directly from the OS with mmap, for big pools.
+	 * Blocks can be pre-faulted when created, and backed by transparent huge pages.
+	 */
+	class MMapBlockProvider : public MemoryBlockProvider {
+	public:
+		/**
+		 * @param bool populate Fault all the pages of a block when it is created (MAP_POPULATE)
+		 * @param bool huge_pages Align blocks to huge pages & ask for transparent huge pages (MADV_HUGEPAGE)
+		 */
+		MMapBlockProvider(bool populate = false, bool huge_pages = false);
+
+		bool populate;
+		bool hugePages;
+
+		void* allocateBlock(size_t size) override;
+		void* allocateAlignedBlock(size_t size, size_t alignment) override;
+		void freeBlock(void* block, size_t size) override;
+	};
+
+	/**
+	 * Provides blocks from the reserved huge pages of the system (MAP_HUGETLB).
+	 * Block sizes are rounded up to MEMORYPOOL_HUGE_PAGE_SIZE.
+	 */
+	class HugeTLBBlockProvider : public MemoryBlockProvider {
+	public:
+		/**
+		 * @param bool fallback Map regular pages when no huge pages are left, instead of failing
+		 */
+		HugeTLBBlockProvider(bool fallback = true);
+
+		bool fallback;
+
+		void* allocateBlock(size_t size) override;
+		void* allocateAlignedBlock(size_t size, size_t alignment) override;
+		void freeBlock(void* block, size_t size) override;
+	};
+
+	/**
+	 * Provides blocks carved from a single range of reserved address space.
+	 * Pages are only backed once touched, and every block of the provider is
+	 * inside the range, so any pointer can be checked for coming from it.
+	 * Safe to share between threads.
+	 */
+	class RegionBlockProvider : public MemoryBlockProvider {
+	public:
+		/**
+		 * @param size_t size Size of the address space to reserve
+		 */
+		RegionBlockProvider(size_t size);
+		// Destructor, unmaps the whole region
+		~RegionBlockProvider();
+
+		// The reserved range, nullptr if it couldn't be reserved
+		char* regionStart;
+		size_t regionSize;
+		// Start of the part of the range not given to blocks yet
+		size_t regionOffset;
+		// Freed blocks, reused for blocks of the same size
+		void* freeBlocks;
+		std::mutex lock;
+
+		void* allocateBlock(size_t size) override;
+		void* allocateAlignedBlock(size_t size, size_t alignment) override;
+		void freeBlock(void* block, size_t size) override;
+
+		/**
+		 * Check if a pointer is inside the region of the provider
+		 *
+		 * @param const void* pointer Pointer to check
+		 *
+		 * @returns bool True if the pointer is in the region
+		 */
+		bool contains(const void* pointer) const {
+			return reinterpret_cast<const char*>(pointer) >= this->regionStart && reinterpret_cast<const char*>(pointer) < this->regionStart + this->regionSize;
+		}
+	};
+}
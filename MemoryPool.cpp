@@ -20,39 +20,107 @@
 
 #include "MemoryPool.h"
 #include <iostream>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
-AppShift::Memory::MemoryPool::MemoryPool(size_t block_size)
+void* AppShift::Memory::MemoryBlockProvider::allocateAlignedBlock(size_t size, size_t alignment)
+{
+	void* block = this->allocateBlock(size);
+	if (block == nullptr || reinterpret_cast<uintptr_t>(block) % alignment == 0) return block;
+
+	this->freeBlock(block, size);
+	return nullptr;
+}
+
+void* AppShift::Memory::MallocBlockProvider::allocateBlock(size_t size)
+{
+#ifdef _WIN32
+	// Aligned & plain blocks must be freed the same way
+	return _aligned_malloc(size, alignof(std::max_align_t));
+#else
+	return std::malloc(size);
+#endif
+}
+
+void* AppShift::Memory::MallocBlockProvider::allocateAlignedBlock(size_t size, size_t alignment)
+{
+	if (alignment <= alignof(std::max_align_t)) return this->allocateBlock(size);
+
+#ifdef _WIN32
+	return _aligned_malloc(size, alignment);
+#else
+	void* block = nullptr;
+	if (posix_memalign(&block, alignment, size) != 0) return nullptr;
+	return block;
+#endif
+}
+
+void AppShift::Memory::MallocBlockProvider::freeBlock(void* block, size_t)
+{
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	std::free(block);
+#endif
+}
+
+AppShift::Memory::MallocBlockProvider* AppShift::Memory::MallocBlockProvider::getDefault()
+{
+	static MallocBlockProvider provider;
+	return &provider;
+}
+
+AppShift::Memory::MemoryPool::MemoryPool(size_t block_size, MemoryBlockProvider* provider, size_t reservation)
 {
 	// Add first block to memory pool
 	this->firstBlock = this->currentBlock = nullptr;
 	this->defaultBlockSize = block_size;
+	this->nextBlockSize = this->maxBlockSize = block_size;
+	this->blockProvider = provider != nullptr ? provider : MallocBlockProvider::getDefault();
+	this->retainedBlocks = nullptr;
+	this->retainedBlocksCount = 0;
+	this->retainedBytes = 0;
+	this->maxRetainedBlocks = MEMORYPOOL_MAX_RETAINED_BLOCKS;
+	this->maxRetainedBytes = MEMORYPOOL_MAX_RETAINED_BYTES;
 	this->currentScope = nullptr;
+	this->useFreeLists = false;
+	for (size_t i = 0; i < MEMORYPOOL_FREELIST_BINS; i++) this->freeLists[i] = nullptr;
+	this->garbageCursor = nullptr;
+	for (size_t i = 0; i < MEMORYPOOL_SPACE_BINS; i++) this->spaceBins[i] = nullptr;
+	this->remoteFrees.store(nullptr, std::memory_order_relaxed);
+#ifndef MEMORYPOOL_DISABLE_STATS
+	this->stats = SMemoryPoolStats();
+#endif
+#ifdef MEMORYPOOL_TRACING
+	this->trace = nullptr;
+#endif
 	this->createMemoryBlock(block_size);
+	if (reservation != 0) this->reserve(reservation, true);
 }
 
 AppShift::Memory::MemoryPool::~MemoryPool() {
+#ifdef MEMORYPOOL_TRACING
+    this->stopTracing();
+#endif
     SMemoryBlockHeader* block_iterator = firstBlock;
 
     while (block_iterator != nullptr) {
         SMemoryBlockHeader* next_iterator = block_iterator->next;
-        std::free(block_iterator);
+        this->blockProvider->freeBlock(block_iterator, sizeof(SMemoryBlockHeader) + block_iterator->blockSize);
         block_iterator = next_iterator;
     }
+
+    this->trim();
 }
 
 void AppShift::Memory::MemoryPool::createMemoryBlock(size_t block_size)
 {
-	// Create the block
-	SMemoryBlockHeader* block = reinterpret_cast<SMemoryBlockHeader*>(std::malloc(sizeof(SMemoryBlockHeader) + block_size));
-	if (block == NULL) throw EMemoryErrors::CANNOT_CREATE_BLOCK;
-
-	// Initalize block data
-	block->blockSize = block_size;
-	block->offset = 0;
-	block->numberOfAllocated = 0;
-	block->numberOfDeleted = 0;
+	SMemoryBlockHeader* block = this->takeMemoryBlock(block_size);
 
 	if (this->firstBlock != nullptr) {
+		// The tail space of the previous block stays available through the index
+		this->indexBlock(this->currentBlock);
 		block->next = nullptr;
 		block->prev = this->currentBlock;
 		this->currentBlock->next = block;
@@ -65,87 +133,773 @@ void AppShift::Memory::MemoryPool::createMemoryBlock(size_t block_size)
 	}
 }
 
-void* AppShift::Memory::MemoryPool::allocate(size_t size)
+AppShift::Memory::SMemoryBlockHeader* AppShift::Memory::MemoryPool::takeMemoryBlock(size_t block_size)
+{
+	// Take a retained block if one is big enough
+	SMemoryBlockHeader* block = nullptr;
+	for (SMemoryBlockHeader** retained = &this->retainedBlocks; *retained != nullptr; retained = &(*retained)->next) {
+		if ((*retained)->blockSize < block_size) continue;
+		block = *retained;
+		*retained = block->next;
+		this->retainedBlocksCount--;
+		this->retainedBytes -= sizeof(SMemoryBlockHeader) + block->blockSize;
+		break;
+	}
+
+	// Create the block
+	if (block == nullptr) block = this->allocateMemoryBlock(block_size);
+
+	// Initalize block data
+	block->offset = 0;
+	block->numberOfAllocated = 0;
+	block->numberOfDeleted = 0;
+	block->pool = this;
+	block->spaceBin = SIZE_MAX;
+	return block;
+}
+
+AppShift::Memory::SMemoryBlockHeader* AppShift::Memory::MemoryPool::allocateMemoryBlock(size_t block_size)
+{
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+	SMemoryBlockHeader* block = reinterpret_cast<SMemoryBlockHeader*>(this->blockProvider->allocateAlignedBlock(sizeof(SMemoryBlockHeader) + block_size, MEMORYPOOL_BLOCK_ALIGNMENT));
+#else
+	SMemoryBlockHeader* block = reinterpret_cast<SMemoryBlockHeader*>(this->blockProvider->allocateBlock(sizeof(SMemoryBlockHeader) + block_size));
+#endif
+	if (block == NULL) throw EMemoryErrors::CANNOT_CREATE_BLOCK;
+	block->blockSize = block_size;
+	this->addReservedBytes(sizeof(SMemoryBlockHeader) + block_size);
+	return block;
+}
+
+void AppShift::Memory::MemoryPool::reserve(size_t bytes, bool prefault)
+{
+	// The space left in the current block & the kept blocks count toward the reservation
+	size_t available = getTailSpace(this->currentBlock);
+	if (prefault) prefaultBlock(this->currentBlock, this->currentBlock->offset);
+	for (SMemoryBlockHeader* block = this->retainedBlocks; block != nullptr; block = block->next) {
+		available += block->blockSize;
+		if (prefault) prefaultBlock(block, 0);
+	}
+
+	if (available < bytes) this->preallocateBlocks((bytes - available + this->nextBlockSize - 1) / this->nextBlockSize, prefault);
+}
+
+void AppShift::Memory::MemoryPool::preallocateBlocks(size_t count, bool prefault)
+{
+	// Kept blocks are taken from the front, so the blocks are used in the order they were created
+	SMemoryBlockHeader** last = &this->retainedBlocks;
+	while (*last != nullptr) last = &(*last)->next;
+
+	for (size_t i = 0; i < count; i++) {
+		SMemoryBlockHeader* block = this->allocateMemoryBlock(this->nextBlockSize);
+		if (prefault) prefaultBlock(block, 0);
+		block->next = nullptr;
+		*last = block;
+		last = &block->next;
+		this->retainedBlocksCount++;
+		this->retainedBytes += sizeof(SMemoryBlockHeader) + block->blockSize;
+	}
+}
+
+void AppShift::Memory::MemoryPool::prefaultBlock(SMemoryBlockHeader* block, size_t offset)
+{
+	char* data = reinterpret_cast<char*>(block + 1);
+	for (size_t i = offset; i < block->blockSize; i += MEMORYPOOL_PAGE_SIZE) data[i] = 0;
+}
+
+void AppShift::Memory::MemoryPool::createNextBlock(size_t min_size)
+{
+	// A block filled mostly with live units doubles the size of the next blocks, one filled mostly with deleted units halves it
+	if (this->currentBlock->numberOfDeleted * 2 < this->currentBlock->numberOfAllocated)
+		this->nextBlockSize = this->nextBlockSize > this->maxBlockSize / 2 ? this->maxBlockSize : this->nextBlockSize * 2;
+	else if (this->nextBlockSize > this->defaultBlockSize) {
+		this->nextBlockSize = this->nextBlockSize / 2 > this->defaultBlockSize ? this->nextBlockSize / 2 : this->defaultBlockSize;
+
+		// Taking a retained block much bigger than needed would spread the allocations over all of it
+		this->trimRetainedBlocks(2 * this->nextBlockSize);
+	}
+
+	this->createMemoryBlock(min_size > this->nextBlockSize ? min_size : this->nextBlockSize);
+}
+
+bool AppShift::Memory::MemoryPool::needsDedicatedBlock(size_t size) const
+{
+	if (size < this->nextBlockSize) return false;
+
+	// Blocks in a scope must stay after its first block to be freed when it ends
+	return this->currentScope == nullptr || this->currentBlock != this->currentScope->firstScopeBlock;
+}
+
+AppShift::Memory::SMemoryBlockHeader* AppShift::Memory::MemoryPool::createDedicatedBlock(size_t block_size)
+{
+	SMemoryBlockHeader* block = this->takeMemoryBlock(block_size);
+	block->next = this->currentBlock;
+	block->prev = this->currentBlock->prev;
+	if (block->prev != nullptr) block->prev->next = block;
+	else this->firstBlock = block;
+	this->currentBlock->prev = block;
+	return block;
+}
+
+void* AppShift::Memory::MemoryPool::placeDedicatedUnit(SMemoryBlockHeader* block, size_t size)
+{
+	// The block is indexed by the space left after its unit
+	void* unit_pointer_start = this->placeUnit(block, size);
+	this->indexBlock(block);
+	return unit_pointer_start;
+}
+
+void AppShift::Memory::MemoryPool::enableAdaptiveBlockSize(size_t max_block_size)
+{
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+	// Only the first aligned window of a block holds units
+	if (max_block_size > MEMORYPOOL_BLOCK_ALIGNMENT - sizeof(SMemoryBlockHeader)) max_block_size = MEMORYPOOL_BLOCK_ALIGNMENT - sizeof(SMemoryBlockHeader);
+#endif
+	this->maxBlockSize = max_block_size > this->defaultBlockSize ? max_block_size : this->defaultBlockSize;
+	if (this->nextBlockSize > this->maxBlockSize) this->nextBlockSize = this->maxBlockSize;
+}
+
+void* AppShift::Memory::MemoryPool::allocateSlow(size_t size)
+{
+	// Units freed by other threads might make room
+	if (this->remoteFrees.load(std::memory_order_relaxed) != nullptr) this->collectRemoteFrees();
+
+	// Reuse a deleted unit of the same size class if there is one
+	if (this->useFreeLists) {
+		if (this->currentScope == nullptr) {
+			void* unit_pointer_start = this->popFreeUnit(size);
+			if (unit_pointer_start != nullptr) return unit_pointer_start;
+		}
+	}
+
+	return this->bumpAllocate(size);
+}
+
+void* AppShift::Memory::MemoryPool::allocateAligned(size_t size, size_t alignment)
+{
+#ifdef MEMORYPOOL_TRACING
+	if (this->trace != nullptr && this->trace->depth == 0) return this->tracedAllocate(size, alignment);
+#endif
+
+	// Every unit is aligned to its header
+	if (alignment <= alignof(SMemoryUnitHeader)) return this->allocate(size);
+	if (alignment & (alignment - 1)) throw EMemoryErrors::INVALID_ALIGNMENT;
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+	// The unit after the padding must still start inside the first aligned window of the block
+	if (alignment > MEMORYPOOL_BLOCK_ALIGNMENT / 4) throw EMemoryErrors::INVALID_ALIGNMENT;
+#endif
+	this->recordAllocation(size);
+	size = this->roundUnitSize(size);
+
+	// Find a block with enough space for the unit & the padding before it
+	SMemoryBlockHeader* block = this->currentBlock;
+	size_t padding = getAlignmentPadding(block, alignment);
+	if (!this->fitsCurrentBlock(size + padding) && this->remoteFrees.load(std::memory_order_relaxed) != nullptr) {
+		this->collectRemoteFrees();
+		block = this->currentBlock;
+		padding = getAlignmentPadding(block, alignment);
+	}
+	if (!this->fitsCurrentBlock(size + padding)) {
+		size_t worst_case = size + 2 * sizeof(SMemoryUnitHeader) + alignment;
+		if (this->needsDedicatedBlock(worst_case)) block = this->createDedicatedBlock(worst_case);
+		else {
+			if (!this->useBlockWithSpace(worst_case)) this->createNextBlock(worst_case);
+			block = this->currentBlock;
+		}
+		padding = getAlignmentPadding(block, alignment);
+	}
+
+	// Fill the padding with a deleted unit
+	if (padding != 0) {
+		SMemoryUnitHeader* padding_unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + block->offset);
+		padding_unit->length = (padding - sizeof(SMemoryUnitHeader)) | MEMORYPOOL_UNIT_DELETED;
+		setContainer(padding_unit, block);
+		block->numberOfAllocated++;
+		block->numberOfDeleted++;
+		block->offset += padding;
+		if (this->useFreeLists) this->pushFreeUnit(padding_unit);
+	}
+
+	if (block != this->currentBlock) return this->placeDedicatedUnit(block, size);
+	return this->placeUnit(block, size);
+}
+
+void AppShift::Memory::MemoryPool::allocateBatch(size_t count, size_t size, void** out)
+{
+#ifdef MEMORYPOOL_TRACING
+	// Every unit is recorded on its own
+	if (this->trace != nullptr && this->trace->depth == 0) {
+		for (size_t i = 0; i < count; i++) out[i] = this->allocate(size);
+		return;
+	}
+#endif
+	this->recordAllocation(size, count);
+	size = this->roundUnitSize(size);
+	size_t unit_size = sizeof(SMemoryUnitHeader) + size;
+	size_t allocated = 0;
+
+	// Reuse deleted units of the same size class first
+	if (this->useFreeLists && this->currentScope == nullptr) {
+		while (allocated < count) {
+			void* unit_pointer_start = this->popFreeUnit(size);
+			if (unit_pointer_start == nullptr) break;
+			out[allocated++] = unit_pointer_start;
+		}
+	}
+
+	while (allocated < count) {
+		// Create a block for all the units left when none fits the current block
+		size_t fitting = this->getFittingUnits(unit_size);
+		if (fitting == 0 && this->useBlockWithSpace(unit_size)) fitting = this->getFittingUnits(unit_size);
+		if (fitting == 0) {
+			size_t needed = (count - allocated) * unit_size;
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+			// Units only start in the first aligned window of a block, the rest of a bigger block would stay empty
+			size_t window_size = MEMORYPOOL_BLOCK_ALIGNMENT - sizeof(SMemoryBlockHeader);
+			if (needed > window_size) needed = window_size > unit_size ? window_size : unit_size;
+#endif
+			this->createNextBlock(needed);
+
+			// Units may fill a new block to its end, like a unit bigger than the default block size
+			fitting = this->currentBlock->blockSize / unit_size;
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+			size_t window = this->getFittingUnits(unit_size);
+			fitting = window == 0 ? 1 : window < fitting ? window : fitting;
+#endif
+		}
+		if (fitting > count - allocated) fitting = count - allocated;
+
+		// Write the headers of all the units fitting the block
+		char* unit_start = reinterpret_cast<char*>(this->currentBlock + 1) + this->currentBlock->offset;
+		for (size_t i = 0; i < fitting; i++) {
+			SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(unit_start + i * unit_size);
+			unit->length = size;
+			setContainer(unit, this->currentBlock);
+			out[allocated + i] = unit + 1;
+		}
+		this->currentBlock->numberOfAllocated += fitting;
+		this->currentBlock->offset += fitting * unit_size;
+		this->addUsedBytes(fitting * unit_size);
+		allocated += fitting;
+	}
+}
+
+size_t AppShift::Memory::MemoryPool::getFittingUnits(size_t unit_size) const
+{
+	// Same condition as fitsCurrentBlock for the last unit
+	size_t space = this->currentBlock->blockSize - this->currentBlock->offset;
+	size_t fitting = space > unit_size ? (space - 1) / unit_size : 0;
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+	// Units must start inside the first aligned window of their block
+	size_t start = sizeof(SMemoryBlockHeader) + this->currentBlock->offset;
+	size_t window = start < MEMORYPOOL_BLOCK_ALIGNMENT ? (MEMORYPOOL_BLOCK_ALIGNMENT - start + unit_size - 1) / unit_size : 0;
+	if (window < fitting) fitting = window;
+#endif
+	return fitting;
+}
+
+size_t AppShift::Memory::MemoryPool::getAlignmentPadding(SMemoryBlockHeader* block, size_t alignment)
+{
+	// Distance of the next unit data from the alignment
+	uintptr_t unit_data = reinterpret_cast<uintptr_t>(block + 1) + block->offset + sizeof(SMemoryUnitHeader);
+	size_t padding = (alignment - unit_data % alignment) % alignment;
+
+	// A padding unit needs room for its own header
+	if (padding != 0 && padding < sizeof(SMemoryUnitHeader)) padding += alignment;
+	return padding;
+}
+
+void* AppShift::Memory::MemoryPool::bumpAllocate(size_t size)
 {
 	// If there is enough space in current block then use the current block
-	if (size + sizeof(SMemoryUnitHeader) < this->currentBlock->blockSize - this->currentBlock->offset);
+	if (this->fitsCurrentBlock(size));
+	// Units bigger than a block get a block of their own
+	else if (this->needsDedicatedBlock(size + sizeof(SMemoryUnitHeader))) return this->placeDedicatedUnit(this->createDedicatedBlock(size + sizeof(SMemoryUnitHeader)), size);
+	// Otherwise an older block with enough space
+	else if (this->useBlockWithSpace(size + sizeof(SMemoryUnitHeader)));
 	// Create new block if not enough space
-	else if (size + sizeof(SMemoryUnitHeader) >= this->defaultBlockSize) this->createMemoryBlock(size + sizeof(SMemoryUnitHeader));
-	else this->createMemoryBlock(this->defaultBlockSize);
-
-	// Add unit
-	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(this->currentBlock) + sizeof(SMemoryBlockHeader) + this->currentBlock->offset);
-	unit->length = size;
-	unit->container = this->currentBlock;
-	this->currentBlock->numberOfAllocated++;
-	this->currentBlock->offset += sizeof(SMemoryUnitHeader) + size;
+	else this->createNextBlock(size + sizeof(SMemoryUnitHeader));
 
-	return reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader);
+	return this->placeUnit(this->currentBlock, size);
 }
 
-void* AppShift::Memory::MemoryPool::reallocate(void* unit_pointer_start, size_t new_size)
+void* AppShift::Memory::MemoryPool::reallocateSlow(void* unit_pointer_start, size_t new_size, size_t alignment)
 {
-	if (unit_pointer_start == NULL) return nullptr;
+	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
+
+	// Grow over the deleted units that follow
+	if (this->resizeInPlace(unit, getContainer(unit), new_size)) return unit_pointer_start;
+
+	// Allocate new and free previous
+	void* temp_point = this->allocateAligned(new_size, alignment);
+	std::memcpy(temp_point, unit_pointer_start, unit->length < new_size ? unit->length : new_size);
+	this->free(unit_pointer_start);
 
-	// Find unit
+	return temp_point;
+}
+
+bool AppShift::Memory::MemoryPool::tryExpand(void* unit_pointer_start, size_t new_size)
+{
+	if (unit_pointer_start == nullptr) return false;
 	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
-	SMemoryBlockHeader* block = unit->container;
+	if (!this->resizeInPlace(unit, getContainer(unit), this->roundUnitSize(new_size))) return false;
 
-	// If last in block && enough space in block, then reset length
-	if (reinterpret_cast<char*>(block) + sizeof(SMemoryBlockHeader) + block->offset == reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader) + unit->length
-		&& block->blockSize > block->offset + new_size - unit->length) {
+#ifdef MEMORYPOOL_TRACING
+	if (this->trace != nullptr && this->trace->depth == 0) this->trace->record(ETraceEvent::REALLOCATE, unit_pointer_start, new_size, 0, unit_pointer_start);
+#endif
+	return true;
+}
+
+bool AppShift::Memory::MemoryPool::resizeInPlace(SMemoryUnitHeader* unit, SMemoryBlockHeader* block, size_t new_size)
+{
+	char* block_end = reinterpret_cast<char*>(block + 1) + block->offset;
+	char* unit_end = reinterpret_cast<char*>(unit + 1) + unit->length;
+
+	// The last unit moves the offset of its block
+	if (unit_end == block_end) {
+		if (new_size > unit->length && block->blockSize - block->offset < new_size - unit->length) return false;
 		block->offset += new_size - unit->length;
+		if (new_size > unit->length) this->addUsedBytes(new_size - unit->length);
+		else this->removeUsedBytes(unit->length - new_size);
 		unit->length = new_size;
+		this->updateBlockSpace(block);
+		return true;
+	}
+
+	if (new_size > unit->length) {
+		// Check the deleted units that follow hold enough space before merging them
+		size_t length = unit->length;
+		char* next_unit = unit_end;
+		while (length < new_size && next_unit != block_end) {
+			SMemoryUnitHeader* next = reinterpret_cast<SMemoryUnitHeader*>(next_unit);
+			if (!(next->length & MEMORYPOOL_UNIT_DELETED)) break;
+			length += sizeof(SMemoryUnitHeader) + (next->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+			next_unit += sizeof(SMemoryUnitHeader) + (next->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+		}
+		bool reaches_end = next_unit == block_end && block->blockSize - block->offset >= new_size - length;
+		if (length < new_size && !reaches_end) return false;
+
+		// Merge the deleted units into the unit
+		while (unit_end != next_unit) {
+			SMemoryUnitHeader* next = reinterpret_cast<SMemoryUnitHeader*>(unit_end);
+			if (next->length & MEMORYPOOL_UNIT_LISTED) this->unlinkFreeUnit(next);
+			size_t merged = sizeof(SMemoryUnitHeader) + (next->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+			unit->length += merged;
+			unit_end += merged;
+			block->numberOfAllocated--;
+			block->numberOfDeleted--;
+			this->addUsedBytes(merged);
+		}
+		this->markScopeCounters(block);
+
+		// The unit became the last one, the rest is taken from the block
+		if (unit->length < new_size) {
+			block->offset += new_size - unit->length;
+			this->addUsedBytes(new_size - unit->length);
+			unit->length = new_size;
+			this->updateBlockSpace(block);
+			return true;
+		}
+	}
+
+	// Give the space after the new size back as a deleted unit, if it can hold one
+	size_t rest_size = unit->length - new_size;
+	if (rest_size < sizeof(SMemoryUnitHeader) + MEMORYPOOL_FREELIST_GRANULARITY) return true;
+	SMemoryUnitHeader* rest = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit + 1) + new_size);
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+	// Units must start inside the first aligned window of their block
+	if (reinterpret_cast<char*>(rest) - reinterpret_cast<char*>(block) >= (ptrdiff_t) MEMORYPOOL_BLOCK_ALIGNMENT) return true;
+#endif
+	unit->length = new_size;
+	rest->length = (rest_size - sizeof(SMemoryUnitHeader)) | MEMORYPOOL_UNIT_DELETED;
+	setContainer(rest, block);
+	block->numberOfAllocated++;
+	block->numberOfDeleted++;
+	this->removeUsedBytes(rest_size);
+	this->markScopeCounters(block);
+	if (this->useFreeLists) this->pushFreeUnit(rest);
+	return true;
+}
+
+void AppShift::Memory::MemoryPool::indexBlock(SMemoryBlockHeader* block)
+{
+	block->spaceBin = getSpaceBin(getTailSpace(block));
+	block->prevSpaceBlock = nullptr;
+	block->nextSpaceBlock = this->spaceBins[block->spaceBin];
+	if (block->nextSpaceBlock != nullptr) block->nextSpaceBlock->prevSpaceBlock = block;
+	this->spaceBins[block->spaceBin] = block;
+}
+
+void AppShift::Memory::MemoryPool::unindexBlock(SMemoryBlockHeader* block)
+{
+	if (block->spaceBin == SIZE_MAX) return;
+	if (block->prevSpaceBlock != nullptr) block->prevSpaceBlock->nextSpaceBlock = block->nextSpaceBlock;
+	else this->spaceBins[block->spaceBin] = block->nextSpaceBlock;
+	if (block->nextSpaceBlock != nullptr) block->nextSpaceBlock->prevSpaceBlock = block->prevSpaceBlock;
+	block->spaceBin = SIZE_MAX;
+}
 
-		return unit_pointer_start;
+bool AppShift::Memory::MemoryPool::useBlockWithSpace(size_t space)
+{
+	// Blocks before a scope must stay before it, so they are not moved while a scope is open
+	if (this->currentScope != nullptr) return false;
+
+	// Blocks of the bins above the bin of the space have enough, the first of its own bin might.
+	// The space is checked again for all of them, a block is never used past its end
+	SMemoryBlockHeader* block = nullptr;
+	for (size_t bin = getSpaceBin(space); block == nullptr && bin < MEMORYPOOL_SPACE_BINS; bin++)
+		if (this->spaceBins[bin] != nullptr && getTailSpace(this->spaceBins[bin]) > space) block = this->spaceBins[bin];
+	if (block == nullptr) return false;
+	this->unindexBlock(block);
+
+	// A block with no live units left starts over
+	if (block->numberOfAllocated == block->numberOfDeleted) {
+		if (block->numberOfDeleted != 0) this->unlinkFreeUnits(block, 0);
+		block->offset = 0;
+		block->numberOfAllocated = block->numberOfDeleted = 0;
 	}
 
-	// Allocate new and free previous
-	void* temp_point = this->allocate(new_size);
-	std::memcpy(temp_point, unit_pointer_start, unit->length);
-	this->free(unit_pointer_start);
+	// Move the block to the end of the chain, the allocations continue in it
+	if (this->garbageCursor == block) this->garbageCursor = block->next;
+	if (block == this->firstBlock) this->firstBlock = block->next;
+	else block->prev->next = block->next;
+	block->next->prev = block->prev;
 
-	return temp_point;
+	this->indexBlock(this->currentBlock);
+	block->prev = this->currentBlock;
+	block->next = nullptr;
+	this->currentBlock->next = block;
+	this->currentBlock = block;
+	return true;
+}
+
+void AppShift::Memory::MemoryPool::markScopeCounters(SMemoryBlockHeader* block)
+{
+	for (SMemoryScopeHeader* scope = this->currentScope; scope != nullptr; scope = scope->prevScope)
+		if (scope->firstScopeBlock == block) scope->numberOfDeleted = SIZE_MAX;
 }
 
-void AppShift::Memory::MemoryPool::free(void* unit_pointer_start)
+void AppShift::Memory::MemoryPool::freeSlow(SMemoryUnitHeader* unit, SMemoryBlockHeader* block)
+{
+	unit->length |= MEMORYPOOL_UNIT_DELETED;
+	block->numberOfDeleted++;
+
+	// Remove block if all its units are deleted & it is not the only one left
+	if (this->currentBlock != this->firstBlock && block->numberOfAllocated == block->numberOfDeleted)
+		this->releaseMemoryBlock(block);
+	// Keep deleted unit for reuse
+	else if (this->useFreeLists) this->pushFreeUnit(unit);
+}
+
+void AppShift::Memory::MemoryPool::freeRemote(void* unit_pointer_start)
 {
 	if (unit_pointer_start == nullptr) return;
+	getContainer(reinterpret_cast<SMemoryUnitHeader*>(unit_pointer_start) - 1)->pool->pushRemoteFree(unit_pointer_start);
+}
 
-	// Find unit
-	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
-	SMemoryBlockHeader* block = unit->container;
+void AppShift::Memory::MemoryPool::pushRemoteFree(void* unit_pointer_start)
+{
+	// Only the owner takes units out, & it takes the whole queue at once, so pushing only retries when another push got in first
+	void* next_unit = this->remoteFrees.load(std::memory_order_relaxed);
+	do *reinterpret_cast<void**>(unit_pointer_start) = next_unit;
+	while (!this->remoteFrees.compare_exchange_weak(next_unit, unit_pointer_start, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void AppShift::Memory::MemoryPool::collectRemoteFrees()
+{
+	if (this->remoteFrees.load(std::memory_order_relaxed) == nullptr) return;
 
-	// If last in block, then reset offset
-	if (reinterpret_cast<char*>(block) + sizeof(SMemoryBlockHeader) + block->offset == reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader) + unit->length) {
-		block->offset -= sizeof(SMemoryUnitHeader) + unit->length;
-		block->numberOfAllocated--;
+	void* unit_pointer_start = this->remoteFrees.exchange(nullptr, std::memory_order_acquire);
+	while (unit_pointer_start != nullptr) {
+		void* next_unit = *reinterpret_cast<void**>(unit_pointer_start);
+		this->free(unit_pointer_start);
+#ifdef MEMORYPOOL_TRACING
+		// Collected inside a traced call, so the free is not recorded by itself
+		if (this->trace != nullptr && this->trace->depth != 0) this->trace->record(ETraceEvent::FREE, unit_pointer_start);
+#endif
+		unit_pointer_start = next_unit;
 	}
-	else block->numberOfDeleted++;
+}
 
-	// If block offset is 0 remove block if not the only one left
-	if (this->currentBlock != this->firstBlock && (block->offset == 0 || block->numberOfAllocated == block->numberOfDeleted)) {
-		if (block == this->firstBlock) {
-			this->firstBlock = block->next;
-			this->firstBlock->prev = nullptr;
+void AppShift::Memory::MemoryPool::freeBatch(void** ptrs, size_t count)
+{
+#ifdef MEMORYPOOL_TRACING
+	// Every unit is recorded on its own
+	if (this->trace != nullptr && this->trace->depth == 0) {
+		for (size_t i = 0; i < count; i++) this->free(ptrs[i]);
+		return;
+	}
+#endif
+	size_t run_start = 0;
+	while (run_start < count) {
+		if (ptrs[run_start] == nullptr) {
+			run_start++;
+			continue;
 		}
-		else if (block == this->currentBlock) {
-			this->currentBlock = block->prev;
-			this->currentBlock->next = nullptr;
+
+		// Free the run of units of the same block, the last unit of the block moves its offset back
+		SMemoryBlockHeader* block = getContainer(reinterpret_cast<SMemoryUnitHeader*>(ptrs[run_start]) - 1);
+		size_t run_end = run_start;
+		size_t units = 0, deleted_units = 0, bytes = 0;
+		for (; run_end < count; run_end++) {
+			if (ptrs[run_end] == nullptr) continue;
+			SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(ptrs[run_end]) - 1;
+			if (getContainer(unit) != block) break;
+
+			units++;
+			bytes += sizeof(SMemoryUnitHeader) + unit->length;
+			if (isLastUnit(block, unit)) {
+				block->offset -= sizeof(SMemoryUnitHeader) + unit->length;
+				block->numberOfAllocated--;
+			}
+			else {
+				unit->length |= MEMORYPOOL_UNIT_DELETED;
+				deleted_units++;
+			}
+		}
+		block->numberOfDeleted += deleted_units;
+		this->recordFree(bytes, units);
+
+		// Remove the block if all its units are deleted, the only block left is emptied instead
+		if (block->numberOfAllocated == block->numberOfDeleted) {
+			if (this->currentBlock != this->firstBlock) this->releaseMemoryBlock(block);
+			else {
+				if (block->numberOfDeleted != 0) this->unlinkFreeUnits(block, 0);
+				block->offset = 0;
+				block->numberOfAllocated = block->numberOfDeleted = 0;
+			}
 		}
 		else {
-			block->prev->next = block->next;
-			block->next->prev = block->prev;
+			this->updateBlockSpace(block);
+
+			// Keep the deleted units for reuse
+			if (this->useFreeLists && deleted_units != 0) {
+				for (size_t i = run_start; i < run_end; i++) {
+					if (ptrs[i] == nullptr) continue;
+					SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(ptrs[i]) - 1;
+					if ((unit->length & MEMORYPOOL_UNIT_DELETED) && !(unit->length & MEMORYPOOL_UNIT_LISTED)) this->pushFreeUnit(unit);
+				}
+			}
+		}
+
+		run_start = run_end;
+	}
+}
+
+void AppShift::Memory::MemoryPool::releaseMemoryBlock(SMemoryBlockHeader* block)
+{
+	// Deleted units of the block can't stay in the free lists
+	if (block->numberOfDeleted != 0) this->unlinkFreeUnits(block, 0);
+	if (this->garbageCursor == block) this->garbageCursor = block->next;
+	this->unindexBlock(block);
+
+	if (block == this->firstBlock) {
+		this->firstBlock = block->next;
+		this->firstBlock->prev = nullptr;
+	}
+	else if (block == this->currentBlock) {
+		this->currentBlock = block->prev;
+		this->currentBlock->next = nullptr;
+		this->unindexBlock(this->currentBlock);
+	}
+	else {
+		block->prev->next = block->next;
+		block->next->prev = block->prev;
+	}
+	this->freeMemoryBlock(block);
+}
+
+void AppShift::Memory::MemoryPool::freeMemoryBlock(SMemoryBlockHeader* block)
+{
+	// Blocks bigger than the next block size, like dedicated blocks, would hold memory a regular block doesn't need
+	size_t block_bytes = sizeof(SMemoryBlockHeader) + block->blockSize;
+	if (block->blockSize > this->nextBlockSize || this->retainedBlocksCount >= this->maxRetainedBlocks || this->maxRetainedBytes - this->retainedBytes < block_bytes) {
+		this->blockProvider->freeBlock(block, block_bytes);
+		this->removeReservedBytes(block_bytes);
+		return;
+	}
+
+	block->next = this->retainedBlocks;
+	this->retainedBlocks = block;
+	this->retainedBlocksCount++;
+	this->retainedBytes += block_bytes;
+}
+
+void AppShift::Memory::MemoryPool::setBlockRetention(size_t max_blocks, size_t max_bytes)
+{
+	this->maxRetainedBlocks = max_blocks;
+	this->maxRetainedBytes = max_bytes;
+
+	// Free the blocks over the new limits
+	while (this->retainedBlocks != nullptr && (this->retainedBlocksCount > max_blocks || this->retainedBytes > max_bytes)) {
+		SMemoryBlockHeader* block = this->retainedBlocks;
+		this->retainedBlocks = block->next;
+		this->retainedBlocksCount--;
+		this->retainedBytes -= sizeof(SMemoryBlockHeader) + block->blockSize;
+		this->removeReservedBytes(sizeof(SMemoryBlockHeader) + block->blockSize);
+		this->blockProvider->freeBlock(block, sizeof(SMemoryBlockHeader) + block->blockSize);
+	}
+}
+
+void AppShift::Memory::MemoryPool::trim()
+{
+	this->trimRetainedBlocks(0);
+}
+
+void AppShift::Memory::MemoryPool::trimRetainedBlocks(size_t max_block_size)
+{
+	SMemoryBlockHeader** retained = &this->retainedBlocks;
+	while (*retained != nullptr) {
+		SMemoryBlockHeader* block = *retained;
+		if (block->blockSize <= max_block_size) {
+			retained = &block->next;
+			continue;
 		}
-		std::free(block);
+
+		*retained = block->next;
+		this->retainedBlocksCount--;
+		this->retainedBytes -= sizeof(SMemoryBlockHeader) + block->blockSize;
+		this->removeReservedBytes(sizeof(SMemoryBlockHeader) + block->blockSize);
+		this->blockProvider->freeBlock(block, sizeof(SMemoryBlockHeader) + block->blockSize);
+	}
+}
+
+void AppShift::Memory::MemoryPool::enableFreeLists(bool enable)
+{
+	this->useFreeLists = enable;
+	if (enable) return;
+
+	// Leave the listed units as plain deleted units
+	for (size_t i = 0; i < MEMORYPOOL_FREELIST_BINS; i++) {
+		while (this->freeLists[i] != nullptr)
+			this->unlinkFreeUnit(reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(this->freeLists[i]) - sizeof(SMemoryUnitHeader)));
+	}
+}
+
+void* AppShift::Memory::MemoryPool::popFreeUnit(size_t size)
+{
+	size_t bin = size / MEMORYPOOL_FREELIST_GRANULARITY - 1;
+	if (bin >= MEMORYPOOL_FREELIST_BINS || this->freeLists[bin] == nullptr) return nullptr;
+
+	SMemoryFreeUnit* free_unit = this->freeLists[bin];
+	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(free_unit) - sizeof(SMemoryUnitHeader));
+	this->unlinkFreeUnit(unit);
+	unit->length &= MEMORYPOOL_UNIT_LENGTH_MASK;
+	getContainer(unit)->numberOfDeleted--;
+	this->addUsedBytes(sizeof(SMemoryUnitHeader) + unit->length);
+
+	return free_unit;
+}
+
+void AppShift::Memory::MemoryPool::pushFreeUnit(SMemoryUnitHeader* unit)
+{
+	// Units too small to hold the links or bigger than the last size class are not reused
+	size_t length = unit->length & MEMORYPOOL_UNIT_LENGTH_MASK;
+	if (length < MEMORYPOOL_FREELIST_GRANULARITY) return;
+	size_t bin = length / MEMORYPOOL_FREELIST_GRANULARITY - 1;
+	if (bin >= MEMORYPOOL_FREELIST_BINS) return;
+
+	SMemoryFreeUnit* free_unit = reinterpret_cast<SMemoryFreeUnit*>(reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader));
+	free_unit->prev = nullptr;
+	free_unit->next = this->freeLists[bin];
+	if (free_unit->next != nullptr) free_unit->next->prev = free_unit;
+	this->freeLists[bin] = free_unit;
+	unit->length |= MEMORYPOOL_UNIT_LISTED;
+}
+
+void AppShift::Memory::MemoryPool::unlinkFreeUnit(SMemoryUnitHeader* unit)
+{
+	unit->length &= ~MEMORYPOOL_UNIT_LISTED;
+	size_t bin = (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK) / MEMORYPOOL_FREELIST_GRANULARITY - 1;
+
+	SMemoryFreeUnit* free_unit = reinterpret_cast<SMemoryFreeUnit*>(reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader));
+	if (free_unit->prev != nullptr) free_unit->prev->next = free_unit->next;
+	else this->freeLists[bin] = free_unit->next;
+	if (free_unit->next != nullptr) free_unit->next->prev = free_unit->prev;
+}
+
+void AppShift::Memory::MemoryPool::unlinkFreeUnits(SMemoryBlockHeader* block, size_t from_offset)
+{
+	size_t current_unit_offset = from_offset;
+	while (current_unit_offset < block->offset) {
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + current_unit_offset);
+		if (unit->length & MEMORYPOOL_UNIT_LISTED) this->unlinkFreeUnit(unit);
+		current_unit_offset += sizeof(SMemoryUnitHeader) + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+	}
+}
+
+size_t AppShift::Memory::MemoryPool::compressGarbage(size_t max_blocks)
+{
+	size_t reclaimed = 0;
+	size_t block_counter = 0;
+	if (this->garbageCursor == nullptr) this->garbageCursor = this->firstBlock;
+
+	while (this->garbageCursor != nullptr && (max_blocks == 0 || block_counter < max_blocks)) {
+		SMemoryBlockHeader* block = this->garbageCursor;
+		this->garbageCursor = block->next;
+		block_counter++;
+		if (block->numberOfDeleted == 0) continue;
+
+		reclaimed += this->compressBlockGarbage(block);
+
+		this->markScopeCounters(block);
+		this->updateBlockSpace(block);
+
+		// Remove the block if nothing is left in it
+		if (this->currentBlock != this->firstBlock && block->offset == 0) this->releaseMemoryBlock(block);
 	}
+
+	return reclaimed;
 }
 
+size_t AppShift::Memory::MemoryPool::compressBlockGarbage(SMemoryBlockHeader* block)
+{
+	size_t current_unit_offset = 0;
+	size_t reclaimed = 0;
+
+	while (current_unit_offset < block->offset) {
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + current_unit_offset);
+		size_t length = unit->length & MEMORYPOOL_UNIT_LENGTH_MASK;
+		if (!(unit->length & MEMORYPOOL_UNIT_DELETED)) {
+			current_unit_offset += sizeof(SMemoryUnitHeader) + length;
+			continue;
+		}
+
+		// Collect the run of deleted units starting at this unit
+		size_t run_offset = current_unit_offset;
+		size_t run_units = 0;
+		while (current_unit_offset < block->offset) {
+			SMemoryUnitHeader* run_unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + current_unit_offset);
+			if (!(run_unit->length & MEMORYPOOL_UNIT_DELETED)) break;
+			if (run_unit->length & MEMORYPOOL_UNIT_LISTED) this->unlinkFreeUnit(run_unit);
+			current_unit_offset += sizeof(SMemoryUnitHeader) + (run_unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+			run_units++;
+		}
+
+		// Deleted units at the end of the block are given back to the block
+		if (current_unit_offset == block->offset) {
+			reclaimed += block->offset - run_offset;
+			block->offset = run_offset;
+			block->numberOfAllocated -= run_units;
+			block->numberOfDeleted -= run_units;
+			break;
+		}
+
+		// Otherwise merge them into the first unit of the run
+		unit->length = (current_unit_offset - run_offset - sizeof(SMemoryUnitHeader)) | MEMORYPOOL_UNIT_DELETED;
+		block->numberOfAllocated -= run_units - 1;
+		block->numberOfDeleted -= run_units - 1;
+		if (this->useFreeLists) this->pushFreeUnit(unit);
+	}
+
+	return reclaimed;
+}
 
 void AppShift::Memory::MemoryPool::dumpPoolData()
 {
 	SMemoryBlockHeader* block = this->firstBlock;
 	SMemoryUnitHeader* unit;
+	bool is_deleted;
 
 	size_t current_unit_offset;
 	size_t block_counter = 1;
@@ -155,6 +909,7 @@ void AppShift::Memory::MemoryPool::dumpPoolData()
 		// Dump block data
 		std::cout << "Block " << block_counter << ": " << std::endl;
 		std::cout << "\t" << "Used: " << (float)(block->offset) / (float)(block->blockSize) * 100 << "% " << "(" << block->offset << "/" << block->blockSize << ")" << std::endl;
+		std::cout << "\t" << "Live units: " << block->numberOfAllocated - block->numberOfDeleted << ", Deleted units: " << block->numberOfDeleted << std::endl;
 
 		if (block->offset == 0) {
 			block = block->next;
@@ -167,8 +922,9 @@ void AppShift::Memory::MemoryPool::dumpPoolData()
 		unit_counter = 1;
 		while (current_unit_offset < block->offset) {
 			unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + current_unit_offset);
-			std::cout << "\t\t" << "Unit " << unit_counter << ": " << unit->length + sizeof(SMemoryUnitHeader) << std::endl;
-			current_unit_offset += sizeof(SMemoryUnitHeader) + unit->length;
+			is_deleted = unit->length & MEMORYPOOL_UNIT_DELETED;
+			std::cout << "\t\t" << "Unit " << unit_counter << ": " << (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK) + sizeof(SMemoryUnitHeader) << (is_deleted ? " (deleted)" : "") << std::endl;
+			current_unit_offset += sizeof(SMemoryUnitHeader) + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
 			unit_counter++;
 		}
 
@@ -179,40 +935,232 @@ void AppShift::Memory::MemoryPool::dumpPoolData()
 	}
 }
 
-void AppShift::Memory::MemoryPool::startScope()
+size_t AppShift::Memory::MemoryPool::getDeletedBytes(SMemoryBlockHeader* block, size_t from_offset)
 {
-	// Create new scope, on top of previous if exists
-	if (this->currentScope == nullptr) {
-		this->currentScope = new (this) SMemoryScopeHeader;
-		this->currentScope->prevScope = nullptr;
+	size_t deleted_bytes = 0;
+	size_t current_unit_offset = from_offset;
+	while (current_unit_offset < block->offset) {
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + current_unit_offset);
+		size_t unit_bytes = sizeof(SMemoryUnitHeader) + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+		if (unit->length & MEMORYPOOL_UNIT_DELETED) deleted_bytes += unit_bytes;
+		current_unit_offset += unit_bytes;
 	}
-	else {
-		SMemoryScopeHeader* new_scope = new (this) SMemoryScopeHeader;
-		new_scope->prevScope = this->currentScope;
-		this->currentScope = new_scope;
+	return deleted_bytes;
+}
+
+void AppShift::Memory::MemoryPool::countUnits(SMemoryBlockHeader* block, size_t from_offset, size_t& units, size_t& deleted_units)
+{
+	units = deleted_units = 0;
+	size_t current_unit_offset = from_offset;
+	while (current_unit_offset < block->offset) {
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + current_unit_offset);
+		units++;
+		if (unit->length & MEMORYPOOL_UNIT_DELETED) deleted_units++;
+		current_unit_offset += sizeof(SMemoryUnitHeader) + (unit->length & MEMORYPOOL_UNIT_LENGTH_MASK);
+	}
+}
+
+AppShift::Memory::SMemoryPoolStats AppShift::Memory::MemoryPool::getStats()
+{
+#ifndef MEMORYPOOL_DISABLE_STATS
+	SMemoryPoolStats result = this->stats;
+#else
+	SMemoryPoolStats result = SMemoryPoolStats();
+#endif
+
+	// Go over the blocks, units are only visited when the used bytes are not counted
+	size_t taken_bytes = 0;
+	size_t unused_tails = 0;
+	result.blockCount = 0;
+	result.bytesReserved = this->retainedBytes;
+	result.bytesRetained = this->retainedBytes;
+	result.liveUnits = 0;
+	result.deletedUnits = 0;
+	for (SMemoryBlockHeader* block = this->firstBlock; block != nullptr; block = block->next) {
+		result.blockCount++;
+		result.bytesReserved += sizeof(SMemoryBlockHeader) + block->blockSize;
+		result.liveUnits += block->numberOfAllocated - block->numberOfDeleted;
+		result.deletedUnits += block->numberOfDeleted;
+		taken_bytes += block->offset;
+		// Space left at the end of blocks before the current one is only used again if they are emptied
+		if (block != this->currentBlock) unused_tails += block->blockSize - block->offset;
+#ifdef MEMORYPOOL_DISABLE_STATS
+		if (block->numberOfDeleted != 0) result.bytesDeleted += getDeletedBytes(block, 0);
+#endif
 	}
 
+#ifndef MEMORYPOOL_DISABLE_STATS
+	result.bytesDeleted = taken_bytes - result.bytesUsed;
+#else
+	result.bytesUsed = taken_bytes - result.bytesDeleted;
+#endif
+	result.bytesWasted = result.bytesDeleted + unused_tails;
+
+	return result;
+}
+
+void AppShift::Memory::MemoryPool::dumpStatsJson(std::ostream& stream)
+{
+	SMemoryPoolStats stats = this->getStats();
+
+	stream << "{\"blockCount\":" << stats.blockCount
+		<< ",\"bytesReserved\":" << stats.bytesReserved
+		<< ",\"bytesRetained\":" << stats.bytesRetained
+		<< ",\"bytesUsed\":" << stats.bytesUsed
+		<< ",\"bytesDeleted\":" << stats.bytesDeleted
+		<< ",\"bytesWasted\":" << stats.bytesWasted
+		<< ",\"liveUnits\":" << stats.liveUnits
+		<< ",\"deletedUnits\":" << stats.deletedUnits
+		<< ",\"allocations\":" << stats.allocations
+		<< ",\"frees\":" << stats.frees
+		<< ",\"blocksCreated\":" << stats.blocksCreated
+		<< ",\"blocksFreed\":" << stats.blocksFreed
+		<< ",\"peakBytesReserved\":" << stats.peakBytesReserved
+		<< ",\"peakBytesUsed\":" << stats.peakBytesUsed
+		<< ",\"sizeHistogram\":[";
+	for (size_t i = 0; i < MEMORYPOOL_STATS_HISTOGRAM_BINS; i++) stream << (i == 0 ? "" : ",") << stats.sizeHistogram[i];
+	stream << "]}";
+}
+
+void AppShift::Memory::MemoryPool::startScope()
+{
+#ifdef MEMORYPOOL_TRACING
+	if (this->trace != nullptr && this->trace->depth == 0) this->trace->record(ETraceEvent::START_SCOPE);
+#endif
+
+	// Create new scope, on top of previous if exists
+	SMemoryScopeHeader* new_scope = reinterpret_cast<SMemoryScopeHeader*>(this->bumpAllocate(sizeof(SMemoryScopeHeader)));
+	new_scope->prevScope = this->currentScope;
+	this->currentScope = new_scope;
+
 	// Simply load the current offset & block to return to when scope ends
 	this->currentScope->scopeOffset = this->currentBlock->offset - sizeof(SMemoryScopeHeader) - sizeof(SMemoryUnitHeader);
 	this->currentScope->firstScopeBlock = this->currentBlock;
+	this->currentScope->finalizers = nullptr;
+
+	// Counters of the block without the scope header
+	this->currentScope->numberOfAllocated = this->currentBlock->numberOfAllocated - 1;
+	this->currentScope->numberOfDeleted = this->currentBlock->numberOfDeleted;
 }
 
 void AppShift::Memory::MemoryPool::endScope()
 {
+	// Units of the scope freed by other threads must leave the queue before their space is taken back
+	this->collectRemoteFrees();
+
+#ifdef MEMORYPOOL_TRACING
+	if (this->trace != nullptr && this->trace->depth == 0) this->trace->record(ETraceEvent::END_SCOPE);
+#endif
+
+	SMemoryScopeHeader* scope = this->currentScope;
+	this->garbageCursor = nullptr;
+
+	// Destroy the objects made in the scope, the last made first
+	for (SMemoryScopeFinalizer* finalizer = scope->finalizers; finalizer != nullptr; finalizer = finalizer->next)
+		finalizer->finalize(finalizer);
+
+	// Units deleted inside the scope can't stay in the free lists
+	if (this->useFreeLists) {
+		for (SMemoryBlockHeader* block = scope->firstScopeBlock->next; block != nullptr; block = block->next)
+			if (block->numberOfDeleted != 0) this->unlinkFreeUnits(block, 0);
+		if (scope->firstScopeBlock->numberOfDeleted != 0) this->unlinkFreeUnits(scope->firstScopeBlock, scope->scopeOffset);
+	}
+
+#ifndef MEMORYPOOL_DISABLE_STATS
+	// Units of the scope that are still live are given back with it
+	for (SMemoryBlockHeader* block = scope->firstScopeBlock; block != nullptr; block = block->next) {
+		size_t from_offset = block == scope->firstScopeBlock ? scope->scopeOffset : 0;
+		size_t deleted_bytes = block->numberOfDeleted != 0 ? getDeletedBytes(block, from_offset) : 0;
+		this->removeUsedBytes(block->offset - from_offset - deleted_bytes);
+	}
+#endif
+
 	// Free all blocks until the start of scope
-	while (this->currentBlock != this->currentScope->firstScopeBlock) {
+	while (this->currentBlock != scope->firstScopeBlock) {
 		this->currentBlock = this->currentBlock->prev;
-		std::free(this->currentBlock->next);
+		this->unindexBlock(this->currentBlock);
+		this->freeMemoryBlock(this->currentBlock->next);
 		this->currentBlock->next = nullptr;
 	}
 
-	this->currentBlock->offset = this->currentScope->scopeOffset;
+	// Without deletes in the first block its counters are the ones of the scope start,
+	// otherwise the units after the scope start are taken off the counters
+	if (this->currentBlock->numberOfDeleted == scope->numberOfDeleted) this->currentBlock->numberOfAllocated = scope->numberOfAllocated;
+	else {
+		size_t units, deleted_units;
+		countUnits(this->currentBlock, scope->scopeOffset, units, deleted_units);
+		this->currentBlock->numberOfAllocated -= units;
+		this->currentBlock->numberOfDeleted -= deleted_units;
+	}
+
+	this->currentScope = scope->prevScope;
+	this->currentBlock->offset = scope->scopeOffset;
+}
+
+#ifdef MEMORYPOOL_TRACING
+void AppShift::Memory::MemoryPool::startTracing(const char* path)
+{
+	this->stopTracing();
+	this->trace = new MemoryPoolTraceWriter(path, this->defaultBlockSize, this->useFreeLists);
+	if (!this->trace->isOpen()) {
+		this->stopTracing();
+		throw EMemoryErrors::CANNOT_OPEN_TRACE;
+	}
+}
+
+void AppShift::Memory::MemoryPool::stopTracing()
+{
+	delete this->trace;
+	this->trace = nullptr;
+}
+
+void* AppShift::Memory::MemoryPool::tracedAllocate(size_t size, size_t alignment)
+{
+	void* unit_pointer_start;
+	{
+		STraceDepthGuard guard(this->trace);
+		unit_pointer_start = alignment == 0 ? this->allocate(size) : this->allocateAligned(size, alignment);
+	}
+	this->trace->record(ETraceEvent::ALLOCATE, unit_pointer_start, size, alignment);
+	return unit_pointer_start;
 }
 
+void* AppShift::Memory::MemoryPool::tracedReallocate(void* unit_pointer_start, size_t new_size, size_t alignment)
+{
+	void* new_unit_pointer_start;
+	{
+		STraceDepthGuard guard(this->trace);
+		new_unit_pointer_start = this->reallocateAligned(unit_pointer_start, new_size, alignment);
+	}
+	this->trace->record(ETraceEvent::REALLOCATE, unit_pointer_start, new_size, alignment, new_unit_pointer_start);
+	return new_unit_pointer_start;
+}
+
+void AppShift::Memory::MemoryPool::tracedFree(void* unit_pointer_start)
+{
+	{
+		STraceDepthGuard guard(this->trace);
+		this->free(unit_pointer_start);
+	}
+	this->trace->record(ETraceEvent::FREE, unit_pointer_start);
+}
+#endif
+
+// Like the global new, the memory is aligned for any type up to the default new alignment, units are only aligned to their header
 void* operator new(size_t size, AppShift::Memory::MemoryPool* mp) {
-	return mp->allocate(size);
+	if (alignof(AppShift::Memory::SMemoryUnitHeader) >= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return mp->allocate(size);
+	return mp->allocateAligned(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
 }
 
 void* operator new[](size_t size, AppShift::Memory::MemoryPool* mp) {
-	return mp->allocate(size);
+	if (alignof(AppShift::Memory::SMemoryUnitHeader) >= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return mp->allocate(size);
+	return mp->allocateAligned(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, AppShift::Memory::MemoryPool* mp) {
+	return mp->allocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, AppShift::Memory::MemoryPool* mp) {
+	return mp->allocateAligned(size, static_cast<size_t>(alignment));
 }
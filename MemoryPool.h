@@ -19,20 +19,79 @@
  */
 #pragma once
 #define MEMORYPOOL_DEFAULT_BLOCK_SIZE 1024 * 1024
+#define MEMORYPOOL_MAX_RETAINED_BLOCKS 1
+#define MEMORYPOOL_MAX_RETAINED_BYTES ((size_t) -1)
+#define MEMORYPOOL_FREELIST_GRANULARITY 16
+#define MEMORYPOOL_FREELIST_BINS 64
+#define MEMORYPOOL_BLOCK_ALIGNMENT ((size_t) 2 * 1024 * 1024)
+#define MEMORYPOOL_STATS_HISTOGRAM_BINS 32
+#define MEMORYPOOL_SPACE_BINS 48
+#define MEMORYPOOL_MAX_ADAPTIVE_BLOCK_SIZE ((size_t) 4 * 1024 * 1024)
+#define MEMORYPOOL_PAGE_SIZE 4096
+
+// Define MEMORYPOOL_ADDRESS_MASKING to find the block of a unit by masking its address,
+// blocks are then aligned to MEMORYPOOL_BLOCK_ALIGNMENT & units don't store their block
+// #define MEMORYPOOL_ADDRESS_MASKING
+
+// Define MEMORYPOOL_DISABLE_STATS to remove the statistics counters from the allocation paths
+// #define MEMORYPOOL_DISABLE_STATS
+
+// Define MEMORYPOOL_TRACING to be able to record the calls to a pool into a trace file
+// #define MEMORYPOOL_TRACING
+
+// Flags set in SMemoryUnitHeader::length of deleted units, and of deleted units linked in a free list
+#define MEMORYPOOL_UNIT_DELETED ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+#define MEMORYPOOL_UNIT_LISTED ((size_t) 1 << (sizeof(size_t) * 8 - 2))
+#define MEMORYPOOL_UNIT_LENGTH_MASK (~(MEMORYPOOL_UNIT_DELETED | MEMORYPOOL_UNIT_LISTED))
+
+// Keep rarely taken paths out of the inlined allocation code
+#if defined(__GNUC__) || defined(__clang__)
+#define MEMORYPOOL_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define MEMORYPOOL_NOINLINE __declspec(noinline)
+#else
+#define MEMORYPOOL_NOINLINE
+#endif
+
+// Hint the compiler about the common case of a condition
+#if defined(__GNUC__) || defined(__clang__)
+#define MEMORYPOOL_LIKELY(condition) __builtin_expect(!!(condition), 1)
+#else
+#define MEMORYPOOL_LIKELY(condition) (condition)
+#endif
 
 #include <stdlib.h>
 #include <cstring>
 #include <cstddef>
 #include <memory>
+#include <new>
+#include <cstdint>
+#include <iosfwd>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#ifdef MEMORYPOOL_TRACING
+#include "MemoryPoolTrace.h"
+#endif
 
 namespace AppShift::Memory {
+	class MemoryPool;
+
 	// Simple error collection for memory pool
     enum class EMemoryErrors {
         CANNOT_CREATE_MEMORY_POOL,
         CANNOT_CREATE_BLOCK,
         OUT_OF_POOL,
         EXCEEDS_MAX_SIZE,
-        CANNOT_CREATE_BLOCK_CHAIN
+        CANNOT_CREATE_BLOCK_CHAIN,
+        OUT_OF_THREAD_SLOTS,
+        INVALID_ALIGNMENT,
+        CANNOT_MAP_SHARED_MEMORY,
+        INVALID_SHARED_MEMORY,
+        CANNOT_OPEN_TRACE,
+        CANNOT_WRITE_POOL_IMAGE,
+        CANNOT_MAP_POOL_IMAGE,
+        INVALID_POOL_IMAGE
     };
 
     // Header for a single memory block
@@ -48,12 +107,34 @@ namespace AppShift::Memory {
         // Garbage management data
         size_t numberOfAllocated;
         size_t numberOfDeleted;
+
+        // Pool which owns the block
+        MemoryPool* pool;
+
+        // Index of the blocks other than the current one by tail space, spaceBin is SIZE_MAX when not indexed
+        SMemoryBlockHeader* nextSpaceBlock;
+        SMemoryBlockHeader* prevSpaceBlock;
+        size_t spaceBin;
     };
 
     // Header of a memory unit in the pool holding important metadata
     struct SMemoryUnitHeader {
         size_t length;
+#ifndef MEMORYPOOL_ADDRESS_MASKING
         SMemoryBlockHeader* container;
+#endif
+    };
+
+    // Links of a deleted unit in a free list, stored in the unit's data
+    struct SMemoryFreeUnit {
+        SMemoryFreeUnit* next;
+        SMemoryFreeUnit* prev;
+    };
+
+    // Destroys an object made in a scope, stored in the same unit right before the object
+    struct SMemoryScopeFinalizer {
+        void (*finalize)(SMemoryScopeFinalizer* finalizer);
+        SMemoryScopeFinalizer* next;
     };
 
     // Header for a scope in memory
@@ -61,16 +142,95 @@ namespace AppShift::Memory {
         size_t scopeOffset;
         SMemoryBlockHeader* firstScopeBlock;
         SMemoryScopeHeader* prevScope;
+
+        // Objects to destroy when the scope ends, the last made first
+        SMemoryScopeFinalizer* finalizers;
+
+        // Counters of the first block when the scope started
+        size_t numberOfAllocated;
+        size_t numberOfDeleted;
     };
 
+    // Statistics of a memory pool, returned by getStats
+    struct SMemoryPoolStats {
+        // Current usage, found by going over the blocks
+        size_t blockCount;
+        size_t bytesReserved;
+        size_t bytesRetained;
+        size_t bytesUsed;
+        size_t bytesDeleted;
+        size_t bytesWasted;
+        size_t liveUnits;
+        size_t deletedUnits;
+
+        // Counters since the pool was created, 0 with MEMORYPOOL_DISABLE_STATS
+        size_t allocations;
+        size_t frees;
+        size_t blocksCreated;
+        size_t blocksFreed;
+        size_t peakBytesReserved;
+        size_t peakBytesUsed;
+        size_t sizeHistogram[MEMORYPOOL_STATS_HISTOGRAM_BINS];
+    };
+
+	/**
+	 * Source of the memory of the blocks in a pool.
+	 * A provider can be shared by many pools, and must outlive them.
+	 */
+	class MemoryBlockProvider {
+	public:
+		virtual ~MemoryBlockProvider() = default;
+
+		/**
+		 * Allocate the memory of a block
+		 *
+		 * @param size_t size Size of the block including its header
+		 *
+		 * @returns void* Pointer to the memory of the block, nullptr if it can't be allocated
+		 */
+		virtual void* allocateBlock(size_t size) = 0;
+
+		/**
+		 * Allocate the memory of a block starting at a multiple of an alignment.
+		 * By default takes a block from allocateBlock, and fails if it is not aligned.
+		 *
+		 * @param size_t size Size of the block including its header
+		 * @param size_t alignment Alignment of the block start, a power of 2
+		 *
+		 * @returns void* Pointer to the memory of the block, nullptr if it can't be allocated
+		 */
+		virtual void* allocateAlignedBlock(size_t size, size_t alignment);
+
+		/**
+		 * Free the memory of a block
+		 *
+		 * @param void* block Pointer returned by allocateBlock
+		 * @param size_t size Size passed to allocateBlock
+		 */
+		virtual void freeBlock(void* block, size_t size) = 0;
+	};
+
+	// Provides blocks using malloc & free, used by default
+	class MallocBlockProvider : public MemoryBlockProvider {
+	public:
+		void* allocateBlock(size_t size) override;
+		void* allocateAlignedBlock(size_t size, size_t alignment) override;
+		void freeBlock(void* block, size_t size) override;
+
+		// Provider shared by all the pools created without one
+		static MallocBlockProvider* getDefault();
+	};
+
 	class MemoryPool {
 	public:
 		/**
 		 * Creates a memory pool structure and initializes it
 		 * 
 		 * @param size_t block_size Defines the default size of a block in the pool, by default uses MEMORYPOOL_DEFAULT_BLOCK_SIZE
+		 * @param MemoryBlockProvider* provider Source of the memory of the blocks, by default uses malloc
+		 * @param size_t reservation Bytes of blocks to create & pre-fault before the first allocation, see reserve
 		 */
-		MemoryPool(size_t block_size = MEMORYPOOL_DEFAULT_BLOCK_SIZE);
+		MemoryPool(size_t block_size = MEMORYPOOL_DEFAULT_BLOCK_SIZE, MemoryBlockProvider* provider = nullptr, size_t reservation = 0);
 		// Destructor
 		~MemoryPool();
 
@@ -78,10 +238,45 @@ namespace AppShift::Memory {
         SMemoryBlockHeader* firstBlock;
         SMemoryBlockHeader* currentBlock;
         size_t defaultBlockSize;
+        MemoryBlockProvider* blockProvider;
+
+        // Size of the next block, doubled when a block is filled & halved when one is emptied, up to maxBlockSize
+        size_t nextBlockSize;
+        size_t maxBlockSize;
+
+        // Empty blocks kept for reuse instead of being freed, linked by next
+        SMemoryBlockHeader* retainedBlocks;
+        size_t retainedBlocksCount;
+        size_t retainedBytes;
+        size_t maxRetainedBlocks;
+        size_t maxRetainedBytes;
 
         // Data about memory scopes
         SMemoryScopeHeader* currentScope;
 
+        // Deleted units binned by size class, reused before the block offset is moved
+        bool useFreeLists;
+        SMemoryFreeUnit* freeLists[MEMORYPOOL_FREELIST_BINS];
+
+        // Block to continue compressing garbage from
+        SMemoryBlockHeader* garbageCursor;
+
+        // Blocks other than the current one binned by the highest bit of their tail space
+        SMemoryBlockHeader* spaceBins[MEMORYPOOL_SPACE_BINS];
+
+        // Units freed by other threads, linked through their data & freed by the owner thread
+        std::atomic<void*> remoteFrees;
+
+#ifndef MEMORYPOOL_DISABLE_STATS
+        // Counters updated by the allocation paths, bytesReserved & bytesUsed are kept current for the peaks
+        SMemoryPoolStats stats;
+#endif
+
+#ifdef MEMORYPOOL_TRACING
+        // Trace the calls are recorded into, nullptr when not tracing
+        MemoryPoolTraceWriter* trace;
+#endif
+
 		/**
 		 * Create a new standalone memory block unattached to any memory pool
 		 * 
@@ -91,6 +286,37 @@ namespace AppShift::Memory {
 		 */
 		void createMemoryBlock(size_t block_size = MEMORYPOOL_DEFAULT_BLOCK_SIZE);
 
+		/**
+		 * Set how many empty blocks are kept for reuse instead of being freed.
+		 * Blocks that exceed the limits are freed right away.
+		 *
+		 * @param size_t max_blocks Maximum number of blocks to keep, by default uses MEMORYPOOL_MAX_RETAINED_BLOCKS
+		 * @param size_t max_bytes Maximum size of all the blocks kept, by default uses MEMORYPOOL_MAX_RETAINED_BYTES
+		 */
+		void setBlockRetention(size_t max_blocks, size_t max_bytes = MEMORYPOOL_MAX_RETAINED_BYTES);
+
+		/**
+		 * Free all the empty blocks kept for reuse
+		 */
+		void trim();
+
+		/**
+		 * Create blocks ahead of time, so the allocations of up to a number of bytes don't wait for the block provider.
+		 * The blocks are kept with the empty blocks kept for reuse, and taken when a new block is needed.
+		 *
+		 * @param size_t bytes Bytes the current block & the kept blocks must be able to hold
+		 * @param bool prefault Touch every page of the blocks, so the allocations don't page fault
+		 */
+		void reserve(size_t bytes, bool prefault = false);
+
+		/**
+		 * Create a number of blocks of the next block size ahead of time, kept until a new block is needed
+		 *
+		 * @param size_t count Number of blocks to create
+		 * @param bool prefault Touch every page of the blocks, so the allocations don't page fault
+		 */
+		void preallocateBlocks(size_t count, bool prefault = false);
+
 		/**
 		 * Allocates memory in a pool
 		 *
@@ -101,12 +327,24 @@ namespace AppShift::Memory {
 		 */
 		void* allocate(size_t size);
 
-		// Templated allocation
+		/**
+		 * Allocates memory in a pool with its start aligned.
+		 * The space skipped for the alignment is kept as a deleted unit.
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 * @param size_t alignment Alignment of the allocated space, must be a power of 2
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocateAligned(size_t size, size_t alignment);
+
+		// Templated allocation, aligned to the type
 		template<typename T>
 		T* allocate(size_t instances);
 
 		/**
-		 * Re-allocates memory in a pool
+		 * Re-allocates memory in a pool. A unit re-allocated to a smaller size keeps its capacity,
+		 * use tryExpand to give the space back.
 		 *
 		 * @param void* unit_pointer_start Pointer to the object to re-allocate
 		 * @param size_t new_size New size to allocate in memory pool
@@ -115,10 +353,53 @@ namespace AppShift::Memory {
 		 */
 		void* reallocate(void* unit_pointer_start, size_t new_size);
 
-		// Templated re-allocation
+		/**
+		 * Re-allocates memory in a pool, keeping the alignment if the space is moved
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to re-allocate
+		 * @param size_t new_size New size to allocate in memory pool
+		 * @param size_t alignment Alignment of the allocated space, must be a power of 2
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* reallocateAligned(void* unit_pointer_start, size_t new_size, size_t alignment);
+
+		// Templated re-allocation, aligned to the type
 		template<typename T>
 		T* reallocate(T* unit_pointer_start, size_t new_size);
 
+		/**
+		 * Allocates memory with space reserved after it, so re-allocations up to the capacity
+		 * are done in place
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 * @param size_t capacity Size the unit can grow to without moving
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocateWithCapacity(size_t size, size_t capacity);
+
+		/**
+		 * Get the size a unit can grow to without moving, at least the size it was allocated with
+		 *
+		 * @param void* unit_pointer_start Pointer to the object
+		 *
+		 * @returns size_t Capacity of the unit
+		 */
+		static size_t getCapacity(void* unit_pointer_start);
+
+		/**
+		 * Grow or shrink a unit without ever moving it. A unit grows within its capacity,
+		 * into the end of its block if it is the last unit, or over the deleted units following it.
+		 * Space left after the unit is given back as a deleted unit, or to the block if it is the last unit.
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to resize
+		 * @param size_t new_size New size of the object
+		 *
+		 * @returns bool True if the unit holds the new size, otherwise the unit is not changed
+		 */
+		bool tryExpand(void* unit_pointer_start, size_t new_size);
+
 		/**
 		 * Frees memory in a pool
 		 *
@@ -126,6 +407,78 @@ namespace AppShift::Memory {
 		 */
 		void free(void* unit_pointer_start);
 
+		/**
+		 * Frees memory of a pool owned by another thread. The unit is pushed to the remote frees
+		 * queue of its pool without locking, and freed by the owner thread the next time an
+		 * allocation doesn't fit its current block, or when it calls collectRemoteFrees.
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to free
+		 */
+		static void freeRemote(void* unit_pointer_start);
+
+		/**
+		 * Push a unit of this pool to its remote frees queue, safe to call from any thread
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to free
+		 */
+		void pushRemoteFree(void* unit_pointer_start);
+
+		/**
+		 * Free all the units pushed to the remote frees queue, called by the owner thread
+		 */
+		void collectRemoteFrees();
+
+		/**
+		 * Allocates many units of the same size at once. The space is checked once
+		 * for all the units fitting the current block & their headers are written in one loop,
+		 * a block big enough for the rest is created when they don't fit.
+		 *
+		 * @param size_t count Number of units to allocate
+		 * @param size_t size Size of each unit
+		 * @param void** out Array of count pointers to fill with the newly allocated spaces
+		 */
+		void allocateBatch(size_t count, size_t size, void** out);
+
+		/**
+		 * Frees many units at once. Units of the same block next to each other in the array
+		 * are freed together, updating the counters of their block once.
+		 * A block left with no live units is released, or emptied if it is the only one.
+		 *
+		 * @param void** ptrs Array of pointers to the objects to free, nullptr entries are skipped
+		 * @param size_t count Number of pointers in the array
+		 */
+		void freeBatch(void** ptrs, size_t count);
+
+		/**
+		 * Let the size of the blocks follow the demand: every block created because the previous one
+		 * is full is twice the size of the previous, up to a maximum, and emptied blocks halve the size
+		 * back down to the default block size.
+		 *
+		 * @param size_t max_block_size Maximum size of a block, by default uses MEMORYPOOL_MAX_ADAPTIVE_BLOCK_SIZE. The default block size or less keeps the size fixed
+		 */
+		void enableAdaptiveBlockSize(size_t max_block_size = MEMORYPOOL_MAX_ADAPTIVE_BLOCK_SIZE);
+
+		/**
+		 * Enable or disable reusing deleted units through free lists.
+		 * When enabled, sizes are rounded up to MEMORYPOOL_FREELIST_GRANULARITY and
+		 * deleted units of up to MEMORYPOOL_FREELIST_BINS size classes are reused by allocate.
+		 * Units are not reused while a scope is open.
+		 *
+		 * @param bool enable Whether to use free lists
+		 */
+		void enableFreeLists(bool enable = true);
+
+		/**
+		 * Merge deleted units that are next to each other into one unit, and move
+		 * the offset of a block back when deleted units reach its end.
+		 * Blocks left empty are removed.
+		 *
+		 * @param size_t max_blocks Maximum number of blocks to go over, continuing from where the previous call stopped. 0 goes over all the blocks
+		 *
+		 * @returns size_t Number of bytes given back to the end of blocks
+		 */
+		size_t compressGarbage(size_t max_blocks = 0);
+
 		/**
 		 * Dump memory pool meta data of blocks unit to stream. 
 		 * Might be useful for debugging and analyzing memory usage
@@ -134,6 +487,36 @@ namespace AppShift::Memory {
 		 */
 		void dumpPoolData();
 
+		/**
+		 * Get the usage & counters of the pool. Only goes over the blocks, not the units,
+		 * unless the counters are removed by MEMORYPOOL_DISABLE_STATS.
+		 *
+		 * @returns SMemoryPoolStats Statistics of the pool
+		 */
+		SMemoryPoolStats getStats();
+
+		/**
+		 * Write the statistics of the pool as a JSON object
+		 *
+		 * @param std::ostream& stream Stream to write to
+		 */
+		void dumpStatsJson(std::ostream& stream);
+
+#ifdef MEMORYPOOL_TRACING
+		/**
+		 * Start recording the calls to the pool into a trace file, replacing the current trace.
+		 * Calls made by the pool itself, like the allocation of a moving re-allocation, are not recorded.
+		 *
+		 * @param const char* path Path of the trace file, replaced if it exists
+		 */
+		void startTracing(const char* path);
+
+		/**
+		 * Stop recording & close the trace file
+		 */
+		void stopTracing();
+#endif
+
 		/**
 		 * Start a scope in the memory pool.
 		 * All the allocations between startScope and andScope will be freed.
@@ -144,22 +527,451 @@ namespace AppShift::Memory {
 		void startScope();
 
 		/**
-		 * 
+		 * End the last scope started: destroy the objects made in it, last made first,
+		 * and free all the allocations made after it started at once
 		 */
 		void endScope();
+
+		/**
+		 * Construct an object in the pool. Objects that are not trivially destructible are destroyed
+		 * by the end of the current scope, and must not be freed on their own.
+		 * Without a scope the object is only constructed.
+		 *
+		 * @param Arguments&&... arguments Arguments of the constructor
+		 *
+		 * @returns T* Pointer to the new object
+		 */
+		template<typename T, typename... Arguments>
+		T* make(Arguments&&... arguments);
+
+		/**
+		 * Get the block holding a unit
+		 *
+		 * @param SMemoryUnitHeader* unit Header of the unit
+		 *
+		 * @returns SMemoryBlockHeader* Header of the block holding the unit
+		 */
+		static SMemoryBlockHeader* getContainer(SMemoryUnitHeader* unit) {
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+			return reinterpret_cast<SMemoryBlockHeader*>(reinterpret_cast<uintptr_t>(unit) & ~(MEMORYPOOL_BLOCK_ALIGNMENT - 1));
+#else
+			return unit->container;
+#endif
+		}
+
+		/**
+		 * Check if a unit of a given size fits at the offset of the current block
+		 *
+		 * @param size_t size Size of the unit data
+		 *
+		 * @returns bool True if the unit fits
+		 */
+		bool fitsCurrentBlock(size_t size) const {
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+			// Units must start inside the first aligned window of their block to be found by masking
+			if (sizeof(SMemoryBlockHeader) + this->currentBlock->offset >= MEMORYPOOL_BLOCK_ALIGNMENT) return false;
+#endif
+			return size + sizeof(SMemoryUnitHeader) < this->currentBlock->blockSize - this->currentBlock->offset;
+		}
+
+	private:
+		// Set the block of a new unit
+		static void setContainer([[maybe_unused]] SMemoryUnitHeader* unit, [[maybe_unused]] SMemoryBlockHeader* block) {
+#ifndef MEMORYPOOL_ADDRESS_MASKING
+			unit->container = block;
+#endif
+		}
+
+		// Allocate a new unit at the offset of the current block
+		void* bumpAllocate(size_t size);
+
+		// Place a unit at the offset of a block, which must have enough space
+		void* placeUnit(SMemoryBlockHeader* block, size_t size);
+
+		// Take a retained block big enough or a new one from the provider, not linked to the chain
+		SMemoryBlockHeader* takeMemoryBlock(size_t block_size);
+
+		// Get a new block from the provider
+		SMemoryBlockHeader* allocateMemoryBlock(size_t block_size);
+
+		// Write to every page of a block from an offset, so the pages are backed
+		static void prefaultBlock(SMemoryBlockHeader* block, size_t offset);
+
+		// Create the current block for an allocation which doesn't fit, adapting the next block size
+		void createNextBlock(size_t min_size);
+
+		// Give the retained blocks bigger than a size back to the provider
+		void trimRetainedBlocks(size_t max_block_size);
+
+		// Check if a unit of a given size, including its header, gets a block of its own
+		bool needsDedicatedBlock(size_t size) const;
+
+		// Create a block for a single big unit, linked before the current block which stays current
+		SMemoryBlockHeader* createDedicatedBlock(size_t block_size);
+
+		// Place the unit of a dedicated block & index the block
+		void* placeDedicatedUnit(SMemoryBlockHeader* block, size_t size);
+
+		// Check if a unit ends at the offset of its block
+		static bool isLastUnit(SMemoryBlockHeader* block, SMemoryUnitHeader* unit);
+
+		// Allocation that reuses a deleted unit or needs a new block
+		MEMORYPOOL_NOINLINE void* allocateSlow(size_t size);
+
+		// Re-allocation that moves the unit
+		MEMORYPOOL_NOINLINE void* reallocateSlow(void* unit_pointer_start, size_t new_size, size_t alignment);
+
+		// Free of a unit that is not the last in its block
+		MEMORYPOOL_NOINLINE void freeSlow(SMemoryUnitHeader* unit, SMemoryBlockHeader* block);
+
+		// Resize a unit without moving it, returns false if the unit can't hold the new size
+		bool resizeInPlace(SMemoryUnitHeader* unit, SMemoryBlockHeader* block, size_t new_size);
+
+		// Units merged or split in a block change its counters, scopes starting in it count their units when they end
+		void markScopeCounters(SMemoryBlockHeader* block);
+
+		// Space a unit can take at the end of a block, including its header
+		static size_t getTailSpace(SMemoryBlockHeader* block);
+
+		// Bin of the blocks index for a tail space
+		static size_t getSpaceBin(size_t space);
+
+		// Add a block to the index by tail space, or remove it
+		void indexBlock(SMemoryBlockHeader* block);
+		void unindexBlock(SMemoryBlockHeader* block);
+
+		// Move an indexed block to the bin of its tail space after the space changed
+		void updateBlockSpace(SMemoryBlockHeader* block);
+
+		// Make an older block with more than the given tail space, or with no live units, the current block.
+		// Returns false if there is none or a scope is open
+		MEMORYPOOL_NOINLINE bool useBlockWithSpace(size_t space);
+
+#ifdef MEMORYPOOL_TRACING
+		// Calls made while tracing, recorded after they are done
+		MEMORYPOOL_NOINLINE void* tracedAllocate(size_t size, size_t alignment);
+		MEMORYPOOL_NOINLINE void* tracedReallocate(void* unit_pointer_start, size_t new_size, size_t alignment);
+		MEMORYPOOL_NOINLINE void tracedFree(void* unit_pointer_start);
+#endif
+
+		// Bytes to skip at the offset of a block so the next unit data is aligned
+		static size_t getAlignmentPadding(SMemoryBlockHeader* block, size_t alignment);
+
+		// Round a requested size to the size of the unit holding it
+		size_t roundUnitSize(size_t size);
+
+		// Remove a block from the chain and free it
+		void releaseMemoryBlock(SMemoryBlockHeader* block);
+
+		// Keep an empty block for reuse if the retention limits allow it, otherwise free it
+		void freeMemoryBlock(SMemoryBlockHeader* block);
+
+		// Merge the deleted units of a block, returns the bytes given back to the end of the block
+		size_t compressBlockGarbage(SMemoryBlockHeader* block);
+
+		// Take a unit of the given size class from the free lists, nullptr if there is none
+		void* popFreeUnit(size_t size);
+
+		// Link a deleted unit in the free list of its size class
+		void pushFreeUnit(SMemoryUnitHeader* unit);
+
+		// Unlink a unit from its free list
+		void unlinkFreeUnit(SMemoryUnitHeader* unit);
+
+		// Unlink all the listed units of a block starting at an offset
+		void unlinkFreeUnits(SMemoryBlockHeader* block, size_t from_offset);
+
+		// Bytes of the deleted units of a block starting at an offset, including their headers
+		static size_t getDeletedBytes(SMemoryBlockHeader* block, size_t from_offset);
+
+		// Count the units & the deleted units of a block starting at an offset
+		static void countUnits(SMemoryBlockHeader* block, size_t from_offset, size_t& units, size_t& deleted_units);
+
+		// Offset of an object made in a scope from the start of its unit, after its finalizer
+		template<typename T>
+		static constexpr size_t getFinalizedObjectOffset() {
+			return (sizeof(SMemoryScopeFinalizer) + alignof(T) - 1) & ~(alignof(T) - 1);
+		}
+
+		// Destroy an object made in a scope
+		template<typename T>
+		static void finalizeObject(SMemoryScopeFinalizer* finalizer) {
+			reinterpret_cast<T*>(reinterpret_cast<char*>(finalizer) + getFinalizedObjectOffset<T>())->~T();
+		}
+
+		// Number of units of a given size, including the header, the current block can still hold
+		size_t getFittingUnits(size_t unit_size) const;
+
+		// Count allocations of a given size in the statistics
+		void recordAllocation(size_t size, size_t count = 1);
+
+		// Count frees of units taking a given number of bytes in total in the statistics
+		void recordFree(size_t bytes, size_t count = 1);
+
+		// Count bytes of live units, including their headers, given to or taken back from the user
+		void addUsedBytes(size_t bytes);
+		void removeUsedBytes(size_t bytes);
+
+		// Count bytes of blocks taken from or given back to the block provider
+		void addReservedBytes(size_t bytes);
+		void removeReservedBytes(size_t bytes);
 	};
 
+	inline size_t MemoryPool::roundUnitSize(size_t size) {
+		// Units fit the free lists size classes when they are used, otherwise they only keep the next header aligned
+		if (this->useFreeLists) return size == 0 ? MEMORYPOOL_FREELIST_GRANULARITY : (size + MEMORYPOOL_FREELIST_GRANULARITY - 1) & ~(size_t)(MEMORYPOOL_FREELIST_GRANULARITY - 1);
+		// Every unit can hold the link of the remote frees queue
+		if (size < sizeof(void*)) return sizeof(void*);
+		return (size + alignof(SMemoryUnitHeader) - 1) & ~(size_t)(alignof(SMemoryUnitHeader) - 1);
+	}
+
+	inline void MemoryPool::recordAllocation([[maybe_unused]] size_t size, [[maybe_unused]] size_t count) {
+#ifndef MEMORYPOOL_DISABLE_STATS
+		// Requested sizes are counted by their highest bit, the last bin holds everything bigger
+		size_t bin = 0;
+#if defined(__GNUC__) || defined(__clang__)
+		if (size > 1) bin = sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(size);
+#else
+		while ((size >> bin) > 1) bin++;
+#endif
+		if (bin >= MEMORYPOOL_STATS_HISTOGRAM_BINS) bin = MEMORYPOOL_STATS_HISTOGRAM_BINS - 1;
+		this->stats.sizeHistogram[bin] += count;
+		this->stats.allocations += count;
+#endif
+	}
+
+	inline void MemoryPool::recordFree([[maybe_unused]] size_t bytes, [[maybe_unused]] size_t count) {
+#ifndef MEMORYPOOL_DISABLE_STATS
+		this->stats.frees += count;
+		this->stats.bytesUsed -= bytes;
+#endif
+	}
+
+	inline void MemoryPool::addUsedBytes([[maybe_unused]] size_t bytes) {
+#ifndef MEMORYPOOL_DISABLE_STATS
+		this->stats.bytesUsed += bytes;
+		if (this->stats.bytesUsed > this->stats.peakBytesUsed) this->stats.peakBytesUsed = this->stats.bytesUsed;
+#endif
+	}
+
+	inline void MemoryPool::removeUsedBytes([[maybe_unused]] size_t bytes) {
+#ifndef MEMORYPOOL_DISABLE_STATS
+		this->stats.bytesUsed -= bytes;
+#endif
+	}
+
+	inline void MemoryPool::addReservedBytes([[maybe_unused]] size_t bytes) {
+#ifndef MEMORYPOOL_DISABLE_STATS
+		this->stats.blocksCreated++;
+		this->stats.bytesReserved += bytes;
+		if (this->stats.bytesReserved > this->stats.peakBytesReserved) this->stats.peakBytesReserved = this->stats.bytesReserved;
+#endif
+	}
+
+	inline void MemoryPool::removeReservedBytes([[maybe_unused]] size_t bytes) {
+#ifndef MEMORYPOOL_DISABLE_STATS
+		this->stats.blocksFreed++;
+		this->stats.bytesReserved -= bytes;
+#endif
+	}
+
+	inline void* MemoryPool::placeUnit(SMemoryBlockHeader* block, size_t size) {
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(block) + sizeof(SMemoryBlockHeader) + block->offset);
+		unit->length = size;
+		setContainer(unit, block);
+		block->numberOfAllocated++;
+		block->offset += sizeof(SMemoryUnitHeader) + size;
+		this->addUsedBytes(sizeof(SMemoryUnitHeader) + size);
+
+		return reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader);
+	}
+
+	inline size_t MemoryPool::getTailSpace(SMemoryBlockHeader* block) {
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+		// Units must start inside the first aligned window of their block
+		if (sizeof(SMemoryBlockHeader) + block->offset >= MEMORYPOOL_BLOCK_ALIGNMENT) return 0;
+#endif
+		return block->blockSize - block->offset;
+	}
+
+	inline size_t MemoryPool::getSpaceBin(size_t space) {
+		size_t bin = 0;
+#if defined(__GNUC__) || defined(__clang__)
+		if (space > 1) bin = sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(space);
+#else
+		while ((space >> bin) > 1) bin++;
+#endif
+		return bin < MEMORYPOOL_SPACE_BINS ? bin : MEMORYPOOL_SPACE_BINS - 1;
+	}
+
+	inline void MemoryPool::updateBlockSpace(SMemoryBlockHeader* block) {
+		if (block->spaceBin == SIZE_MAX || block->spaceBin == getSpaceBin(getTailSpace(block))) return;
+		this->unindexBlock(block);
+		this->indexBlock(block);
+	}
+
+	inline bool MemoryPool::isLastUnit(SMemoryBlockHeader* block, SMemoryUnitHeader* unit) {
+		return reinterpret_cast<char*>(block) + sizeof(SMemoryBlockHeader) + block->offset == reinterpret_cast<char*>(unit) + sizeof(SMemoryUnitHeader) + unit->length;
+	}
+
+	inline void* MemoryPool::allocate(size_t size) {
+#ifdef MEMORYPOOL_TRACING
+		if (this->trace != nullptr && this->trace->depth == 0) return this->tracedAllocate(size, 0);
+#endif
+		this->recordAllocation(size);
+		size = this->roundUnitSize(size);
+
+		// Move the offset of the current block when there is space & no deleted unit can be reused
+		if (MEMORYPOOL_LIKELY((!this->useFreeLists || this->currentScope != nullptr) && this->fitsCurrentBlock(size)))
+			return this->placeUnit(this->currentBlock, size);
+
+		return this->allocateSlow(size);
+	}
+
+	inline void* MemoryPool::reallocate(void* unit_pointer_start, size_t new_size) {
+		return this->reallocateAligned(unit_pointer_start, new_size, alignof(SMemoryUnitHeader));
+	}
+
+	inline void* MemoryPool::reallocateAligned(void* unit_pointer_start, size_t new_size, size_t alignment) {
+		if (unit_pointer_start == nullptr) return nullptr;
+#ifdef MEMORYPOOL_TRACING
+		if (this->trace != nullptr && this->trace->depth == 0) return this->tracedReallocate(unit_pointer_start, new_size, alignment);
+#endif
+
+		// Find unit
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
+		SMemoryBlockHeader* block = getContainer(unit);
+		new_size = this->roundUnitSize(new_size);
+
+		// The length of a unit is its capacity, it is only given back by tryExpand
+		if (new_size <= unit->length) return unit_pointer_start;
+
+		// If last in block && enough space in block, then reset length
+		if (MEMORYPOOL_LIKELY(isLastUnit(block, unit) && block->blockSize > block->offset + new_size - unit->length)) {
+			block->offset += new_size - unit->length;
+			this->addUsedBytes(new_size - unit->length);
+			unit->length = new_size;
+			this->updateBlockSpace(block);
+
+			return unit_pointer_start;
+		}
+
+		return this->reallocateSlow(unit_pointer_start, new_size, alignment);
+	}
+
+	inline void MemoryPool::free(void* unit_pointer_start) {
+		if (unit_pointer_start == nullptr) return;
+#ifdef MEMORYPOOL_TRACING
+		if (this->trace != nullptr && this->trace->depth == 0) return this->tracedFree(unit_pointer_start);
+#endif
+
+		// Find unit
+		SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
+		SMemoryBlockHeader* block = getContainer(unit);
+		this->recordFree(sizeof(SMemoryUnitHeader) + unit->length);
+		if (!MEMORYPOOL_LIKELY(isLastUnit(block, unit))) {
+			this->freeSlow(unit, block);
+			return;
+		}
+
+		// If last in block, then reset offset
+		block->offset -= sizeof(SMemoryUnitHeader) + unit->length;
+		block->numberOfAllocated--;
+
+		// If block offset is 0 remove block if not the only one left
+		if (this->currentBlock != this->firstBlock && (block->offset == 0 || block->numberOfAllocated == block->numberOfDeleted))
+			this->releaseMemoryBlock(block);
+		else this->updateBlockSpace(block);
+	}
+
+	inline void* MemoryPool::allocateWithCapacity(size_t size, size_t capacity) {
+		return this->allocate(size > capacity ? size : capacity);
+	}
+
+	inline size_t MemoryPool::getCapacity(void* unit_pointer_start) {
+		return (reinterpret_cast<SMemoryUnitHeader*>(unit_pointer_start) - 1)->length & MEMORYPOOL_UNIT_LENGTH_MASK;
+	}
+
 	template<typename T>
 	inline T* MemoryPool::allocate(size_t instances) {
-		return reinterpret_cast<T*>(this->allocate(instances * sizeof(T)));
+		return reinterpret_cast<T*>(this->allocateAligned(instances * sizeof(T), alignof(T)));
 	}
 
 	template<typename T>
 	inline T* MemoryPool::reallocate(T* unit_pointer_start, size_t instances) {
-		return reinterpret_cast<T*>(this->reallocate(reinterpret_cast<void*>(unit_pointer_start), instances * sizeof(T)));
+		return reinterpret_cast<T*>(this->reallocateAligned(reinterpret_cast<void*>(unit_pointer_start), instances * sizeof(T), alignof(T)));
 	}
+
+	template<typename T, typename... Arguments>
+	inline T* MemoryPool::make(Arguments&&... arguments) {
+		if (std::is_trivially_destructible<T>::value || this->currentScope == nullptr)
+			return new (this->allocate<T>(1)) T(std::forward<Arguments>(arguments)...);
+
+		// The finalizer is stored right before the object, in the same unit
+		constexpr size_t alignment = alignof(T) > alignof(SMemoryScopeFinalizer) ? alignof(T) : alignof(SMemoryScopeFinalizer);
+		char* unit_pointer_start = reinterpret_cast<char*>(this->allocateAligned(getFinalizedObjectOffset<T>() + sizeof(T), alignment));
+		T* object;
+		try {
+			object = new (unit_pointer_start + getFinalizedObjectOffset<T>()) T(std::forward<Arguments>(arguments)...);
+		}
+		catch (...) {
+			this->free(unit_pointer_start);
+			throw;
+		}
+
+		SMemoryScopeFinalizer* finalizer = reinterpret_cast<SMemoryScopeFinalizer*>(unit_pointer_start);
+		finalizer->finalize = &MemoryPool::finalizeObject<T>;
+		finalizer->next = this->currentScope->finalizers;
+		this->currentScope->finalizers = finalizer;
+		return object;
+	}
+
+	/**
+	 * Starts a scope in a pool when created & ends it when destroyed.
+	 * Scopes started after it and still open are ended with it.
+	 */
+	class ScopeGuard {
+	public:
+		/**
+		 * Start a scope
+		 *
+		 * @param MemoryPool* mp Memory pool to start the scope in
+		 */
+		explicit ScopeGuard(MemoryPool* mp) : mp(mp) {
+			mp->startScope();
+			this->scope = mp->currentScope;
+		}
+
+		// End the scope, unless it was already ended by endScope
+		~ScopeGuard() {
+			SMemoryScopeHeader* open_scope = this->mp->currentScope;
+			while (open_scope != nullptr && open_scope != this->scope) open_scope = open_scope->prevScope;
+			if (open_scope == nullptr) return;
+
+			while (this->mp->currentScope != this->scope) this->mp->endScope();
+			this->mp->endScope();
+		}
+
+		ScopeGuard(const ScopeGuard&) = delete;
+		ScopeGuard& operator=(const ScopeGuard&) = delete;
+
+		// Construct an object destroyed by the end of the scope, see MemoryPool::make
+		template<typename T, typename... Arguments>
+		T* make(Arguments&&... arguments) {
+			return this->mp->make<T>(std::forward<Arguments>(arguments)...);
+		}
+
+		// Pool of the scope
+		MemoryPool* getPool() const { return this->mp; }
+
+	private:
+		MemoryPool* mp;
+		SMemoryScopeHeader* scope;
+	};
 }
 
 // Override new operators to create with memory pool
 extern void* operator new(size_t size, AppShift::Memory::MemoryPool* mp);
-extern void* operator new[](size_t size, AppShift::Memory::MemoryPool* mp);
\ No newline at end of file
+extern void* operator new[](size_t size, AppShift::Memory::MemoryPool* mp);
+extern void* operator new(size_t size, std::align_val_t alignment, AppShift::Memory::MemoryPool* mp);
+extern void* operator new[](size_t size, std::align_val_t alignment, AppShift::Memory::MemoryPool* mp);
\ No newline at end of file
@@ -0,0 +1,114 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+
+#include "MemoryPool.h"
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+namespace AppShift::Memory {
+	/**
+	 * A polymorphic memory resource allocating from a memory pool, for the std::pmr containers.
+	 * The resource doesn't own the pool, which must outlive it & the containers using it.
+	 */
+	class MemoryPoolResource : public std::pmr::memory_resource {
+	public:
+		/**
+		 * Creates a memory resource over a memory pool
+		 *
+		 * @param MemoryPool* pool Memory pool to allocate from
+		 */
+		explicit MemoryPoolResource(MemoryPool* pool) noexcept : pool(pool) {}
+
+		// Get the memory pool of the resource
+		MemoryPool* getPool() const noexcept { return this->pool; }
+
+	protected:
+		// Containers expect std::bad_alloc when memory can't be allocated
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			try { return this->pool->allocateAligned(bytes, alignment); }
+			catch (EMemoryErrors) { throw std::bad_alloc(); }
+		}
+
+		// Units carry their own length, so the size & alignment are not needed
+		void do_deallocate(void* unit_pointer_start, size_t, size_t) override {
+			this->pool->free(unit_pointer_start);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			if (this == &other) return true;
+			const MemoryPoolResource* other_resource = dynamic_cast<const MemoryPoolResource*>(&other);
+			return other_resource != nullptr && other_resource->pool == this->pool;
+		}
+
+	private:
+		MemoryPool* pool;
+	};
+
+	/**
+	 * A stateful allocator allocating from a memory pool, for containers using the classic allocator model.
+	 * Allocators of the same pool are equal, and the pool moves with the containers on move & swap.
+	 */
+	template<typename T>
+	class MemoryPoolAllocator {
+	public:
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		/**
+		 * Creates an allocator over a memory pool
+		 *
+		 * @param MemoryPool* pool Memory pool to allocate from
+		 */
+		explicit MemoryPoolAllocator(MemoryPool* pool) noexcept : pool(pool) {}
+
+		// Rebinding copy
+		template<typename U>
+		MemoryPoolAllocator(const MemoryPoolAllocator<U>& other) noexcept : pool(other.getPool()) {}
+
+		// Get the memory pool of the allocator
+		MemoryPool* getPool() const noexcept { return this->pool; }
+
+		T* allocate(size_t instances) {
+			try { return this->pool->allocate<T>(instances); }
+			catch (EMemoryErrors) { throw std::bad_alloc(); }
+		}
+
+		void deallocate(T* unit_pointer_start, size_t) {
+			this->pool->free(unit_pointer_start);
+		}
+
+	private:
+		MemoryPool* pool;
+	};
+
+	template<typename T, typename U>
+	inline bool operator==(const MemoryPoolAllocator<T>& first, const MemoryPoolAllocator<U>& second) noexcept {
+		return first.getPool() == second.getPool();
+	}
+
+	template<typename T, typename U>
+	inline bool operator!=(const MemoryPoolAllocator<T>& first, const MemoryPoolAllocator<U>& second) noexcept {
+		return first.getPool() != second.getPool();
+	}
+}
@@ -0,0 +1,214 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include "MemoryPoolImage.h"
+#include <algorithm>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+	size_t getPageSize() {
+		static size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return page_size;
+	}
+
+	// Write a whole buffer at an offset of a file, false on failure
+	bool writeAt(int descriptor, const void* data, size_t size, size_t offset) {
+		const char* bytes = reinterpret_cast<const char*>(data);
+		while (size != 0) {
+			ssize_t written = pwrite(descriptor, bytes, size, offset);
+			if (written <= 0) return false;
+			bytes += written;
+			size -= written;
+			offset += written;
+		}
+		return true;
+	}
+
+	// Read a whole buffer at an offset of a file, false on failure
+	bool readAt(int descriptor, void* data, size_t size, size_t offset) {
+		char* bytes = reinterpret_cast<char*>(data);
+		while (size != 0) {
+			ssize_t read_bytes = pread(descriptor, bytes, size, offset);
+			if (read_bytes <= 0) return false;
+			bytes += read_bytes;
+			size -= read_bytes;
+			offset += read_bytes;
+		}
+		return true;
+	}
+}
+
+void AppShift::Memory::MemoryPoolImage::save(const MemoryPool& pool, const char* path, const void* root)
+{
+	size_t page_size = getPageSize();
+
+	// Blocks sorted by address, only their used part is saved
+	std::vector<SMemoryBlockHeader*> blocks;
+	for (SMemoryBlockHeader* block = pool.firstBlock; block != nullptr; block = block->next) blocks.push_back(block);
+	std::sort(blocks.begin(), blocks.end(), std::less<SMemoryBlockHeader*>());
+
+	// Blocks sharing pages, or on pages next to each other, are saved as one segment
+	std::vector<SMemoryPoolImageSegment> segments;
+	std::vector<size_t> first_blocks;
+	for (size_t i = 0; i < blocks.size(); i++) {
+		uintptr_t start = reinterpret_cast<uintptr_t>(blocks[i]) & ~(uintptr_t)(page_size - 1);
+		uintptr_t end = (reinterpret_cast<uintptr_t>(blocks[i] + 1) + blocks[i]->offset + page_size - 1) & ~(uintptr_t)(page_size - 1);
+		if (!segments.empty() && start <= segments.back().savedAddress + segments.back().size) {
+			if (end > segments.back().savedAddress + segments.back().size) segments.back().size = end - segments.back().savedAddress;
+			continue;
+		}
+		segments.push_back({ start, end - start, 0 });
+		first_blocks.push_back(i);
+	}
+	first_blocks.push_back(blocks.size());
+
+	SMemoryPoolImageHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.version = MEMORYPOOL_IMAGE_VERSION;
+	header.pointerSize = sizeof(void*);
+	header.blockHeaderSize = sizeof(SMemoryBlockHeader);
+	header.unitHeaderSize = sizeof(SMemoryUnitHeader);
+	header.pageSize = page_size;
+	header.firstBlock = reinterpret_cast<uintptr_t>(pool.firstBlock);
+	header.root = reinterpret_cast<uintptr_t>(root);
+	header.segmentCount = segments.size();
+
+	// Segments start on pages of the file so they can be mapped
+	size_t file_offset = (sizeof(SMemoryPoolImageHeader) + segments.size() * sizeof(SMemoryPoolImageSegment) + page_size - 1) & ~(page_size - 1);
+	for (SMemoryPoolImageSegment& segment : segments) {
+		segment.fileOffset = file_offset;
+		file_offset += segment.size;
+	}
+
+	int descriptor = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (descriptor < 0) throw EMemoryErrors::CANNOT_WRITE_POOL_IMAGE;
+
+	// The bytes between the blocks of a segment are left as holes of the file, which read as zeros
+	bool written = ftruncate(descriptor, file_offset) == 0
+		&& writeAt(descriptor, &header, sizeof(header), 0)
+		&& writeAt(descriptor, segments.data(), segments.size() * sizeof(SMemoryPoolImageSegment), sizeof(header));
+	for (size_t i = 0; written && i < segments.size(); i++) {
+		for (size_t j = first_blocks[i]; written && j < first_blocks[i + 1]; j++) {
+			size_t block_offset = reinterpret_cast<uintptr_t>(blocks[j]) - segments[i].savedAddress;
+			written = writeAt(descriptor, blocks[j], sizeof(SMemoryBlockHeader) + blocks[j]->offset, segments[i].fileOffset + block_offset);
+		}
+	}
+
+	// Mark the image complete
+	header.magic = MEMORYPOOL_IMAGE_MAGIC;
+	written = written && fsync(descriptor) == 0 && writeAt(descriptor, &header.magic, sizeof(header.magic), 0);
+	if (close(descriptor) != 0 || !written) throw EMemoryErrors::CANNOT_WRITE_POOL_IMAGE;
+}
+
+AppShift::Memory::MemoryPoolImage::MemoryPoolImage(const char* path, bool writable)
+{
+	this->relocated = false;
+
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor < 0) throw EMemoryErrors::CANNOT_MAP_POOL_IMAGE;
+
+	struct stat file_status;
+	if (fstat(descriptor, &file_status) != 0) {
+		close(descriptor);
+		throw EMemoryErrors::CANNOT_MAP_POOL_IMAGE;
+	}
+	size_t file_size = static_cast<size_t>(file_status.st_size);
+
+	// Only images of the same layout can be used without converting them
+	if (file_size < sizeof(this->header) || !readAt(descriptor, &this->header, sizeof(this->header), 0)
+		|| this->header.magic != MEMORYPOOL_IMAGE_MAGIC || this->header.version != MEMORYPOOL_IMAGE_VERSION
+		|| this->header.pointerSize != sizeof(void*) || this->header.blockHeaderSize != sizeof(SMemoryBlockHeader)
+		|| this->header.unitHeaderSize != sizeof(SMemoryUnitHeader) || this->header.pageSize != getPageSize()
+		|| this->header.segmentCount > (file_size - sizeof(this->header)) / sizeof(SMemoryPoolImageSegment)) {
+		close(descriptor);
+		throw EMemoryErrors::INVALID_POOL_IMAGE;
+	}
+	this->segments.resize(this->header.segmentCount);
+	if (!readAt(descriptor, this->segments.data(), this->segments.size() * sizeof(SMemoryPoolImageSegment), sizeof(this->header))) {
+		close(descriptor);
+		throw EMemoryErrors::INVALID_POOL_IMAGE;
+	}
+
+	// Every segment must be a page aligned part of the file
+	for (const SMemoryPoolImageSegment& segment : this->segments) {
+		if (segment.size == 0 || segment.size > file_size || segment.fileOffset > file_size - segment.size
+			|| segment.fileOffset % this->header.pageSize != 0 || segment.savedAddress % this->header.pageSize != 0) {
+			close(descriptor);
+			throw EMemoryErrors::INVALID_POOL_IMAGE;
+		}
+	}
+
+	// Private mappings, so the file never changes
+	int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+	for (SMemoryPoolImageSegment& segment : this->segments) {
+		void* hint = reinterpret_cast<void*>(segment.savedAddress);
+		void* mapping = MAP_FAILED;
+#ifdef MAP_FIXED_NOREPLACE
+		// Take the saved addresses only if nothing is mapped there
+		mapping = mmap(hint, segment.size, protection, MAP_PRIVATE | MAP_FIXED_NOREPLACE, descriptor, segment.fileOffset);
+#endif
+		if (mapping == MAP_FAILED) mapping = mmap(hint, segment.size, protection, MAP_PRIVATE, descriptor, segment.fileOffset);
+		if (mapping == MAP_FAILED) {
+			close(descriptor);
+			for (size_t i = 0; i < this->mappings.size(); i++) munmap(this->mappings[i], this->segments[i].size);
+			throw EMemoryErrors::CANNOT_MAP_POOL_IMAGE;
+		}
+
+		if (mapping != hint) this->relocated = true;
+		this->mappings.push_back(reinterpret_cast<char*>(mapping));
+	}
+	close(descriptor);
+}
+
+AppShift::Memory::MemoryPoolImage::~MemoryPoolImage()
+{
+	for (size_t i = 0; i < this->mappings.size(); i++) munmap(this->mappings[i], this->segments[i].size);
+}
+
+void* AppShift::Memory::MemoryPoolImage::translate(const void* saved_pointer) const
+{
+	if (saved_pointer == nullptr) return nullptr;
+	uintptr_t address = reinterpret_cast<uintptr_t>(saved_pointer);
+
+	// Segments are sorted by their saved address
+	size_t low = 0, high = this->segments.size();
+	while (low < high) {
+		size_t middle = (low + high) / 2;
+		if (this->segments[middle].savedAddress + this->segments[middle].size <= address) low = middle + 1;
+		else high = middle;
+	}
+	if (low == this->segments.size() || address < this->segments[low].savedAddress) return nullptr;
+
+	return this->mappings[low] + (address - this->segments[low].savedAddress);
+}
+
+void* AppShift::Memory::MemoryPoolImage::getRoot() const
+{
+	return this->translate(reinterpret_cast<const void*>(this->header.root));
+}
+
+bool AppShift::Memory::MemoryPoolImage::isRelocated() const
+{
+	return this->relocated;
+}
@@ -0,0 +1,124 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_IMAGE_MAGIC 0x474D494C4F4F5050ULL
+#define MEMORYPOOL_IMAGE_VERSION 1
+
+#include "MemoryPool.h"
+#include <vector>
+
+namespace AppShift::Memory {
+	// Pages of a saved pool stored together, holding one or more blocks next to each other in memory
+	struct SMemoryPoolImageSegment {
+		// Page aligned address the segment had in the saved pool
+		uintptr_t savedAddress;
+		size_t size;
+
+		// Page aligned offset of the segment in the file
+		size_t fileOffset;
+	};
+
+	// Header at the start of a pool image file, followed by the segments table
+	struct SMemoryPoolImageHeader {
+		// Identification of the format, the magic is written last so partial files are rejected
+		uint64_t magic;
+		uint32_t version;
+
+		// Layout of the saved pool, must match the loading process
+		uint32_t pointerSize;
+		uint32_t blockHeaderSize;
+		uint32_t unitHeaderSize;
+		size_t pageSize;
+
+		// Saved addresses of the pool data
+		uintptr_t firstBlock;
+		uintptr_t root;
+
+		size_t segmentCount;
+	};
+
+	/**
+	 * The blocks of a pool saved to a file & mapped back without reading them.
+	 * The segments are mapped at the addresses they had in the saved pool when these are free,
+	 * so the pointers stored in the pool data stay valid. Otherwise they are mapped elsewhere
+	 * & saved pointers must be passed through translate.
+	 */
+	class MemoryPoolImage {
+	public:
+		/**
+		 * Save the blocks of a pool to a file
+		 *
+		 * @param const MemoryPool& pool Pool to save, must not change while it is saved
+		 * @param const char* path Path of the file, replaced if it exists
+		 * @param const void* root Object of the pool to find when the image is mapped, see getRoot
+		 */
+		static void save(const MemoryPool& pool, const char* path, const void* root = nullptr);
+
+		/**
+		 * Map a saved pool, throws INVALID_POOL_IMAGE if the file is not an image of the same version & layout
+		 *
+		 * @param const char* path Path of the file
+		 * @param bool writable Map the pages copy-on-write instead of read-only, changes are never written to the file
+		 */
+		MemoryPoolImage(const char* path, bool writable = false);
+		MemoryPoolImage(const MemoryPoolImage&) = delete;
+		MemoryPoolImage& operator=(const MemoryPoolImage&) = delete;
+		// Unmaps the segments, pointers to the data are invalid after
+		~MemoryPoolImage();
+
+		SMemoryPoolImageHeader header;
+		std::vector<SMemoryPoolImageSegment> segments;
+		// Start of each segment in this process, ordered like the segments
+		std::vector<char*> mappings;
+		bool relocated;
+
+		/**
+		 * Convert a pointer of the saved pool to the same place in the mapped image
+		 *
+		 * @param const void* saved_pointer Pointer into the saved pool, nullptr gives nullptr
+		 *
+		 * @returns void* Pointer in this process, nullptr if it is not in the image
+		 */
+		void* translate(const void* saved_pointer) const;
+
+		// Templated translation
+		template<typename T>
+		T* translate(const T* saved_pointer) const;
+
+		/**
+		 * Get the object passed to save
+		 *
+		 * @returns void* Object in the mapped image, nullptr if none
+		 */
+		void* getRoot() const;
+
+		/**
+		 * Check if the image is mapped at the addresses of the saved pool
+		 *
+		 * @returns bool False if pointers in the data can be used directly, true if they must be translated
+		 */
+		bool isRelocated() const;
+	};
+
+	template<typename T>
+	inline T* MemoryPoolImage::translate(const T* saved_pointer) const {
+		return reinterpret_cast<T*>(this->translate(reinterpret_cast<const void*>(saved_pointer)));
+	}
+}
@@ -0,0 +1,290 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_TRACE_VERSION 1
+#define MEMORYPOOL_TRACE_BUFFER_SIZE 64 * 1024
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace AppShift::Memory {
+	// Calls to a pool stored in a trace
+	enum class ETraceEvent : uint8_t {
+		ALLOCATE,
+		REALLOCATE,
+		FREE,
+		START_SCOPE,
+		END_SCOPE
+	};
+
+	// Header at the start of a trace file
+	struct STraceFileHeader {
+		char magic[8];
+		uint32_t version;
+		// Whether the pool used free lists when the trace started
+		uint32_t freeLists;
+		uint64_t defaultBlockSize;
+	};
+
+	// A call to a pool read from a trace, addresses are the ones returned to the traced program
+	struct STraceEvent {
+		ETraceEvent type;
+		uint32_t thread;
+		// Nanoseconds since the trace started
+		uint64_t time;
+		uint64_t address;
+		uint64_t newAddress;
+		uint64_t size;
+		// Alignment requested, 0 for plain allocations
+		uint64_t alignment;
+	};
+
+	/**
+	 * Get a small number identifying the calling thread in traces, given by order of first use
+	 *
+	 * @returns uint32_t Number of the calling thread
+	 */
+	inline uint32_t getTraceThread() {
+		static std::atomic<uint32_t> nextThread(0);
+		thread_local uint32_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+		return thread;
+	}
+
+	/**
+	 * Writes the calls to a pool into a compact binary file.
+	 * Every event is a type byte followed by variable length integers: the thread, the time since
+	 * the previous event, and the sizes & addresses of the event. Addresses are stored as the
+	 * difference from the previous address, which keeps most of them to a few bytes.
+	 */
+	class MemoryPoolTraceWriter {
+	public:
+		/**
+		 * Creates the trace file & writes its header
+		 *
+		 * @param const char* path Path of the trace file, replaced if it exists
+		 * @param size_t default_block_size Default block size of the traced pool
+		 * @param bool free_lists Whether the traced pool uses free lists
+		 */
+		MemoryPoolTraceWriter(const char* path, size_t default_block_size, bool free_lists) {
+			this->file = std::fopen(path, "wb");
+			this->used = 0;
+			this->depth = 0;
+			this->lastAddress = 0;
+			this->lastTime = std::chrono::steady_clock::now();
+			if (this->file == nullptr) return;
+
+			STraceFileHeader header;
+			std::memcpy(header.magic, "MPTRACE", 8);
+			header.version = MEMORYPOOL_TRACE_VERSION;
+			header.freeLists = free_lists ? 1 : 0;
+			header.defaultBlockSize = default_block_size;
+			std::fwrite(&header, sizeof(header), 1, this->file);
+		}
+
+		// Writes the buffered events & closes the file
+		~MemoryPoolTraceWriter() {
+			if (this->file == nullptr) return;
+			this->flush();
+			std::fclose(this->file);
+		}
+
+		MemoryPoolTraceWriter(const MemoryPoolTraceWriter&) = delete;
+		MemoryPoolTraceWriter& operator=(const MemoryPoolTraceWriter&) = delete;
+
+		// Whether the file could be created
+		bool isOpen() const { return this->file != nullptr; }
+
+		// Calls of the pool in progress, calls made by other calls are not traced
+		size_t depth;
+
+		/**
+		 * Add an event to the trace
+		 *
+		 * @param ETraceEvent type Type of the event
+		 * @param const void* address Unit allocated, re-allocated or freed
+		 * @param size_t size Size requested
+		 * @param size_t alignment Alignment requested, 0 for plain allocations
+		 * @param const void* new_address Unit returned by a re-allocation
+		 */
+		void record(ETraceEvent type, const void* address = nullptr, size_t size = 0, size_t alignment = 0, const void* new_address = nullptr) {
+			if (this->used + 64 > MEMORYPOOL_TRACE_BUFFER_SIZE) this->flush();
+
+			auto now = std::chrono::steady_clock::now();
+			this->buffer[this->used++] = static_cast<uint8_t>(type);
+			this->writeNumber(getTraceThread());
+			this->writeNumber(std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->lastTime).count());
+			this->lastTime = now;
+
+			switch (type) {
+			case ETraceEvent::ALLOCATE:
+				this->writeNumber(size);
+				this->writeNumber(alignment);
+				this->writeAddress(address);
+				break;
+			case ETraceEvent::REALLOCATE:
+				this->writeAddress(address);
+				this->writeNumber(size);
+				this->writeNumber(alignment);
+				this->writeAddress(new_address);
+				break;
+			case ETraceEvent::FREE:
+				this->writeAddress(address);
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Write the buffered events to the file
+		void flush() {
+			if (this->file != nullptr && this->used != 0) std::fwrite(this->buffer, 1, this->used, this->file);
+			this->used = 0;
+		}
+
+	private:
+		std::FILE* file;
+		uint8_t buffer[MEMORYPOOL_TRACE_BUFFER_SIZE];
+		size_t used;
+		uint64_t lastAddress;
+		std::chrono::steady_clock::time_point lastTime;
+
+		// Write 7 bits per byte, the high bit is set when more bytes follow
+		void writeNumber(uint64_t number) {
+			while (number >= 0x80) {
+				this->buffer[this->used++] = static_cast<uint8_t>(number | 0x80);
+				number >>= 7;
+			}
+			this->buffer[this->used++] = static_cast<uint8_t>(number);
+		}
+
+		// Write the difference from the previous address, with the sign in the lowest bit
+		void writeAddress(const void* address) {
+			uint64_t value = reinterpret_cast<uintptr_t>(address);
+			int64_t difference = static_cast<int64_t>(value - this->lastAddress);
+			this->writeNumber((static_cast<uint64_t>(difference) << 1) ^ static_cast<uint64_t>(difference >> 63));
+			this->lastAddress = value;
+		}
+	};
+
+	// Marks a call of a traced pool as in progress, so the calls it makes are not traced
+	struct STraceDepthGuard {
+		MemoryPoolTraceWriter* trace;
+		explicit STraceDepthGuard(MemoryPoolTraceWriter* trace) : trace(trace) { this->trace->depth++; }
+		~STraceDepthGuard() { this->trace->depth--; }
+	};
+
+	// Reads the events of a trace file written by MemoryPoolTraceWriter
+	class MemoryPoolTraceReader {
+	public:
+		/**
+		 * Opens a trace file & reads its header
+		 *
+		 * @param const char* path Path of the trace file
+		 */
+		explicit MemoryPoolTraceReader(const char* path) {
+			this->file = std::fopen(path, "rb");
+			this->time = 0;
+			this->lastAddress = 0;
+			this->valid = false;
+			if (this->file == nullptr) return;
+
+			this->valid = std::fread(&this->header, sizeof(this->header), 1, this->file) == 1
+				&& std::memcmp(this->header.magic, "MPTRACE", 8) == 0 && this->header.version == MEMORYPOOL_TRACE_VERSION;
+		}
+
+		~MemoryPoolTraceReader() {
+			if (this->file != nullptr) std::fclose(this->file);
+		}
+
+		MemoryPoolTraceReader(const MemoryPoolTraceReader&) = delete;
+		MemoryPoolTraceReader& operator=(const MemoryPoolTraceReader&) = delete;
+
+		// Whether the file exists & is a trace of the same version
+		bool isValid() const { return this->valid; }
+
+		// Header of the trace
+		STraceFileHeader header;
+
+		/**
+		 * Read the next event of the trace
+		 *
+		 * @param STraceEvent& event Event to fill
+		 *
+		 * @returns bool False at the end of the trace or if it is truncated
+		 */
+		bool next(STraceEvent& event) {
+			if (!this->valid) return false;
+			int type = std::fgetc(this->file);
+			if (type == EOF || type > static_cast<int>(ETraceEvent::END_SCOPE)) return false;
+
+			event = STraceEvent();
+			event.type = static_cast<ETraceEvent>(type);
+			uint64_t thread = 0, time_delta = 0;
+			bool complete = this->readNumber(thread) && this->readNumber(time_delta);
+			event.thread = static_cast<uint32_t>(thread);
+			this->time += time_delta;
+			event.time = this->time;
+
+			switch (event.type) {
+			case ETraceEvent::ALLOCATE:
+				complete = complete && this->readNumber(event.size) && this->readNumber(event.alignment) && this->readAddress(event.address);
+				break;
+			case ETraceEvent::REALLOCATE:
+				complete = complete && this->readAddress(event.address) && this->readNumber(event.size) && this->readNumber(event.alignment) && this->readAddress(event.newAddress);
+				break;
+			case ETraceEvent::FREE:
+				complete = complete && this->readAddress(event.address);
+				break;
+			default:
+				break;
+			}
+			return complete;
+		}
+
+	private:
+		std::FILE* file;
+		bool valid;
+		uint64_t time;
+		uint64_t lastAddress;
+
+		bool readNumber(uint64_t& number) {
+			number = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				int byte = std::fgetc(this->file);
+				if (byte == EOF) return false;
+				number |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) return true;
+			}
+			return false;
+		}
+
+		bool readAddress(uint64_t& address) {
+			uint64_t encoded;
+			if (!this->readNumber(encoded)) return false;
+			int64_t difference = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+			address = this->lastAddress + static_cast<uint64_t>(difference);
+			this->lastAddress = address;
+			return true;
+		}
+	};
+}
@@ -0,0 +1,224 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_OBJECTPOOL_SLAB_SIZE 64 * 1024
+#define MEMORYPOOL_CACHE_LINE_SIZE 64
+
+#include "MemoryPool.h"
+#include <type_traits>
+#include <utility>
+
+namespace AppShift::Memory {
+	/**
+	 * A pool of objects of one type, carving units of a memory pool (slabs) into fixed size slots.
+	 * Slots have no header, and freed slots are linked through their own space so they are
+	 * reused in any order. With cache line packing, slots smaller than a cache line are rounded
+	 * to a power of 2 so no object is split between two cache lines.
+	 * The slabs are given back to the memory pool when the object pool is destroyed or released,
+	 * so they must not be allocated inside a scope of the memory pool that ends before.
+	 */
+	template<typename T, bool CacheLinePacking = true>
+	class ObjectPool {
+	public:
+		/**
+		 * Creates an object pool, slabs are allocated when first needed
+		 *
+		 * @param MemoryPool* pool Memory pool to allocate the slabs from
+		 * @param size_t slab_size Size of a slab in bytes, by default uses MEMORYPOOL_OBJECTPOOL_SLAB_SIZE
+		 */
+		explicit ObjectPool(MemoryPool* pool, size_t slab_size = MEMORYPOOL_OBJECTPOOL_SLAB_SIZE) : pool(pool) {
+			this->slotsPerSlab = slab_size > firstSlotOffset + slotSize ? (slab_size - firstSlotOffset) / slotSize : 1;
+			this->firstSlab = this->currentSlab = nullptr;
+			this->reset();
+		}
+
+		// Give the slabs back to the memory pool, objects left are not destroyed
+		~ObjectPool() { this->release(); }
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		/**
+		 * Take a slot for an object without constructing it
+		 *
+		 * @returns T* Pointer to the slot
+		 */
+		T* allocate() {
+			if (this->freeSlots != nullptr) {
+				SFreeSlot* slot = this->freeSlots;
+				this->freeSlots = slot->next;
+				this->liveObjects++;
+				return reinterpret_cast<T*>(slot);
+			}
+			if (MEMORYPOOL_LIKELY(this->cursor != this->slabEnd)) {
+				T* slot = reinterpret_cast<T*>(this->cursor);
+				this->cursor += slotSize;
+				this->liveObjects++;
+				return slot;
+			}
+			return this->allocateSlow();
+		}
+
+		/**
+		 * Give back the slot of an object without destroying it.
+		 * When no object is left the slabs are reset, so the next slots are taken in order again.
+		 *
+		 * @param T* object Pointer to the slot, taken from this object pool
+		 */
+		void free(T* object) {
+			if (--this->liveObjects == 0) {
+				this->reset();
+				return;
+			}
+			SFreeSlot* slot = reinterpret_cast<SFreeSlot*>(object);
+			slot->next = this->freeSlots;
+			this->freeSlots = slot;
+		}
+
+		/**
+		 * Construct an object in a slot
+		 *
+		 * @param Arguments&&... arguments Arguments of the constructor
+		 *
+		 * @returns T* Pointer to the new object
+		 */
+		template<typename... Arguments>
+		T* create(Arguments&&... arguments) {
+			T* slot = this->allocate();
+			try {
+				return new (slot) T(std::forward<Arguments>(arguments)...);
+			}
+			catch (...) {
+				this->free(slot);
+				throw;
+			}
+		}
+
+		/**
+		 * Destroy an object & give back its slot
+		 *
+		 * @param T* object Pointer to the object, created by this object pool
+		 */
+		void destroy(T* object) {
+			object->~T();
+			this->free(object);
+		}
+
+		/**
+		 * Make all the slots free at once, keeping the slabs for the next objects.
+		 * Objects left are not destroyed.
+		 */
+		void reset() {
+			this->freeSlots = nullptr;
+			this->liveObjects = 0;
+			this->currentSlab = this->firstSlab;
+			this->setCursor(this->firstSlab);
+		}
+
+		/**
+		 * Give all the slabs back to the memory pool. Objects left are not destroyed.
+		 */
+		void release() {
+			while (this->firstSlab != nullptr) {
+				SSlab* next_slab = this->firstSlab->next;
+				this->pool->free(this->firstSlab);
+				this->firstSlab = next_slab;
+			}
+			this->currentSlab = nullptr;
+			this->reset();
+		}
+
+		// Size of a slot, including the space added by the cache line packing
+		static constexpr size_t getSlotSize() { return slotSize; }
+
+		// Number of slots in a slab
+		size_t getSlotsPerSlab() const { return this->slotsPerSlab; }
+
+		// Number of slots taken
+		size_t getLiveObjects() const { return this->liveObjects; }
+
+		// Memory pool of the slabs
+		MemoryPool* getPool() const { return this->pool; }
+
+	private:
+		// Header of a slab, the slots follow it
+		struct SSlab {
+			SSlab* next;
+		};
+
+		// Free slot, linked through its space
+		struct SFreeSlot {
+			SFreeSlot* next;
+		};
+
+		static constexpr size_t roundUp(size_t size, size_t alignment) {
+			return (size + alignment - 1) & ~(alignment - 1);
+		}
+
+		static constexpr size_t roundUpToPowerOf2(size_t size) {
+			size_t power = 1;
+			while (power < size) power <<= 1;
+			return power;
+		}
+
+		static constexpr size_t slotAlignment = alignof(T) > alignof(SFreeSlot) ? alignof(T) : alignof(SFreeSlot);
+		static constexpr size_t compactSlotSize = roundUp(sizeof(T) > sizeof(SFreeSlot) ? sizeof(T) : sizeof(SFreeSlot), slotAlignment);
+		static constexpr size_t slotSize = CacheLinePacking && compactSlotSize < MEMORYPOOL_CACHE_LINE_SIZE ? roundUpToPowerOf2(compactSlotSize) : compactSlotSize;
+
+		// Packed slots start at a multiple of their size, so slabs start at a cache line
+		static constexpr size_t slabAlignment = CacheLinePacking && slotAlignment < MEMORYPOOL_CACHE_LINE_SIZE ? MEMORYPOOL_CACHE_LINE_SIZE : slotAlignment;
+		static constexpr size_t firstSlotOffset = roundUp(sizeof(SSlab), CacheLinePacking && slotSize < MEMORYPOOL_CACHE_LINE_SIZE ? slotSize : slotAlignment);
+
+		// Bump through the slots of a slab, or stop when there is none
+		void setCursor(SSlab* slab) {
+			this->cursor = slab != nullptr ? reinterpret_cast<char*>(slab) + firstSlotOffset : nullptr;
+			this->slabEnd = slab != nullptr ? this->cursor + this->slotsPerSlab * slotSize : nullptr;
+		}
+
+		// Move to the next slab, creating it if needed
+		MEMORYPOOL_NOINLINE T* allocateSlow() {
+			SSlab* slab = this->currentSlab != nullptr ? this->currentSlab->next : this->firstSlab;
+			if (slab == nullptr) {
+				slab = reinterpret_cast<SSlab*>(this->pool->allocateAligned(firstSlotOffset + this->slotsPerSlab * slotSize, slabAlignment));
+				slab->next = nullptr;
+				if (this->currentSlab != nullptr) this->currentSlab->next = slab;
+				else this->firstSlab = slab;
+			}
+			this->currentSlab = slab;
+			this->setCursor(slab);
+
+			T* slot = reinterpret_cast<T*>(this->cursor);
+			this->cursor += slotSize;
+			this->liveObjects++;
+			return slot;
+		}
+
+		MemoryPool* pool;
+		size_t slotsPerSlab;
+
+		SSlab* firstSlab;
+		SSlab* currentSlab;
+		char* cursor;
+		char* slabEnd;
+
+		SFreeSlot* freeSlots;
+		size_t liveObjects;
+	};
+}
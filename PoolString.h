@@ -0,0 +1,301 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_STRING_LOCAL_CAPACITY 15
+
+#include "MemoryPool.h"
+#include <string_view>
+#include <functional>
+#include <ostream>
+#include <cstring>
+
+namespace AppShift::Memory {
+	/**
+	 * A string allocating its characters from a memory pool.
+	 * Strings of up to MEMORYPOOL_STRING_LOCAL_CAPACITY characters are stored inside the object
+	 * without allocating. Longer strings grow geometrically, in place when the space following
+	 * their unit is free, otherwise they move to a bigger unit.
+	 * Copies are allocated from the pool of the source unless another pool is given, assignments keep
+	 * the pool of the destination. The characters are given back to the pool when the string is
+	 * destroyed, so it must not outlive a scope of the pool it allocated in.
+	 */
+	class PoolString {
+	public:
+		static constexpr size_t npos = std::string_view::npos;
+
+		/**
+		 * Creates an empty string, nothing is allocated until it is longer than MEMORYPOOL_STRING_LOCAL_CAPACITY
+		 *
+		 * @param MemoryPool* pool Memory pool to allocate the characters from
+		 */
+		explicit PoolString(MemoryPool* pool) noexcept : pool(pool), buffer(localBuffer), stringLength(0) {
+			this->localBuffer[0] = '\0';
+		}
+
+		/**
+		 * Creates a string holding a copy of some characters
+		 *
+		 * @param MemoryPool* pool Memory pool to allocate the characters from
+		 * @param std::string_view str Characters to copy
+		 */
+		PoolString(MemoryPool* pool, std::string_view str) : PoolString(pool) { this->append(str.data(), str.size()); }
+
+		// Copy in the pool of the source
+		PoolString(const PoolString& other) : PoolString(other.pool, other.view()) {}
+
+		// Copy in another pool
+		PoolString(const PoolString& other, MemoryPool* pool) : PoolString(pool, other.view()) {}
+
+		// Take the characters of another string, leaving it empty
+		PoolString(PoolString&& other) noexcept : pool(other.pool), stringLength(other.stringLength) { this->take(other); }
+
+		~PoolString() {
+			if (!this->isLocal()) this->pool->free(this->buffer);
+		}
+
+		// Copy into the current capacity when it is enough
+		PoolString& operator=(const PoolString& other) {
+			if (this != &other) this->assign(other.view());
+			return *this;
+		}
+
+		// Strings of other pools are copied, since the characters must stay in the pool of this string
+		PoolString& operator=(PoolString&& other) {
+			if (this == &other) return *this;
+			if (this->pool != other.pool) return this->assign(other.view());
+			if (!this->isLocal()) this->pool->free(this->buffer);
+			this->stringLength = other.stringLength;
+			this->take(other);
+			return *this;
+		}
+
+		PoolString& operator=(std::string_view str) { return this->assign(str); }
+		PoolString& operator+=(std::string_view str) { return this->append(str.data(), str.size()); }
+		PoolString& operator+=(char character) {
+			this->push_back(character);
+			return *this;
+		}
+
+		/**
+		 * Replace the characters of the string, reusing its capacity
+		 *
+		 * @param std::string_view str Characters to copy, can be a part of this string
+		 *
+		 * @returns PoolString& This string
+		 */
+		PoolString& assign(std::string_view str) {
+			if (str.size() > this->capacity()) {
+				// Nothing to keep, so nothing is copied when moving
+				this->stringLength = 0;
+				this->grow(str.size());
+			}
+			std::memmove(this->buffer, str.data(), str.size());
+			this->stringLength = str.size();
+			this->buffer[this->stringLength] = '\0';
+			return *this;
+		}
+
+		/**
+		 * Add characters at the end of the string
+		 *
+		 * @param const char* str Characters to add, can be a part of this string
+		 * @param size_t count Number of characters to add
+		 *
+		 * @returns PoolString& This string
+		 */
+		PoolString& append(const char* str, size_t count) {
+			size_t new_length = this->stringLength + count;
+			if (new_length > this->capacity()) {
+				// Characters of this string are found again after they move
+				std::less_equal<const char*> before;
+				bool inside = before(this->buffer, str) && before(str, this->buffer + this->stringLength);
+				size_t offset = inside ? str - this->buffer : 0;
+				this->grow(this->nextCapacity(new_length));
+				if (inside) str = this->buffer + offset;
+			}
+			std::memcpy(this->buffer + this->stringLength, str, count);
+			this->stringLength = new_length;
+			this->buffer[new_length] = '\0';
+			return *this;
+		}
+
+		PoolString& append(std::string_view str) { return this->append(str.data(), str.size()); }
+
+		// Add a character repeated count times
+		PoolString& append(size_t count, char character) {
+			size_t new_length = this->stringLength + count;
+			if (new_length > this->capacity()) this->grow(this->nextCapacity(new_length));
+			std::memset(this->buffer + this->stringLength, character, count);
+			this->stringLength = new_length;
+			this->buffer[new_length] = '\0';
+			return *this;
+		}
+
+		void push_back(char character) {
+			if (this->stringLength == this->capacity()) this->grow(this->nextCapacity(this->stringLength + 1));
+			this->buffer[this->stringLength++] = character;
+			this->buffer[this->stringLength] = '\0';
+		}
+
+		/**
+		 * Make room for characters without changing the string
+		 *
+		 * @param size_t new_capacity Number of characters the string can hold without allocating
+		 */
+		void reserve(size_t new_capacity) {
+			if (new_capacity > this->capacity()) this->grow(new_capacity);
+		}
+
+		// Change the length, new characters are set to a given character
+		void resize(size_t new_length, char character = '\0') {
+			if (new_length > this->stringLength) this->append(new_length - this->stringLength, character);
+			else {
+				this->stringLength = new_length;
+				this->buffer[new_length] = '\0';
+			}
+		}
+
+		// Empty the string, keeping its capacity
+		void clear() noexcept {
+			this->stringLength = 0;
+			this->buffer[0] = '\0';
+		}
+
+		/**
+		 * Give back the capacity the string doesn't use. Short strings move back inside the object,
+		 * the others shrink their unit in place.
+		 */
+		void shrink_to_fit() {
+			if (this->isLocal()) return;
+			if (this->stringLength <= MEMORYPOOL_STRING_LOCAL_CAPACITY) {
+				char* characters = this->buffer;
+				std::memcpy(this->localBuffer, characters, this->stringLength + 1);
+				this->buffer = this->localBuffer;
+				this->pool->free(characters);
+			}
+			else if (this->pool->tryExpand(this->buffer, this->stringLength + 1)) this->allocatedCapacity = MemoryPool::getCapacity(this->buffer) - 1;
+		}
+
+		/**
+		 * Get a part of the string, allocated from the same pool
+		 *
+		 * @param size_t position Index of the first character
+		 * @param size_t count Maximum number of characters, by default up to the end
+		 *
+		 * @returns PoolString New string with the characters
+		 */
+		PoolString substr(size_t position, size_t count = npos) const { return PoolString(this->pool, this->view().substr(position, count)); }
+
+		size_t find(std::string_view str, size_t position = 0) const noexcept { return this->view().find(str, position); }
+		size_t find(char character, size_t position = 0) const noexcept { return this->view().find(character, position); }
+
+		std::string_view view() const noexcept { return std::string_view(this->buffer, this->stringLength); }
+		operator std::string_view() const noexcept { return this->view(); }
+
+		char* data() noexcept { return this->buffer; }
+		const char* data() const noexcept { return this->buffer; }
+		const char* c_str() const noexcept { return this->buffer; }
+		size_t size() const noexcept { return this->stringLength; }
+		size_t length() const noexcept { return this->stringLength; }
+		bool empty() const noexcept { return this->stringLength == 0; }
+
+		// Number of characters the string can hold without allocating
+		size_t capacity() const noexcept { return this->isLocal() ? MEMORYPOOL_STRING_LOCAL_CAPACITY : this->allocatedCapacity; }
+
+		// Check if the characters are stored inside the object
+		bool isLocal() const noexcept { return this->buffer == this->localBuffer; }
+
+		// Memory pool of the characters
+		MemoryPool* getPool() const noexcept { return this->pool; }
+
+		char& operator[](size_t index) noexcept { return this->buffer[index]; }
+		const char& operator[](size_t index) const noexcept { return this->buffer[index]; }
+		char* begin() noexcept { return this->buffer; }
+		char* end() noexcept { return this->buffer + this->stringLength; }
+		const char* begin() const noexcept { return this->buffer; }
+		const char* end() const noexcept { return this->buffer + this->stringLength; }
+
+		friend bool operator==(const PoolString& left, const PoolString& right) noexcept { return left.view() == right.view(); }
+		friend bool operator==(const PoolString& left, std::string_view right) noexcept { return left.view() == right; }
+		friend bool operator==(std::string_view left, const PoolString& right) noexcept { return left == right.view(); }
+		friend bool operator!=(const PoolString& left, const PoolString& right) noexcept { return left.view() != right.view(); }
+		friend bool operator!=(const PoolString& left, std::string_view right) noexcept { return left.view() != right; }
+		friend bool operator!=(std::string_view left, const PoolString& right) noexcept { return left != right.view(); }
+		friend bool operator<(const PoolString& left, const PoolString& right) noexcept { return left.view() < right.view(); }
+
+		friend std::ostream& operator<<(std::ostream& os, const PoolString& str) { return os << str.view(); }
+
+	private:
+		// Double the capacity, but at least to a given length
+		size_t nextCapacity(size_t min_capacity) const noexcept {
+			size_t doubled = 2 * this->capacity();
+			return doubled > min_capacity ? doubled : min_capacity;
+		}
+
+		// Make room for a given number of characters, growing the unit in place when possible
+		void grow(size_t new_capacity) {
+			if (!this->isLocal() && this->pool->tryExpand(this->buffer, new_capacity + 1)) {
+				this->allocatedCapacity = MemoryPool::getCapacity(this->buffer) - 1;
+				return;
+			}
+
+			char* characters = reinterpret_cast<char*>(this->pool->allocate(new_capacity + 1));
+			std::memcpy(characters, this->buffer, this->stringLength + 1);
+			if (!this->isLocal()) this->pool->free(this->buffer);
+			this->buffer = characters;
+
+			// Units are rounded up, the extra space is capacity too
+			this->allocatedCapacity = MemoryPool::getCapacity(characters) - 1;
+		}
+
+		// Take the characters of another string that has the same pool & length
+		void take(PoolString& other) noexcept {
+			if (other.isLocal()) {
+				this->buffer = this->localBuffer;
+				std::memcpy(this->localBuffer, other.localBuffer, other.stringLength + 1);
+			}
+			else {
+				this->buffer = other.buffer;
+				this->allocatedCapacity = other.allocatedCapacity;
+			}
+			other.buffer = other.localBuffer;
+			other.stringLength = 0;
+			other.localBuffer[0] = '\0';
+		}
+
+		MemoryPool* pool;
+		char* buffer;
+		size_t stringLength;
+
+		// Short strings are stored inside the object, in the space of the capacity of long strings
+		union {
+			size_t allocatedCapacity;
+			char localBuffer[MEMORYPOOL_STRING_LOCAL_CAPACITY + 1];
+		};
+	};
+}
+
+// Hash like std::string_view, for unordered containers
+namespace std {
+	template<>
+	struct hash<AppShift::Memory::PoolString> {
+		size_t operator()(const AppShift::Memory::PoolString& str) const noexcept { return std::hash<std::string_view>()(str.view()); }
+	};
+}
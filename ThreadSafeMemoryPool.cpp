@@ -0,0 +1,154 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include "ThreadSafeMemoryPool.h"
+#include <iostream>
+
+namespace {
+	// Thread slots in use, shared by all the thread safe pools
+	std::mutex threadSlotsLock;
+	bool threadSlotsUsed[MEMORYPOOL_MAX_THREADS] = { false };
+
+	// Holds the slot of a thread and gives it back when the thread exits
+	struct SThreadSlot {
+		size_t index;
+
+		SThreadSlot() {
+			std::lock_guard<std::mutex> lock(threadSlotsLock);
+			for (this->index = 0; this->index < MEMORYPOOL_MAX_THREADS; this->index++)
+				if (!threadSlotsUsed[this->index]) break;
+			if (this->index == MEMORYPOOL_MAX_THREADS) throw AppShift::Memory::EMemoryErrors::OUT_OF_THREAD_SLOTS;
+			threadSlotsUsed[this->index] = true;
+		}
+
+		~SThreadSlot() {
+			std::lock_guard<std::mutex> lock(threadSlotsLock);
+			threadSlotsUsed[this->index] = false;
+		}
+	};
+}
+
+AppShift::Memory::ThreadSafeMemoryPool::ThreadSafeMemoryPool(size_t block_size, MemoryBlockProvider* provider)
+{
+	this->defaultBlockSize = block_size;
+	this->blockProvider = provider;
+	for (size_t i = 0; i < MEMORYPOOL_MAX_THREADS; i++) this->shards[i] = nullptr;
+}
+
+AppShift::Memory::ThreadSafeMemoryPool::~ThreadSafeMemoryPool()
+{
+	for (size_t i = 0; i < MEMORYPOOL_MAX_THREADS; i++) delete this->shards[i];
+}
+
+size_t AppShift::Memory::ThreadSafeMemoryPool::getThreadSlot()
+{
+	thread_local SThreadSlot slot;
+	return slot.index;
+}
+
+AppShift::Memory::MemoryPool* AppShift::Memory::ThreadSafeMemoryPool::getShard()
+{
+	// Only the thread holding the slot creates its shard, so no lock is needed
+	size_t slot = getThreadSlot();
+	if (this->shards[slot] == nullptr) this->shards[slot] = new MemoryPool(this->defaultBlockSize, this->blockProvider);
+	return this->shards[slot];
+}
+
+void* AppShift::Memory::ThreadSafeMemoryPool::allocate(size_t size)
+{
+	return this->allocateAligned(size, alignof(SMemoryUnitHeader));
+}
+
+void* AppShift::Memory::ThreadSafeMemoryPool::allocateAligned(size_t size, size_t alignment)
+{
+	// Remote frees are collected by the shard before a new block is created, they might release blocks
+	return this->getShard()->allocateAligned(size, alignment);
+}
+
+void* AppShift::Memory::ThreadSafeMemoryPool::reallocate(void* unit_pointer_start, size_t new_size)
+{
+	return this->reallocateAligned(unit_pointer_start, new_size, alignof(SMemoryUnitHeader));
+}
+
+void* AppShift::Memory::ThreadSafeMemoryPool::reallocateAligned(void* unit_pointer_start, size_t new_size, size_t alignment)
+{
+	if (unit_pointer_start == nullptr) return nullptr;
+
+	// Find unit
+	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
+	MemoryPool* shard = this->getShard();
+
+	// Units of the calling thread can be re-allocated in place
+	if (MemoryPool::getContainer(unit)->pool == shard) return shard->reallocateAligned(unit_pointer_start, new_size, alignment);
+
+	// Units of other threads are moved to the shard of the calling thread
+	void* temp_point = shard->allocateAligned(new_size, alignment);
+	std::memcpy(temp_point, unit_pointer_start, unit->length < new_size ? unit->length : new_size);
+	MemoryPool::freeRemote(unit_pointer_start);
+
+	return temp_point;
+}
+
+void AppShift::Memory::ThreadSafeMemoryPool::free(void* unit_pointer_start)
+{
+	if (unit_pointer_start == nullptr) return;
+
+	// Find the shard the unit was allocated in
+	SMemoryUnitHeader* unit = reinterpret_cast<SMemoryUnitHeader*>(reinterpret_cast<char*>(unit_pointer_start) - sizeof(SMemoryUnitHeader));
+	MemoryPool* shard = MemoryPool::getContainer(unit)->pool;
+
+	// Free directly in own shard, otherwise leave it to the owner
+	if (shard == this->shards[getThreadSlot()]) shard->free(unit_pointer_start);
+	else shard->pushRemoteFree(unit_pointer_start);
+}
+
+void AppShift::Memory::ThreadSafeMemoryPool::collectRemoteFrees()
+{
+	MemoryPool* shard = this->shards[getThreadSlot()];
+	if (shard != nullptr) shard->collectRemoteFrees();
+}
+
+void AppShift::Memory::ThreadSafeMemoryPool::startScope()
+{
+	this->getShard()->startScope();
+}
+
+void AppShift::Memory::ThreadSafeMemoryPool::endScope()
+{
+	this->getShard()->endScope();
+}
+
+void AppShift::Memory::ThreadSafeMemoryPool::dumpPoolData()
+{
+	for (size_t i = 0; i < MEMORYPOOL_MAX_THREADS; i++) {
+		if (this->shards[i] == nullptr) continue;
+		std::cout << "Shard " << i << ": " << std::endl;
+		this->shards[i]->dumpPoolData();
+	}
+}
+
+// Aligned like the global new, see the operators of the MemoryPool
+void* operator new(size_t size, AppShift::Memory::ThreadSafeMemoryPool* mp) {
+	return mp->allocateAligned(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](size_t size, AppShift::Memory::ThreadSafeMemoryPool* mp) {
+	return mp->allocateAligned(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
@@ -0,0 +1,151 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+#define MEMORYPOOL_MAX_THREADS 256
+
+#include "MemoryPool.h"
+#include <mutex>
+
+namespace AppShift::Memory {
+	class ThreadSafeMemoryPool {
+	public:
+		/**
+		 * Creates a memory pool that can be shared between threads.
+		 * Every thread allocates from its own shard, created on first use.
+		 *
+		 * @param size_t block_size Defines the default size of a block in each shard, by default uses MEMORYPOOL_DEFAULT_BLOCK_SIZE
+		 * @param MemoryBlockProvider* provider Source of the memory of the blocks, must be thread safe. By default uses malloc
+		 */
+		ThreadSafeMemoryPool(size_t block_size = MEMORYPOOL_DEFAULT_BLOCK_SIZE, MemoryBlockProvider* provider = nullptr);
+		// Destructor, all threads must be done with the pool
+		~ThreadSafeMemoryPool();
+
+		// Shards of the pool, indexed by thread slot. A shard is a memory pool owned by a single thread at a time,
+		// other threads only push the units they free into its remote frees queue
+		MemoryPool* shards[MEMORYPOOL_MAX_THREADS];
+		size_t defaultBlockSize;
+		MemoryBlockProvider* blockProvider;
+
+		/**
+		 * Get the slot of the calling thread, slots are released when a thread exits
+		 * and given to the next thread that asks for one.
+		 *
+		 * @returns size_t Index of the thread slot
+		 */
+		static size_t getThreadSlot();
+
+		/**
+		 * Get the shard of the calling thread, creating it if needed
+		 *
+		 * @returns MemoryPool* Shard owned by the calling thread
+		 */
+		MemoryPool* getShard();
+
+		/**
+		 * Allocates memory in the shard of the calling thread
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocate(size_t size);
+
+		/**
+		 * Allocates memory with its start aligned in the shard of the calling thread
+		 *
+		 * @param size_t size Size to allocate in memory pool
+		 * @param size_t alignment Alignment of the allocated space, must be a power of 2
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* allocateAligned(size_t size, size_t alignment);
+
+		// Templated allocation, aligned to the type
+		template<typename T>
+		T* allocate(size_t instances);
+
+		/**
+		 * Re-allocates memory in the shard of the calling thread, units of other shards are moved
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to re-allocate
+		 * @param size_t new_size New size to allocate in memory pool
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* reallocate(void* unit_pointer_start, size_t new_size);
+
+		/**
+		 * Re-allocates memory in the shard of the calling thread, keeping the alignment if the space is moved
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to re-allocate
+		 * @param size_t new_size New size to allocate in memory pool
+		 * @param size_t alignment Alignment of the allocated space, must be a power of 2
+		 *
+		 * @returns void* Pointer to the newly allocate space
+		 */
+		void* reallocateAligned(void* unit_pointer_start, size_t new_size, size_t alignment);
+
+		// Templated re-allocation, aligned to the type
+		template<typename T>
+		T* reallocate(T* unit_pointer_start, size_t new_size);
+
+		/**
+		 * Frees memory allocated by any thread in the pool
+		 *
+		 * @param void* unit_pointer_start Pointer to the object to free
+		 */
+		void free(void* unit_pointer_start);
+
+		/**
+		 * Free units pushed to the shard of the calling thread by other threads.
+		 * It happens automatically when the shard needs a new block.
+		 */
+		void collectRemoteFrees();
+
+		/**
+		 * Start a scope in the shard of the calling thread
+		 */
+		void startScope();
+
+		/**
+		 * End the last scope started in the shard of the calling thread
+		 */
+		void endScope();
+
+		/**
+		 * Dump the data of all the shards to stream
+		 */
+		void dumpPoolData();
+	};
+
+	template<typename T>
+	inline T* ThreadSafeMemoryPool::allocate(size_t instances) {
+		return reinterpret_cast<T*>(this->allocateAligned(instances * sizeof(T), alignof(T)));
+	}
+
+	template<typename T>
+	inline T* ThreadSafeMemoryPool::reallocate(T* unit_pointer_start, size_t instances) {
+		return reinterpret_cast<T*>(this->reallocateAligned(reinterpret_cast<void*>(unit_pointer_start), instances * sizeof(T), alignof(T)));
+	}
+}
+
+// Override new operators to create with thread safe memory pool
+extern void* operator new(size_t size, AppShift::Memory::ThreadSafeMemoryPool* mp);
+extern void* operator new[](size_t size, AppShift::Memory::ThreadSafeMemoryPool* mp);
@@ -0,0 +1,87 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "../MemoryPool.h"
+#include "../MMapBlockProvider.h"
+
+#define BLOCK_SIZE 16 * 1024
+#define PASSES 20
+
+AppShift::Memory::MMapBlockProvider mmapProvider;
+
+// Time of a workload on a pool with fixed or adaptive block sizes from malloc or mmap, with the blocks it needed
+template<typename Workload>
+void run(const char* name, Workload workload) {
+    for (int config = 0; config < 4; config++) {
+        bool adaptive = config % 2 == 1;
+        AppShift::Memory::MemoryPool mp(BLOCK_SIZE, config < 2 ? nullptr : &mmapProvider);
+        if (adaptive) mp.enableAdaptiveBlockSize();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < PASSES; pass++) workload(mp);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+        std::cout << name << (config < 2 ? ", malloc" : ", mmap") << (adaptive ? " adaptive: " : " fixed: ") << elapsed.count() << "ms, "
+            << stats.blocksCreated << " blocks created, " << stats.peakBytesReserved / 1024 << "KB peak reserved" << std::endl;
+    }
+}
+
+int main() {
+    std::vector<void*> units;
+
+    // A burst of small objects, all freed at the end of the pass
+    run("Burst of 1M small units", [&units](AppShift::Memory::MemoryPool& mp) {
+        for (int i = 0; i < 1000000; i++) units.push_back(mp.allocate(24 + i % 40));
+        for (void* unit : units) mp.free(unit);
+        units.clear();
+    });
+
+    // Small objects with a big buffer now & then, which gets a block of its own
+    run("Small units with big buffers", [&units](AppShift::Memory::MemoryPool& mp) {
+        for (int i = 0; i < 200000; i++) {
+            units.push_back(mp.allocate(i % 1000 == 0 ? 256 * 1024 : 48));
+            static_cast<char*>(units.back())[0] = (char) i;
+        }
+        for (void* unit : units) mp.free(unit);
+        units.clear();
+    });
+
+    // A steady load of few live objects after a burst, the blocks shrink back
+    run("Steady load after a burst", [&units](AppShift::Memory::MemoryPool& mp) {
+        for (int i = 0; i < 100000; i++) units.push_back(mp.allocate(64));
+        for (void* unit : units) mp.free(unit);
+        units.clear();
+        for (int i = 0; i < 1000000; i++) {
+            units.push_back(mp.allocate(64));
+            if (units.size() == 32) {
+                for (void* unit : units) mp.free(unit);
+                units.clear();
+            }
+        }
+        for (void* unit : units) mp.free(unit);
+        units.clear();
+    });
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "../MemoryPool.h"
+
+#ifdef MEMORYPOOL_ADDRESS_MASKING
+#define LAYOUT_NAME "Address masking"
+#else
+#define LAYOUT_NAME "Container pointer"
+#endif
+
+#define OBJECTS 1000000
+#define ROUNDS 20
+
+// Bytes taken in the blocks by each object of a given size, including its header
+double bytesPerObject(size_t size) {
+    AppShift::Memory::MemoryPool mp;
+    for (int i = 0; i < OBJECTS; i++) mp.allocate<char>(size);
+
+    size_t used = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) used += block->offset;
+    return (double) used / OBJECTS;
+}
+
+// Allocate small objects, touch them & free them in a shuffled order
+double throughput() {
+    AppShift::Memory::MemoryPool mp;
+    std::vector<char*> objects(OBJECTS);
+    // Keep the blocks between rounds, so only the unit layout is measured
+    mp.setBlockRetention((size_t) -1);
+    long long sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < OBJECTS; i++) {
+            objects[i] = mp.allocate<char>(16 + (i % 3) * 16);
+            objects[i][0] = (char) i;
+        }
+        for (int i = 0; i < OBJECTS; i++) sum += objects[((size_t) i * 7919) % OBJECTS][0];
+        for (int i = 0; i < OBJECTS; i++) mp.free(objects[((size_t) i * 7919) % OBJECTS]);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum == 0) std::cout << "Unexpected sum" << std::endl;
+    return (double) ROUNDS * OBJECTS / elapsed.count() / 1000;
+}
+
+int main() {
+    std::cout << LAYOUT_NAME << " (" << sizeof(AppShift::Memory::SMemoryUnitHeader) << " bytes unit header):" << std::endl;
+    for (size_t size = 16; size <= 48; size += 16)
+        std::cout << "\t" << size << " bytes objects: " << bytesPerObject(size) << " bytes per object" << std::endl;
+    std::cout << "\tAllocate, touch & free: " << throughput() << " M objects/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../MemoryPoolAllocator.h"
+
+#define ITERATIONS 200
+#define ELEMENTS 20000
+
+// Fill & drop vectors of strings, the strings grow past their small buffer
+double vectorWorkload(std::pmr::memory_resource* resource) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::pmr::vector<std::pmr::string> lines(resource);
+        for (int j = 0; j < ELEMENTS; j++) {
+            lines.emplace_back("line number ");
+            lines.back() += std::to_string(j);
+            lines.back() += " of the generated text";
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Insert, look up & erase in hash maps, which allocate a node per element
+double unorderedMapWorkload(std::pmr::memory_resource* resource) {
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::pmr::unordered_map<int, int> counters(resource);
+        for (int j = 0; j < ELEMENTS; j++) counters[(j * 7919) % ELEMENTS] += j;
+        for (int j = 0; j < ELEMENTS; j += 3) counters.erase(j);
+        for (int j = 0; j < ELEMENTS; j++) {
+            auto found = counters.find(j);
+            if (found != counters.end()) sum += found->second;
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum == 0) std::cout << "Unexpected sum" << std::endl;
+    return elapsed.count();
+}
+
+int main() {
+    AppShift::Memory::MemoryPool mp;
+    AppShift::Memory::MemoryPoolResource pool_resource(&mp);
+
+    AppShift::Memory::MemoryPool free_lists_mp;
+    free_lists_mp.enableFreeLists();
+    AppShift::Memory::MemoryPoolResource free_lists_resource(&free_lists_mp);
+
+    std::cout << "std::pmr::vector<std::pmr::string>:" << std::endl;
+    std::cout << "\tDefault resource: " << vectorWorkload(std::pmr::get_default_resource()) << "ms" << std::endl;
+    std::cout << "\tMemoryPoolResource: " << vectorWorkload(&pool_resource) << "ms" << std::endl;
+    std::cout << "\tMemoryPoolResource with free lists: " << vectorWorkload(&free_lists_resource) << "ms" << std::endl;
+
+    std::cout << "std::pmr::unordered_map<int, int>:" << std::endl;
+    std::cout << "\tDefault resource: " << unorderedMapWorkload(std::pmr::get_default_resource()) << "ms" << std::endl;
+    std::cout << "\tMemoryPoolResource: " << unorderedMapWorkload(&pool_resource) << "ms" << std::endl;
+    std::cout << "\tMemoryPoolResource with free lists: " << unorderedMapWorkload(&free_lists_resource) << "ms" << std::endl;
+
+    return 0;
+}
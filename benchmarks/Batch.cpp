@@ -0,0 +1,68 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include "../MemoryPool.h"
+
+#define RECORDS 256
+#define PACKETS 20000
+
+// Nanoseconds per record to decode packets of records allocated & freed one by one or in batches
+double decodePackets(AppShift::Memory::MemoryPool* mp, size_t size, bool batch) {
+    void* records[RECORDS];
+    auto start = std::chrono::steady_clock::now();
+
+    for (int packet = 0; packet < PACKETS; packet++) {
+        if (batch) mp->allocateBatch(RECORDS, size, records);
+        else for (int i = 0; i < RECORDS; i++) records[i] = mp->allocate(size);
+
+        for (int i = 0; i < RECORDS; i++) *reinterpret_cast<int*>(records[i]) = i;
+
+        // Records are freed together, in the order they were decoded
+        if (batch) mp->freeBatch(records, RECORDS);
+        else for (int i = 0; i < RECORDS; i++) mp->free(records[i]);
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ((double) PACKETS * RECORDS);
+}
+
+int main() {
+    // A long-lived unit keeps the first block from being released
+    for (size_t size : { 16, 64, 256 }) {
+        for (bool free_lists : { false, true }) {
+            AppShift::Memory::MemoryPool single_mp, batch_mp;
+            single_mp.allocate(8);
+            batch_mp.allocate(8);
+            if (free_lists) {
+                single_mp.enableFreeLists();
+                batch_mp.enableFreeLists();
+            }
+
+            double single_time = decodePackets(&single_mp, size, false);
+            double batch_time = decodePackets(&batch_mp, size, true);
+            std::cout << size << " bytes" << (free_lists ? " with free lists" : "") << ": allocate & free "
+                << single_time << "ns, allocateBatch & freeBatch " << batch_time << "ns per record" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace AppShift::Benchmark {
+	// Operations timed together, the clock is too coarse & too slow to time a single allocation
+	constexpr size_t BATCH_SIZE = 16;
+
+	// Result of a scenario run with one allocator
+	struct SResult {
+		std::string scenario;
+		std::string allocator;
+		size_t threads;
+		size_t operations;
+		double seconds;
+		double operationsPerSecond;
+		double p50;
+		double p99;
+		double p999;
+	};
+
+	/**
+	 * Collects the duration of batches of operations.
+	 * The latency of an operation is the duration of its batch divided by the batch size.
+	 */
+	class Recorder {
+	public:
+		/**
+		 * Run an operation for the indexes from 0 to count, timing it in batches
+		 *
+		 * @param size_t count Number of operations
+		 * @param Operation operation Callable taking the index of the operation
+		 */
+		template<typename Operation>
+		void time(size_t count, Operation operation) {
+			for (size_t start = 0; start < count; start += BATCH_SIZE) {
+				size_t end = std::min(count, start + BATCH_SIZE);
+				auto batch_start = std::chrono::steady_clock::now();
+				for (size_t i = start; i < end; i++) operation(i);
+				std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - batch_start;
+				this->samples.push_back(elapsed.count() / (end - start));
+				this->nanoseconds += elapsed.count();
+				this->operations += end - start;
+			}
+		}
+
+		// Add the samples of another recorder, used to merge the recorders of threads
+		void merge(const Recorder& other) {
+			this->samples.insert(this->samples.end(), other.samples.begin(), other.samples.end());
+			this->nanoseconds += other.nanoseconds;
+			this->operations += other.operations;
+		}
+
+		/**
+		 * Sort the samples & build the result. Throughput uses the wall time when given,
+		 * otherwise the time spent in the operations.
+		 *
+		 * @param size_t threads Number of threads the samples came from
+		 * @param double wall_seconds Duration of a run in multiple threads, 0 for the time in operations
+		 *
+		 * @returns SResult Result without the scenario & allocator names
+		 */
+		SResult finish(size_t threads = 1, double wall_seconds = 0) {
+			std::sort(this->samples.begin(), this->samples.end());
+			SResult result;
+			result.threads = threads;
+			result.operations = this->operations;
+			result.seconds = wall_seconds != 0 ? wall_seconds : this->nanoseconds / 1e9;
+			result.operationsPerSecond = result.seconds != 0 ? this->operations / result.seconds : 0;
+			result.p50 = this->percentile(0.5);
+			result.p99 = this->percentile(0.99);
+			result.p999 = this->percentile(0.999);
+			return result;
+		}
+
+	private:
+		std::vector<double> samples;
+		double nanoseconds = 0;
+		size_t operations = 0;
+
+		double percentile(double fraction) const {
+			if (this->samples.empty()) return 0;
+			size_t index = (size_t) (fraction * (this->samples.size() - 1) + 0.5);
+			return this->samples[index];
+		}
+	};
+
+	// Print results as a table, relative to the first allocator of each scenario
+	inline void printTable(const std::vector<SResult>& results, std::ostream& stream) {
+		stream << std::left << std::setw(16) << "Scenario" << std::setw(28) << "Allocator" << std::right
+			<< std::setw(12) << "Mops/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p99.9 ns" << std::setw(10) << "Relative" << std::endl;
+
+		double baseline = 0;
+		std::string scenario;
+		for (const SResult& result : results) {
+			if (result.scenario != scenario) {
+				scenario = result.scenario;
+				baseline = result.operationsPerSecond;
+			}
+			stream << std::left << std::setw(16) << result.scenario << std::setw(28) << result.allocator << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(12) << result.operationsPerSecond / 1e6 << std::setw(10) << result.p50 << std::setw(10) << result.p99 << std::setw(10) << result.p999
+				<< std::setw(9) << (baseline != 0 ? result.operationsPerSecond / baseline : 0) << "x" << std::endl;
+			stream.unsetf(std::ios::fixed);
+		}
+	}
+
+	// Write results as CSV, one line per scenario & allocator
+	inline void writeCsv(const std::vector<SResult>& results, std::ostream& stream) {
+		stream << "scenario,allocator,threads,operations,seconds,ops_per_second,p50_ns,p99_ns,p999_ns" << std::endl;
+		for (const SResult& result : results) {
+			stream << result.scenario << "," << result.allocator << "," << result.threads << "," << result.operations << "," << result.seconds << ","
+				<< result.operationsPerSecond << "," << result.p50 << "," << result.p99 << "," << result.p999 << std::endl;
+		}
+	}
+
+	// Write results as a JSON array of objects
+	inline void writeJson(const std::vector<SResult>& results, std::ostream& stream) {
+		stream << "[" << std::endl;
+		for (size_t i = 0; i < results.size(); i++) {
+			const SResult& result = results[i];
+			stream << "  {\"scenario\":\"" << result.scenario << "\",\"allocator\":\"" << result.allocator << "\",\"threads\":" << result.threads
+				<< ",\"operations\":" << result.operations << ",\"seconds\":" << result.seconds << ",\"opsPerSecond\":" << result.operationsPerSecond
+				<< ",\"p50Ns\":" << result.p50 << ",\"p99Ns\":" << result.p99 << ",\"p999Ns\":" << result.p999 << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+		}
+		stream << "]" << std::endl;
+	}
+}
@@ -0,0 +1,69 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <sys/resource.h>
+#include "../MemoryPool.h"
+#include "../MMapBlockProvider.h"
+
+#define POOL_SIZE 1024LL * 1024 * 1024
+#define BLOCK_SIZE 32 * 1024 * 1024 - sizeof(AppShift::Memory::SMemoryBlockHeader)
+#define UNIT_SIZE 64
+
+// Minor & major page faults of the process so far
+long pageFaults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+// Fill a big pool with small units, touching all of them
+void fillPool(const char* name, AppShift::Memory::MemoryBlockProvider* provider) {
+    long faults = pageFaults();
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        AppShift::Memory::MemoryPool mp(BLOCK_SIZE, provider);
+        for (size_t i = 0; i < POOL_SIZE / (UNIT_SIZE + sizeof(AppShift::Memory::SMemoryUnitHeader)); i++) {
+            char* unit = mp.allocate<char>(UNIT_SIZE);
+            unit[0] = (char) i;
+        }
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() << "ms, " << pageFaults() - faults << " page faults" << std::endl;
+}
+
+int main() {
+    AppShift::Memory::MMapBlockProvider mmap_provider;
+    AppShift::Memory::MMapBlockProvider populate_provider(true);
+    AppShift::Memory::MMapBlockProvider huge_pages_provider(false, true);
+    AppShift::Memory::MMapBlockProvider populated_huge_pages_provider(true, true);
+    AppShift::Memory::HugeTLBBlockProvider hugetlb_provider;
+
+    fillPool("malloc", nullptr);
+    fillPool("mmap", &mmap_provider);
+    fillPool("mmap + MAP_POPULATE", &populate_provider);
+    fillPool("mmap + MADV_HUGEPAGE", &huge_pages_provider);
+    fillPool("mmap + MADV_HUGEPAGE + populate", &populated_huge_pages_provider);
+    fillPool("MAP_HUGETLB (falls back to regular pages)", &hugetlb_provider);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include "../MemoryPool.h"
+
+#define BLOCK_SIZE 256 * 1024
+#define ITERATIONS 2000000
+
+// A request loop that allocates across the end of the current block & frees again
+double boundaryOscillation(size_t max_retained_blocks) {
+    AppShift::Memory::MemoryPool mp(BLOCK_SIZE);
+    mp.setBlockRetention(max_retained_blocks);
+    mp.allocate(BLOCK_SIZE - 256);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        void* request = mp.allocate(1024);
+        static_cast<char*>(request)[0] = (char) i;
+        mp.free(request);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+int main() {
+    std::cout << "Boundary oscillation without retained blocks: " << boundaryOscillation(0) << "ms" << std::endl;
+    std::cout << "Boundary oscillation with retained blocks: " << boundaryOscillation(MEMORYPOOL_MAX_RETAINED_BLOCKS) << "ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "../MemoryPool.h"
+
+#define LIVE_UNITS 10000
+#define OPERATIONS 5000000
+
+// Bytes taken by the blocks of a pool
+size_t reservedBytes(AppShift::Memory::MemoryPool* mp) {
+    size_t bytes = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp->firstBlock; block != nullptr; block = block->next)
+        bytes += sizeof(AppShift::Memory::SMemoryBlockHeader) + block->blockSize;
+    return bytes;
+}
+
+// Keep a set of live units and replace a random one on every operation
+double randomOrderFrees(AppShift::Memory::MemoryPool* mp) {
+    std::mt19937 random(42);
+    std::vector<void*> live(LIVE_UNITS);
+    for (void*& unit : live) unit = mp != nullptr ? mp->allocate(16 + random() % 240) : std::malloc(16 + random() % 240);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        size_t index = random() % LIVE_UNITS;
+        size_t size = 16 + random() % 240;
+        if (mp != nullptr) {
+            mp->free(live[index]);
+            live[index] = mp->allocate(size);
+        }
+        else {
+            std::free(live[index]);
+            live[index] = std::malloc(size);
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (mp == nullptr) for (void* unit : live) std::free(unit);
+    return elapsed.count();
+}
+
+int main() {
+    AppShift::Memory::MemoryPool* plain = new AppShift::Memory::MemoryPool();
+    double plain_time = randomOrderFrees(plain);
+    std::cout << "MemoryPool: " << plain_time << "ms, " << reservedBytes(plain) / 1024 << "KB reserved" << std::endl;
+    delete plain;
+
+    AppShift::Memory::MemoryPool* free_lists = new AppShift::Memory::MemoryPool();
+    free_lists->enableFreeLists();
+    double free_lists_time = randomOrderFrees(free_lists);
+    std::cout << "MemoryPool with free lists: " << free_lists_time << "ms, " << reservedBytes(free_lists) / 1024 << "KB reserved" << std::endl;
+    delete free_lists;
+
+    std::cout << "malloc/free: " << randomOrderFrees(nullptr) << "ms" << std::endl;
+    return 0;
+}
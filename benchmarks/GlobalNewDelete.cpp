@@ -0,0 +1,79 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <thread>
+
+#ifdef MEMORYPOOL_GLOBAL_NEW_DELETE
+#define ALLOCATOR_NAME "Global MemoryPool"
+#else
+#define ALLOCATOR_NAME "malloc"
+#endif
+
+#define ITERATIONS 20
+
+// Legacy code allocating with new everywhere: strings, nodes & small objects
+struct Order {
+    std::string customer;
+    std::vector<int> items;
+};
+
+double legacyWorkload() {
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::map<int, std::unique_ptr<Order>> orders;
+        std::list<std::string> log;
+        for (int j = 0; j < 50000; j++) {
+            std::unique_ptr<Order> order = std::make_unique<Order>();
+            order->customer = "customer with a long enough name #" + std::to_string(j % 997);
+            for (int k = 0; k < j % 8; k++) order->items.push_back(k);
+            orders[j] = std::move(order);
+            if (j % 3 == 0) log.push_back("processed order " + std::to_string(j));
+            if (j % 5 == 0) orders.erase(j / 2);
+        }
+        checksum += orders.size() + log.size();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (checksum == 0) std::cout << "Unexpected checksum" << std::endl;
+    return elapsed.count();
+}
+
+// The same workload in several threads at once
+double threadedWorkload(size_t thread_count) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < thread_count; t++) threads.emplace_back(legacyWorkload);
+    for (std::thread& thread : threads) thread.join();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main() {
+    std::cout << ALLOCATOR_NAME << ": single thread " << legacyWorkload() << "ms" << std::endl;
+    std::cout << ALLOCATOR_NAME << ": 4 threads " << threadedWorkload(4) << "ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include "../MemoryPool.h"
+#include "String.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define OPERATIONS 1000000
+#define BATCH 1000
+
+// Counts the instructions retired by the calling thread, falls back to nanoseconds when not available
+class InstructionCounter {
+public:
+    InstructionCounter() {
+        this->descriptor = -1;
+#ifdef __linux__
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        this->descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+    }
+
+    ~InstructionCounter() {
+#ifdef __linux__
+        if (this->descriptor >= 0) close(this->descriptor);
+#endif
+    }
+
+    bool countsInstructions() const { return this->descriptor >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (this->descriptor >= 0) {
+            ioctl(this->descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(this->descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            return;
+        }
+#endif
+        this->startTime = std::chrono::steady_clock::now();
+    }
+
+    uint64_t stop() {
+#ifdef __linux__
+        if (this->descriptor >= 0) {
+            ioctl(this->descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t count = 0;
+            if (read(this->descriptor, &count, sizeof(count)) != sizeof(count)) return 0;
+            return count;
+        }
+#endif
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->startTime).count();
+    }
+
+private:
+    int descriptor;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+int main() {
+    InstructionCounter counter;
+    AppShift::Memory::MemoryPool mp;
+    void* units[BATCH];
+    uint64_t allocate_count = 0, free_count = 0, reallocate_count = 0;
+    const char* unit = counter.countsInstructions() ? "instructions" : "ns";
+
+    // Allocations that fit in the current block, followed by frees of the last unit
+    for (int round = 0; round < OPERATIONS / BATCH; round++) {
+        counter.start();
+        for (int i = 0; i < BATCH; i++) units[i] = mp.allocate(32);
+        allocate_count += counter.stop();
+
+        counter.start();
+        for (int i = BATCH - 1; i >= 0; i--) mp.free(units[i]);
+        free_count += counter.stop();
+    }
+    std::cout << "allocate: " << (double) allocate_count / OPERATIONS << " " << unit << std::endl;
+    std::cout << "free (last unit): " << (double) free_count / OPERATIONS << " " << unit << std::endl;
+
+    // Growing the last unit in place
+    for (int round = 0; round < OPERATIONS / BATCH; round++) {
+        void* growing = mp.allocate(16);
+        counter.start();
+        for (int i = 0; i < BATCH; i++) growing = mp.reallocate(growing, 16 + i * 8);
+        reallocate_count += counter.stop();
+        mp.free(growing);
+    }
+    std::cout << "reallocate (last unit): " << (double) reallocate_count / OPERATIONS << " " << unit << std::endl;
+
+    // The String benchmark: allocation, re-allocation & free of a string
+    counter.start();
+    for (int i = 0; i < OPERATIONS; i++) {
+        AppShift::String strs(&mp, "The Big World Is Great And Shit");
+        strs += "Some new stuff";
+    }
+    std::cout << "String create, append & destroy: " << (double) counter.stop() / OPERATIONS << " " << unit << std::endl;
+
+    // Two strings appended in turns, so the one growing is not the last unit of the block
+    counter.start();
+    for (int i = 0; i < OPERATIONS / 16; i++) {
+        AppShift::String key(&mp, "key"), value(&mp, "value");
+        for (int j = 0; j < 16; j++) {
+            key += "abcdefgh";
+            value += "ijklmnop";
+        }
+    }
+    std::cout << "String interleaved appends: " << (double) counter.stop() / OPERATIONS << " " << unit << " per append pair" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "../ObjectPool.h"
+
+#define NODES 1000000
+#define ROUNDS 5
+
+// Node of an order book level list
+struct Node {
+    Node* next;
+    double price;
+    size_t quantity;
+
+    Node(double price, size_t quantity) : next(nullptr), price(price), quantity(quantity) {}
+};
+
+// Create all the nodes, then destroy them in random order, returns milliseconds
+template<typename Create, typename Destroy>
+double churn(Create create, Destroy destroy) {
+    std::mt19937 random(42);
+    std::vector<Node*> nodes(NODES);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < NODES; i++) nodes[i] = create(i);
+        std::shuffle(nodes.begin(), nodes.end(), random);
+        for (Node* node : nodes) destroy(node);
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Bytes of the blocks of a pool
+size_t reservedBytes(AppShift::Memory::MemoryPool& mp) {
+    size_t bytes = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next)
+        bytes += sizeof(AppShift::Memory::SMemoryBlockHeader) + block->blockSize;
+    return bytes;
+}
+
+int main() {
+    std::cout << "new/delete: " << churn(
+        [](size_t i) { return new Node((double) i, i); },
+        [](Node* node) { delete node; }) << "ms" << std::endl;
+
+    // Frees in random order are only reused through the free lists
+    AppShift::Memory::MemoryPool units_mp;
+    units_mp.enableFreeLists();
+    std::cout << "MemoryPool::allocate<Node> with free lists: " << churn(
+        [&units_mp](size_t i) { return new (units_mp.allocate<Node>(1)) Node((double) i, i); },
+        [&units_mp](Node* node) { units_mp.free(node); }) << "ms, ";
+    for (size_t i = 0; i < NODES; i++) units_mp.allocate<Node>(1);
+    std::cout << (double) reservedBytes(units_mp) / NODES << " bytes per node" << std::endl;
+
+    AppShift::Memory::MemoryPool slabs_mp;
+    AppShift::Memory::ObjectPool<Node> nodes(&slabs_mp);
+    std::cout << "ObjectPool<Node>: " << churn(
+        [&nodes](size_t i) { return nodes.create((double) i, i); },
+        [&nodes](Node* node) { nodes.destroy(node); }) << "ms, ";
+    for (size_t i = 0; i < NODES; i++) nodes.allocate();
+    std::cout << (double) reservedBytes(slabs_mp) / NODES << " bytes per node" << std::endl;
+
+    AppShift::Memory::MemoryPool compact_mp;
+    AppShift::Memory::ObjectPool<Node, false> compact_nodes(&compact_mp);
+    std::cout << "ObjectPool<Node> without cache line packing: " << churn(
+        [&compact_nodes](size_t i) { return compact_nodes.create((double) i, i); },
+        [&compact_nodes](Node* node) { compact_nodes.destroy(node); }) << "ms, ";
+    for (size_t i = 0; i < NODES; i++) compact_nodes.allocate();
+    std::cout << (double) reservedBytes(compact_mp) / NODES << " bytes per node" << std::endl;
+
+    // Bulk reset instead of destroying the nodes one by one
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        nodes.reset();
+        for (size_t i = 0; i < NODES; i++) nodes.create((double) i, i);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "ObjectPool<Node> with reset: " << elapsed.count() << "ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "../MemoryPool.h"
+#include "../BasicMemoryPool.h"
+
+#define ROUNDS 200
+#define ALLOCATIONS 100000
+
+// Arena use: allocate many small objects, then drop them all at once
+template<typename Pool>
+double arenaWorkload(Pool& mp) {
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        mp.startScope();
+        for (int i = 0; i < ALLOCATIONS; i++) {
+            int* value = mp.template allocate<int>(1 + i % 4);
+            *value = i;
+            sum += *value;
+        }
+        mp.endScope();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum == 0) std::cout << "Unexpected sum" << std::endl;
+    return elapsed.count() / ROUNDS / ALLOCATIONS;
+}
+
+// The performance mode has no scopes, reset drops everything
+double performanceWorkload(AppShift::Memory::PerformanceMemoryPool& mp) {
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < ALLOCATIONS; i++) {
+            int* value = mp.allocate<int>(1 + i % 4);
+            *value = i;
+            sum += *value;
+        }
+        mp.reset();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum == 0) std::cout << "Unexpected sum" << std::endl;
+    return elapsed.count() / ROUNDS / ALLOCATIONS;
+}
+
+double mallocWorkload() {
+    long long sum = 0;
+    std::vector<int*> values(ALLOCATIONS);
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < ALLOCATIONS; i++) {
+            values[i] = reinterpret_cast<int*>(std::malloc(sizeof(int) * (1 + i % 4)));
+            *values[i] = i;
+            sum += *values[i];
+        }
+        for (int i = 0; i < ALLOCATIONS; i++) std::free(values[i]);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum == 0) std::cout << "Unexpected sum" << std::endl;
+    return elapsed.count() / ROUNDS / ALLOCATIONS;
+}
+
+int main() {
+    AppShift::Memory::MemoryPool mp;
+    AppShift::Memory::StandardMemoryPool standard_mp;
+    AppShift::Memory::PerformanceMemoryPool performance_mp;
+
+    std::cout << "Nanoseconds per allocation:" << std::endl;
+    std::cout << "\tmalloc & free: " << mallocWorkload() << std::endl;
+    std::cout << "\tMemoryPool: " << arenaWorkload(mp) << std::endl;
+    std::cout << "\tStandardMemoryPool: " << arenaWorkload(standard_mp) << std::endl;
+    std::cout << "\tPerformanceMemoryPool: " << performanceWorkload(performance_mp) << std::endl;
+    return 0;
+}
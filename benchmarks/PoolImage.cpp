@@ -0,0 +1,137 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include "../MemoryPool.h"
+#include "../MMapBlockProvider.h"
+#include "../MemoryPoolImage.h"
+
+#define ENTRIES 2000000
+#define LOOKUPS 2000000
+#define IMAGE_PATH "pool_image_benchmark.img"
+
+// Lookup table with chained buckets, all of it lives in the pool
+struct Entry {
+    Entry* next;
+    uint64_t key;
+    uint64_t value;
+};
+
+struct Table {
+    size_t bucketCount;
+    Entry** buckets;
+};
+
+uint64_t hashKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+Table* buildTable(AppShift::Memory::MemoryPool& mp) {
+    Table* table = mp.allocate<Table>(1);
+    table->bucketCount = ENTRIES;
+    table->buckets = mp.allocate<Entry*>(ENTRIES);
+    for (size_t i = 0; i < ENTRIES; i++) table->buckets[i] = nullptr;
+
+    for (uint64_t key = 0; key < ENTRIES; key++) {
+        Entry* entry = mp.allocate<Entry>(1);
+        entry->key = key * 7919;
+        entry->value = key;
+        Entry*& bucket = table->buckets[hashKey(entry->key) % ENTRIES];
+        entry->next = bucket;
+        bucket = entry;
+    }
+    return table;
+}
+
+// Random lookups, pointers are followed as they are or translated when the image was relocated
+template<typename Translate>
+uint64_t lookups(const Table* table, Translate translate) {
+    uint64_t sum = 0;
+    const Entry* const* buckets = translate(table->buckets);
+    for (uint64_t i = 0; i < LOOKUPS; i++) {
+        uint64_t key = (hashKey(i) % ENTRIES) * 7919;
+        for (const Entry* entry = translate(buckets[hashKey(key) % table->bucketCount]); entry != nullptr; entry = translate(entry->next)) {
+            if (entry->key == key) {
+                sum += entry->value;
+                break;
+            }
+        }
+    }
+    return sum;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    AppShift::Memory::MMapBlockProvider provider;
+    uint64_t expected;
+
+    // Cold start by building the table
+    {
+        auto start = std::chrono::steady_clock::now();
+        AppShift::Memory::MemoryPool mp(4 * 1024 * 1024, &provider);
+        Table* table = buildTable(mp);
+        double build = millisecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        expected = lookups(table, [](auto pointer) { return pointer; });
+        std::cout << "Rebuild: build " << build << "ms, lookups " << millisecondsSince(start) << "ms" << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        AppShift::Memory::MemoryPoolImage::save(mp, IMAGE_PATH, table);
+        std::cout << "Save image: " << millisecondsSince(start) << "ms" << std::endl;
+    }
+
+    // Cold start by mapping the image at the addresses it was saved from
+    {
+        auto start = std::chrono::steady_clock::now();
+        AppShift::Memory::MemoryPoolImage image(IMAGE_PATH);
+        const Table* table = reinterpret_cast<const Table*>(image.getRoot());
+        double map = millisecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        uint64_t sum = image.isRelocated()
+            ? lookups(table, [&image](auto pointer) { return image.translate(pointer); })
+            : lookups(table, [](auto pointer) { return pointer; });
+        std::cout << "Map image" << (image.isRelocated() ? " (relocated)" : "") << ": map " << map << "ms, lookups " << millisecondsSince(start) << "ms" << (sum != expected ? " - wrong result" : "") << std::endl;
+    }
+
+    // The saved addresses are taken, every pointer goes through translate
+    {
+        AppShift::Memory::MemoryPool mp(4 * 1024 * 1024, &provider);
+        buildTable(mp);
+        auto start = std::chrono::steady_clock::now();
+        AppShift::Memory::MemoryPoolImage image(IMAGE_PATH);
+        const Table* table = reinterpret_cast<const Table*>(image.getRoot());
+        double map = millisecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        uint64_t sum = lookups(table, [&image](auto pointer) { return image.translate(pointer); });
+        std::cout << "Map relocated image: map " << map << "ms, lookups " << millisecondsSince(start) << "ms" << (sum != expected ? " - wrong result" : "") << std::endl;
+    }
+
+    std::remove(IMAGE_PATH);
+    return 0;
+}
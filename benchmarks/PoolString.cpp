@@ -0,0 +1,157 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+#include "../PoolString.h"
+#include "../MemoryPoolAllocator.h"
+
+#define LINES 500000
+#define BATCH 10000
+#define ROUNDS 5
+
+// Access log to parse, one request per line
+std::string generateLog() {
+    const char* levels[] = { "INFO", "WARN", "DEBUG", "ERROR" };
+    const char* resources[] = { "users", "orders", "items", "sessions", "notifications/settings" };
+    std::string log;
+    for (int i = 0; i < LINES; i++) {
+        unsigned int random = (unsigned int) i * 2654435761u;
+        log += "2026-10-16T" + std::to_string(10 + random % 14) + ":" + std::to_string(10 + random % 50) + ":" + std::to_string(10 + (random >> 8) % 50);
+        log += std::string(" ") + levels[random % 4] + " svc-" + std::to_string(random % 12);
+        log += std::string(" /api/v1/") + resources[(random >> 4) % 5] + "/" + std::to_string(random % 100000);
+        if (random % 3 == 0) log += "?page=" + std::to_string(random % 9) + "&sort=created_at";
+        log += " status=" + std::to_string(random % 7 == 0 ? 404 : 200) + " latency=" + std::to_string(random % 900) + "\n";
+    }
+    return log;
+}
+
+template<typename Str>
+struct Record {
+    Str timestamp;
+    Str level;
+    Str service;
+    Str path;
+    Str key;
+    int status;
+    int latency;
+};
+
+std::string_view nextField(std::string_view& line) {
+    size_t end = line.find(' ');
+    std::string_view field = line.substr(0, end);
+    line = end == std::string_view::npos ? std::string_view() : line.substr(end + 1);
+    return field;
+}
+
+int toNumber(std::string_view field) {
+    int number = 0;
+    for (char digit : field.substr(field.find('=') + 1)) number = number * 10 + digit - '0';
+    return number;
+}
+
+// Split the lines in fields, build a key for each request & count the requests per key
+template<typename Str, typename Make>
+size_t parse(std::string_view log, Make make) {
+    std::vector<Record<Str>> records;
+    std::unordered_map<std::string_view, size_t> counts;
+    size_t checksum = 0;
+    records.reserve(BATCH);
+
+    while (!log.empty()) {
+        size_t end = log.find('\n');
+        std::string_view line = log.substr(0, end);
+        log = log.substr(end + 1);
+
+        std::string_view timestamp = nextField(line);
+        std::string_view level = nextField(line);
+        std::string_view service = nextField(line);
+        std::string_view path = nextField(line);
+        int status = toNumber(nextField(line));
+        int latency = toNumber(nextField(line));
+
+        // Key of the route, without the query & the id
+        Str key = make(service);
+        key += ' ';
+        key += path.substr(0, path.rfind('/'));
+        if (status != 200) key += " failed";
+        records.push_back(Record<Str>{ make(timestamp), make(level), make(service), make(path), std::move(key), status, latency });
+
+        if (records.size() == BATCH || log.empty()) {
+            for (const Record<Str>& record : records) {
+                counts[std::string_view(record.key.data(), record.key.size())]++;
+                checksum += record.timestamp.size() + record.level.size() + record.path.size() + record.latency;
+            }
+            checksum += counts.size();
+            counts.clear();
+            records.clear();
+        }
+    }
+    return checksum;
+}
+
+template<typename Run>
+void benchmark(const char* name, Run run) {
+    double best = 0;
+    size_t checksum = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        checksum = run();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+    std::cout << name << ": " << best << "ms (checksum " << checksum << ")" << std::endl;
+}
+
+int main() {
+    std::string log = generateLog();
+
+    benchmark("std::string", [&log]() {
+        return parse<std::string>(log, [](std::string_view str) { return std::string(str); });
+    });
+    benchmark("std::pmr::string, monotonic_buffer_resource", [&log]() {
+        std::pmr::monotonic_buffer_resource resource;
+        return parse<std::pmr::string>(log, [&resource](std::string_view str) { return std::pmr::string(str, &resource); });
+    });
+    benchmark("std::pmr::string, unsynchronized_pool_resource", [&log]() {
+        std::pmr::unsynchronized_pool_resource resource;
+        return parse<std::pmr::string>(log, [&resource](std::string_view str) { return std::pmr::string(str, &resource); });
+    });
+    benchmark("std::pmr::string, MemoryPoolResource", [&log]() {
+        AppShift::Memory::MemoryPool mp;
+        AppShift::Memory::MemoryPoolResource resource(&mp);
+        return parse<std::pmr::string>(log, [&resource](std::string_view str) { return std::pmr::string(str, &resource); });
+    });
+    benchmark("PoolString", [&log]() {
+        AppShift::Memory::MemoryPool mp;
+        return parse<AppShift::Memory::PoolString>(log, [&mp](std::string_view str) { return AppShift::Memory::PoolString(&mp, str); });
+    });
+    benchmark("PoolString, free lists", [&log]() {
+        AppShift::Memory::MemoryPool mp;
+        mp.enableFreeLists();
+        return parse<AppShift::Memory::PoolString>(log, [&mp](std::string_view str) { return AppShift::Memory::PoolString(&mp, str); });
+    });
+    return 0;
+}
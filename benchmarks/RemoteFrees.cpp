@@ -0,0 +1,119 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include "../MemoryPool.h"
+
+#define MESSAGES 4000000
+#define RING_SIZE 1024
+
+// Single producer single consumer ring of messages
+struct SRing {
+    void* slots[RING_SIZE];
+    // The consumer & producer indices are kept on cache lines of their own
+    std::atomic<size_t> head{ 0 };
+    char headPadding[64];
+    std::atomic<size_t> tail{ 0 };
+    char tailPadding[64];
+
+    bool push(void* message) {
+        size_t tail_index = this->tail.load(std::memory_order_relaxed);
+        if (tail_index - this->head.load(std::memory_order_acquire) == RING_SIZE) return false;
+        this->slots[tail_index % RING_SIZE] = message;
+        this->tail.store(tail_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    void* pop() {
+        size_t head_index = this->head.load(std::memory_order_relaxed);
+        if (head_index == this->tail.load(std::memory_order_acquire)) return nullptr;
+        void* message = this->slots[head_index % RING_SIZE];
+        this->head.store(head_index + 1, std::memory_order_release);
+        return message;
+    }
+};
+
+enum EMode { MALLOC, LOCKED_POOL, REMOTE_FREES };
+
+// Messages per second from an I/O thread allocating messages to worker threads freeing them
+double handOff(EMode mode, size_t workers) {
+    AppShift::Memory::MemoryPool mp;
+    std::mutex pool_lock;
+    std::vector<SRing> rings(workers);
+    std::atomic<bool> producing(true);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t w = 0; w < workers; w++) {
+        threads.emplace_back([&, w]() {
+            while (true) {
+                char* message = static_cast<char*>(rings[w].pop());
+                if (message == nullptr) {
+                    if (!producing.load(std::memory_order_acquire) && rings[w].head.load() == rings[w].tail.load()) return;
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (message[0] != (char) 0x5A) std::abort();
+
+                if (mode == MALLOC) std::free(message);
+                else if (mode == REMOTE_FREES) AppShift::Memory::MemoryPool::freeRemote(message);
+                else {
+                    std::lock_guard<std::mutex> lock(pool_lock);
+                    mp.free(message);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < MESSAGES; i++) {
+        size_t size = 64 + (i * 7) % 192;
+        char* message;
+        if (mode == MALLOC) message = static_cast<char*>(std::malloc(size));
+        else if (mode == REMOTE_FREES) message = mp.allocate<char>(size);
+        else {
+            std::lock_guard<std::mutex> lock(pool_lock);
+            message = mp.allocate<char>(size);
+        }
+        message[0] = (char) 0x5A;
+        while (!rings[i % workers].push(message)) std::this_thread::yield();
+    }
+    producing.store(false, std::memory_order_release);
+    for (std::thread& thread : threads) thread.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (mode == REMOTE_FREES) mp.collectRemoteFrees();
+    return MESSAGES / elapsed.count() / 1000000;
+}
+
+int main() {
+    size_t max_workers = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+    if (max_workers > 8) max_workers = 8;
+
+    for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+        std::cout << workers << " workers: malloc " << handOff(MALLOC, workers) << " M messages/s, pool with a lock " << handOff(LOCKED_POOL, workers)
+            << " M messages/s, pool with remote frees " << handOff(REMOTE_FREES, workers) << " M messages/s" << std::endl;
+    }
+    return 0;
+}
@@ -58,8 +58,8 @@ namespace AppShift {
 
 	String& String::operator+=(const char* str)
 	{
-		int add_length = strlen(str);
-		this->start = (char*) this->mp->reallocate(this->start, this->length + add_length + 1);
+		size_t add_length = strlen(str);
+		this->reserve(this->length + add_length + 1);
 		memcpy(this->start + this->length, str, add_length);
 		this->length += add_length;
 		this->start[this->length] = '\0';
@@ -68,13 +68,20 @@ namespace AppShift {
 
 	String& String::operator+=(const String& str)
 	{
-		this->start = (char*) this->mp->reallocate(this->start, this->length + str.size() + 1);
+		this->reserve(this->length + str.size() + 1);
 		memcpy(this->start + this->length, str.data(), str.size());
 		this->length += str.size();
 		this->start[this->length] = '\0';
 		return *this;
 	}
 
+	void String::reserve(size_t size)
+	{
+		// Grow in place when possible, otherwise move with twice the space for the next appends
+		if (size <= Memory::MemoryPool::getCapacity(this->start) || this->mp->tryExpand(this->start, size)) return;
+		this->start = (char*) this->mp->reallocate(this->start, 2 * size);
+	}
+
 	std::ostream& operator<<(std::ostream& os, const String& str)
 	{
 		os << str.data();
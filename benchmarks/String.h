@@ -40,6 +40,9 @@ namespace AppShift {
 		String& operator+=(const String& str);
 
 	private:
+		// Make room for a given size, including the terminating null
+		void reserve(size_t size);
+
 		char* start;
 		size_t length;
 		Memory::MemoryPool * mp;
@@ -0,0 +1,264 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../MemoryPool.h"
+#include "../MemoryPoolTrace.h"
+
+// Re-executes a trace recorded with MemoryPool::startTracing against pools of different configurations & malloc.
+// Every configuration runs in its own process so its peak RSS can be measured.
+
+using AppShift::Memory::ETraceEvent;
+
+// A traced call with the addresses replaced by the numbers of the objects, in allocation order
+struct SReplayOperation {
+    ETraceEvent type;
+    size_t object;
+    size_t size;
+    size_t alignment;
+};
+
+struct SReplayConfiguration {
+    bool useMalloc;
+    size_t blockSize;
+    bool freeLists;
+};
+
+// Measured in the process running a configuration, sent back through a pipe
+struct SReplayResult {
+    double milliseconds;
+    long peakRssGrowth;
+    size_t blocksCreated;
+    size_t blocksFreed;
+    size_t peakBytesUsed;
+    size_t peakBytesReserved;
+};
+
+// Read a trace & give every object a number, frees of objects allocated before the trace started are dropped
+bool loadTrace(const char* path, std::vector<SReplayOperation>& operations, size_t& objects, AppShift::Memory::STraceFileHeader& header) {
+    AppShift::Memory::MemoryPoolTraceReader reader(path);
+    if (!reader.isValid()) return false;
+    header = reader.header;
+
+    std::unordered_map<uint64_t, size_t> live_objects;
+    std::vector<uint64_t> addresses;
+    std::vector<bool> live;
+    std::vector<size_t> scopes;
+    AppShift::Memory::STraceEvent event;
+
+    while (reader.next(event)) {
+        SReplayOperation operation = { event.type, 0, (size_t) event.size, (size_t) event.alignment };
+        switch (event.type) {
+        case ETraceEvent::ALLOCATE:
+            operation.object = addresses.size();
+            live_objects[event.address] = operation.object;
+            addresses.push_back(event.address);
+            live.push_back(true);
+            break;
+        case ETraceEvent::REALLOCATE:
+        case ETraceEvent::FREE: {
+            auto found = live_objects.find(event.address);
+            if (found == live_objects.end()) continue;
+            operation.object = found->second;
+            live_objects.erase(found);
+            if (event.type == ETraceEvent::REALLOCATE) {
+                live_objects[event.newAddress] = operation.object;
+                addresses[operation.object] = event.newAddress;
+            }
+            else live[operation.object] = false;
+            break;
+        }
+        case ETraceEvent::START_SCOPE:
+            scopes.push_back(addresses.size());
+            break;
+        case ETraceEvent::END_SCOPE:
+            // The objects from the start of the scope up to operation.object are dropped with it
+            if (scopes.empty()) continue;
+            operation.size = scopes.back();
+            operation.object = addresses.size();
+            scopes.pop_back();
+            for (size_t i = operation.size; i < operation.object; i++) {
+                if (!live[i]) continue;
+                live_objects.erase(addresses[i]);
+                live[i] = false;
+            }
+            break;
+        }
+        operations.push_back(operation);
+    }
+
+    objects = addresses.size();
+    return true;
+}
+
+void* mallocAllocate(size_t size, size_t alignment) {
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignment, size) != 0) return nullptr;
+    return memory;
+}
+
+// Run the operations, writing every allocated byte like the traced program would
+SReplayResult replay(const SReplayConfiguration& configuration, const std::vector<SReplayOperation>& operations, size_t object_count) {
+    SReplayResult result = SReplayResult();
+    std::vector<void*> objects(object_count, nullptr);
+    std::vector<size_t> sizes(object_count, 0);
+    AppShift::Memory::MemoryPool mp(configuration.blockSize);
+    mp.enableFreeLists(configuration.freeLists);
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long start_rss = usage.ru_maxrss;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const SReplayOperation& operation : operations) {
+        void*& object = objects[operation.object];
+        switch (operation.type) {
+        case ETraceEvent::ALLOCATE:
+            if (configuration.useMalloc) object = mallocAllocate(operation.size, operation.alignment);
+            else object = operation.alignment == 0 ? mp.allocate(operation.size) : mp.allocateAligned(operation.size, operation.alignment);
+            std::memset(object, 1, operation.size);
+            sizes[operation.object] = operation.size;
+            break;
+        case ETraceEvent::REALLOCATE:
+            if (configuration.useMalloc) {
+                if (operation.alignment <= alignof(std::max_align_t)) object = std::realloc(object, operation.size);
+                else {
+                    void* moved = mallocAllocate(operation.size, operation.alignment);
+                    std::memcpy(moved, object, sizes[operation.object] < operation.size ? sizes[operation.object] : operation.size);
+                    std::free(object);
+                    object = moved;
+                }
+            }
+            else object = mp.reallocateAligned(object, operation.size, operation.alignment);
+            if (operation.size > sizes[operation.object]) std::memset(static_cast<char*>(object) + sizes[operation.object], 1, operation.size - sizes[operation.object]);
+            sizes[operation.object] = operation.size;
+            break;
+        case ETraceEvent::FREE:
+            if (configuration.useMalloc) std::free(object);
+            else mp.free(object);
+            object = nullptr;
+            break;
+        case ETraceEvent::START_SCOPE:
+            if (!configuration.useMalloc) mp.startScope();
+            break;
+        case ETraceEvent::END_SCOPE:
+            if (!configuration.useMalloc) mp.endScope();
+            for (size_t i = operation.size; i < operation.object; i++) {
+                if (configuration.useMalloc) std::free(objects[i]);
+                objects[i] = nullptr;
+            }
+            break;
+        }
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    getrusage(RUSAGE_SELF, &usage);
+    result.milliseconds = elapsed.count();
+    result.peakRssGrowth = usage.ru_maxrss - start_rss;
+
+    if (!configuration.useMalloc) {
+        AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+        result.blocksCreated = stats.blocksCreated;
+        result.blocksFreed = stats.blocksFreed;
+        result.peakBytesUsed = stats.peakBytesUsed;
+        result.peakBytesReserved = stats.peakBytesReserved;
+    }
+    return result;
+}
+
+// Replay in a child process, so the peak RSS of a configuration is not hidden by the previous ones
+bool replayInProcess(const SReplayConfiguration& configuration, const std::vector<SReplayOperation>& operations, size_t object_count, SReplayResult& result) {
+    int channel[2];
+    if (pipe(channel) != 0) return false;
+
+    pid_t child = fork();
+    if (child == 0) {
+        close(channel[0]);
+        SReplayResult child_result = replay(configuration, operations, object_count);
+        bool sent = write(channel[1], &child_result, sizeof(child_result)) == sizeof(child_result);
+        _exit(sent ? 0 : 1);
+    }
+
+    close(channel[1]);
+    bool received = child > 0 && read(channel[0], &result, sizeof(result)) == sizeof(result);
+    close(channel[0]);
+    if (child > 0) waitpid(child, nullptr, 0);
+    return received;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " trace_file [block_size...]" << std::endl;
+        std::cout << "Replays a trace with malloc & pools of the given block sizes, by default the traced size, 4 times smaller & 4 times bigger" << std::endl;
+        return 1;
+    }
+
+    std::vector<SReplayOperation> operations;
+    size_t object_count = 0;
+    AppShift::Memory::STraceFileHeader header;
+    if (!loadTrace(argv[1], operations, object_count, header)) {
+        std::cout << "Not a trace file: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<size_t> block_sizes;
+    for (int i = 2; i < argc; i++) block_sizes.push_back(std::stoull(argv[i]));
+    if (block_sizes.empty()) block_sizes = { header.defaultBlockSize / 4, header.defaultBlockSize, header.defaultBlockSize * 4 };
+
+    std::vector<SReplayConfiguration> configurations = { { true, 0, false } };
+    for (size_t block_size : block_sizes) {
+        configurations.push_back({ false, block_size, false });
+        configurations.push_back({ false, block_size, true });
+    }
+
+    std::cout << operations.size() << " operations on " << object_count << " objects, traced with a block size of " << header.defaultBlockSize
+        << (header.freeLists ? " & free lists" : "") << std::endl;
+    std::cout << std::left << std::setw(36) << "Configuration" << std::right << std::setw(12) << "Time ms" << std::setw(14) << "Peak RSS KB"
+        << std::setw(10) << "Blocks" << std::setw(10) << "Freed" << std::setw(16) << "Fragmentation" << std::endl;
+
+    for (const SReplayConfiguration& configuration : configurations) {
+        SReplayResult result;
+        if (!replayInProcess(configuration, operations, object_count, result)) {
+            std::cout << "Replay failed" << std::endl;
+            return 1;
+        }
+
+        std::string name = configuration.useMalloc ? "malloc" : "MemoryPool " + std::to_string(configuration.blockSize) + (configuration.freeLists ? " (free lists)" : "");
+        std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2) << std::setw(12) << result.milliseconds << std::setw(14) << result.peakRssGrowth;
+        if (configuration.useMalloc) std::cout << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(16) << "-" << std::endl;
+        else {
+            // Share of the reserved bytes that were not used at the peaks
+            double fragmentation = result.peakBytesReserved != 0 ? 100.0 * (1.0 - (double) result.peakBytesUsed / result.peakBytesReserved) : 0;
+            std::cout << std::setw(10) << result.blocksCreated << std::setw(10) << result.blocksFreed << std::setw(15) << fragmentation << "%" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "../MemoryPool.h"
+#include "../MMapBlockProvider.h"
+
+#define REQUESTS 200000
+#define REQUEST_SIZE 256
+
+// Latency of each of the first requests of a service, every request allocates & fills a buffer
+void firstRequests(const char* name, AppShift::Memory::MemoryBlockProvider* provider, bool reserve, bool prefault) {
+    std::vector<double> latencies(REQUESTS);
+
+    auto warm_up_start = std::chrono::steady_clock::now();
+    AppShift::Memory::MemoryPool mp(MEMORYPOOL_DEFAULT_BLOCK_SIZE, provider);
+    if (reserve) mp.reserve(REQUESTS * (REQUEST_SIZE + sizeof(AppShift::Memory::SMemoryUnitHeader)), prefault);
+    std::chrono::duration<double, std::milli> warm_up = std::chrono::steady_clock::now() - warm_up_start;
+
+    for (int i = 0; i < REQUESTS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        std::memset(mp.allocate(REQUEST_SIZE), i, REQUEST_SIZE);
+        latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double total = 0;
+    for (double latency : latencies) total += latency;
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name << ": warm-up " << warm_up.count() << "ms, requests " << total / 1000000 << "ms, p50 " << latencies[REQUESTS / 2]
+        << "ns, p99 " << latencies[REQUESTS * 99 / 100] << "ns, p99.9 " << latencies[REQUESTS * 999 / 1000] << "ns, max " << latencies[REQUESTS - 1] << "ns" << std::endl;
+}
+
+int main() {
+    // Blocks are mapped from the OS so every configuration starts with pages that were never touched
+    AppShift::Memory::MMapBlockProvider mmap_provider;
+    AppShift::Memory::MMapBlockProvider populate_provider(true);
+
+    firstRequests("No warm-up", &mmap_provider, false, false);
+    firstRequests("reserve", &mmap_provider, true, false);
+    firstRequests("reserve & prefault", &mmap_provider, true, true);
+    firstRequests("reserve with MAP_POPULATE", &populate_provider, true, false);
+    return 0;
+}
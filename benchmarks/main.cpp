@@ -19,54 +19,352 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <memory_resource>
 #include "../MemoryPool.h"
-#include "String.h"
-#include "STDString.h"
-#include <time.h>
-
-int main() {
-    AppShift::Memory::MemoryPool * mp = new AppShift::Memory::MemoryPool();
-
-    clock_t t;
-    long double benchavg = 0;
-    long double benchavg_new = 0;
-
-    for (long long int j = 0; j < 100; j++) {
-        t = clock();
-        for (int i = 0; i < 1000000; i++) {
-            AppShift::String strs(mp, "The Big World Is Great And Shit"); // Allocation
-            strs += "Some new stuff"; // Re-allocation
-        } // Dellocation
-        t = clock() - t;
-        benchavg += (t / (j + 1)) - (benchavg / (j + 1));
+#include "Benchmark.h"
+
+using AppShift::Benchmark::Recorder;
+using AppShift::Benchmark::SResult;
+
+// Operations shared by all the allocators, generated once so every allocator runs the same workload
+struct SWorkload {
+    size_t rounds;
+    std::vector<size_t> mixedSizes;
+    std::vector<size_t> largeSizes;
+    std::vector<size_t> freeOrder;
+    std::vector<size_t> victims;
+};
+
+#define WORKING_SET 1000
+#define SCOPE_ALLOCATIONS 64
+
+// Sizes of typical objects: mostly small, some medium & a few big
+size_t mixedSize(std::mt19937& random) {
+    size_t kind = random() % 100;
+    if (kind < 60) return 8 + random() % 57;
+    if (kind < 90) return 64 + random() % 449;
+    if (kind < 99) return 512 + random() % 3585;
+    return 4096 + random() % 28673;
+}
+
+SWorkload createWorkload(size_t rounds) {
+    SWorkload workload;
+    std::mt19937 random(42);
+    workload.rounds = rounds;
+    for (size_t i = 0; i < WORKING_SET; i++) workload.mixedSizes.push_back(mixedSize(random));
+    for (size_t i = 0; i < 64; i++) workload.largeSizes.push_back(64 * 1024 + random() % (960 * 1024));
+    for (size_t i = 0; i < WORKING_SET; i++) workload.freeOrder.push_back(i);
+    std::shuffle(workload.freeOrder.begin(), workload.freeOrder.end(), random);
+    for (size_t i = 0; i < WORKING_SET; i++) workload.victims.push_back(random() % (WORKING_SET / 4));
+    return workload;
+}
+
+// Allocators compared by the scenarios, all with the same interface
+struct MallocAllocator {
+    static constexpr const char* name = "malloc";
+    static constexpr bool hasScopes = false;
+    static constexpr bool reusesMemory = true;
+    void* allocate(size_t size) { return std::malloc(size); }
+    void* reallocate(void* unit, size_t, size_t new_size) { return std::realloc(unit, new_size); }
+    void free(void* unit, size_t) { std::free(unit); }
+    void startScope() {}
+    void endScope() {}
+    void endRound() {}
+};
+
+template<bool free_lists>
+struct PoolAllocator {
+    static constexpr const char* name = free_lists ? "MemoryPool (free lists)" : "MemoryPool";
+    static constexpr bool hasScopes = true;
+    static constexpr bool reusesMemory = true;
+    AppShift::Memory::MemoryPool pool;
+    PoolAllocator() { this->pool.enableFreeLists(free_lists); }
+    void* allocate(size_t size) { return this->pool.allocate(size); }
+    void* reallocate(void* unit, size_t, size_t new_size) { return this->pool.reallocate(unit, new_size); }
+    void free(void* unit, size_t) { this->pool.free(unit); }
+    void startScope() { this->pool.startScope(); }
+    void endScope() { this->pool.endScope(); }
+    void endRound() {}
+};
+
+// Never frees, everything is dropped at the end of a scope or a round
+struct MonotonicAllocator {
+    static constexpr const char* name = "pmr::monotonic_buffer";
+    static constexpr bool hasScopes = true;
+    static constexpr bool reusesMemory = false;
+    std::pmr::monotonic_buffer_resource resource;
+    void* allocate(size_t size) { return this->resource.allocate(size, alignof(std::max_align_t)); }
+    void* reallocate(void* unit, size_t size, size_t new_size) {
+        void* new_unit = this->allocate(new_size);
+        std::memcpy(new_unit, unit, size < new_size ? size : new_size);
+        return new_unit;
     }
+    void free(void*, size_t) {}
+    void startScope() {}
+    void endScope() { this->resource.release(); }
+    void endRound() { this->resource.release(); }
+};
 
-    std::cout << "AppShift Library: " << (benchavg * 1000) / CLOCKS_PER_SEC << std::endl;
+struct PoolResourceAllocator {
+    static constexpr const char* name = "pmr::unsync_pool";
+    static constexpr bool hasScopes = false;
+    static constexpr bool reusesMemory = true;
+    std::pmr::unsynchronized_pool_resource resource;
+    void* allocate(size_t size) { return this->resource.allocate(size, alignof(std::max_align_t)); }
+    void* reallocate(void* unit, size_t size, size_t new_size) {
+        void* new_unit = this->allocate(new_size);
+        std::memcpy(new_unit, unit, size < new_size ? size : new_size);
+        this->free(unit, size);
+        return new_unit;
+    }
+    void free(void* unit, size_t size) { this->resource.deallocate(unit, size, alignof(std::max_align_t)); }
+    void startScope() {}
+    void endScope() {}
+    void endRound() {}
+};
 
-    for (long long int j = 0; j < 100; j++) {
-        t = clock();
-        for (int i = 0; i < 1000000; i++) {
-            AppShift::STDString strs("The Big World Is Great And Shit"); // Allocation
-            strs += "Some new stuff"; // Re-allocation
-        } // Dellocation
-        t = clock() - t;
-        benchavg_new += (t / (j + 1)) - (benchavg_new / (j + 1));
+// Allocate a working set of the same size, free it in reverse order
+template<typename Allocator>
+SResult lifoScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    std::vector<void*> units(WORKING_SET);
+    for (size_t round = 0; round < workload.rounds; round++) {
+        recorder.time(WORKING_SET, [&](size_t i) { units[i] = allocator.allocate(64); *static_cast<char*>(units[i]) = 1; });
+        recorder.time(WORKING_SET, [&](size_t i) { allocator.free(units[WORKING_SET - 1 - i], 64); });
+        allocator.endRound();
     }
+    return recorder.finish();
+}
 
-    std::cout << "AppShift Library with regular new/delete: " << (benchavg_new * 1000) / CLOCKS_PER_SEC << std::endl;
-    std::cout << "MemoryPool is " << benchavg_new / benchavg << " Times faster than new/delete" << std::endl;
-
-    benchavg = 0;
-    for (long long int j = 0; j < 100; j++) {
-        t = clock();
-        for (int i = 0; i < 1000000; i++) {
-            std::string strs("The Big World Is Great And Shit"); // Allocation
-            strs += "Some new stuff"; // Rellocation
-        } // Dellocation
-        t = clock() - t;
-        benchavg += (t / (j + 1)) - (benchavg / (j + 1));
+// Allocate a working set of the same size, free it in allocation order
+template<typename Allocator>
+SResult fifoScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    std::vector<void*> units(WORKING_SET);
+    for (size_t round = 0; round < workload.rounds; round++) {
+        recorder.time(WORKING_SET, [&](size_t i) { units[i] = allocator.allocate(64); *static_cast<char*>(units[i]) = 1; });
+        recorder.time(WORKING_SET, [&](size_t i) { allocator.free(units[i], 64); });
+        allocator.endRound();
     }
+    return recorder.finish();
+}
+
+// Allocate a working set of mixed sizes, free it in random order
+template<typename Allocator>
+SResult randomScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    std::vector<void*> units(WORKING_SET);
+    for (size_t round = 0; round < workload.rounds; round++) {
+        recorder.time(WORKING_SET, [&](size_t i) { units[i] = allocator.allocate(workload.mixedSizes[i]); *static_cast<char*>(units[i]) = 1; });
+        recorder.time(WORKING_SET, [&](size_t i) { size_t index = workload.freeOrder[i]; allocator.free(units[index], workload.mixedSizes[index]); });
+        allocator.endRound();
+    }
+    return recorder.finish();
+}
+
+// Steady state of a long running service: every allocation of a mixed size replaces a random live object
+template<typename Allocator>
+SResult mixedScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    std::vector<void*> units(WORKING_SET / 4);
+    std::vector<size_t> sizes(WORKING_SET / 4);
+    for (size_t i = 0; i < units.size(); i++) {
+        sizes[i] = workload.mixedSizes[i];
+        units[i] = allocator.allocate(sizes[i]);
+    }
+
+    for (size_t round = 0; round < workload.rounds; round++) {
+        recorder.time(WORKING_SET, [&](size_t i) {
+            size_t victim = workload.victims[i];
+            allocator.free(units[victim], sizes[victim]);
+            sizes[victim] = workload.mixedSizes[i];
+            units[victim] = allocator.allocate(sizes[victim]);
+            *static_cast<char*>(units[victim]) = 1;
+        });
+    }
+
+    for (size_t i = 0; i < units.size(); i++) allocator.free(units[i], sizes[i]);
+    allocator.endRound();
+    return recorder.finish();
+}
+
+// Buffers growing by steps of 64 bytes, two at a time so only one of them is last in its block
+template<typename Allocator>
+SResult reallocScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    for (size_t round = 0; round < workload.rounds; round++) {
+        void* buffers[2] = { allocator.allocate(64), allocator.allocate(64) };
+        size_t sizes[2] = { 64, 64 };
+        recorder.time(WORKING_SET, [&](size_t i) {
+            size_t buffer = i % 2;
+            buffers[buffer] = allocator.reallocate(buffers[buffer], sizes[buffer], sizes[buffer] + 64);
+            sizes[buffer] += 64;
+            static_cast<char*>(buffers[buffer])[sizes[buffer] - 1] = 1;
+        });
+        allocator.free(buffers[1], sizes[1]);
+        allocator.free(buffers[0], sizes[0]);
+        allocator.endRound();
+    }
+    return recorder.finish();
+}
 
-    std::cout << "Standard Library: " << (benchavg * 1000) / CLOCKS_PER_SEC << std::endl;
+// Requests allocating small objects that are all dropped when the request ends
+template<typename Allocator>
+SResult scopeScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    std::vector<void*> units(SCOPE_ALLOCATIONS);
+    for (size_t round = 0; round < workload.rounds; round++) {
+        recorder.time(WORKING_SET, [&](size_t i) {
+            size_t index = i % SCOPE_ALLOCATIONS;
+            if (index == 0) allocator.startScope();
+            units[index] = allocator.allocate(workload.mixedSizes[i] % 128 + 8);
+            *static_cast<char*>(units[index]) = 1;
+            if (index != SCOPE_ALLOCATIONS - 1 && i != WORKING_SET - 1) return;
+
+            if constexpr (Allocator::hasScopes) allocator.endScope();
+            else for (size_t j = 0; j <= index; j++) allocator.free(units[j], workload.mixedSizes[i - index + j] % 128 + 8);
+        });
+    }
+    return recorder.finish();
+}
+
+// Objects of 64KB to 1MB, a few of them alive at a time
+template<typename Allocator>
+SResult largeScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    size_t count = workload.largeSizes.size();
+    std::vector<void*> units(count);
+    for (size_t round = 0; round < workload.rounds / 10 + 1; round++) {
+        recorder.time(count, [&](size_t i) {
+            if (i >= 4) allocator.free(units[i - 4], workload.largeSizes[i - 4]);
+            units[i] = allocator.allocate(workload.largeSizes[i]);
+            static_cast<char*>(units[i])[workload.largeSizes[i] - 1] = 1;
+        });
+        for (size_t i = count - 4; i < count; i++) allocator.free(units[i], workload.largeSizes[i]);
+        allocator.endRound();
+    }
+    return recorder.finish();
+}
+
+// The mixed scenario in multiple threads, each with its own allocator
+template<typename Allocator>
+SResult threadsScenario(Allocator&, const SWorkload& workload) {
+    size_t thread_count = std::thread::hardware_concurrency();
+    if (thread_count < 2) thread_count = 2;
+    if (thread_count > 8) thread_count = 8;
+
+    std::vector<Recorder> recorders(thread_count);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&workload, &recorders, t]() {
+            Allocator allocator;
+            std::vector<void*> units(WORKING_SET / 4);
+            std::vector<size_t> sizes(WORKING_SET / 4);
+            for (size_t i = 0; i < units.size(); i++) {
+                sizes[i] = workload.mixedSizes[(i + t) % WORKING_SET];
+                units[i] = allocator.allocate(sizes[i]);
+            }
+            for (size_t round = 0; round < workload.rounds; round++) {
+                recorders[t].time(WORKING_SET, [&](size_t i) {
+                    size_t victim = workload.victims[(i + t) % WORKING_SET];
+                    allocator.free(units[victim], sizes[victim]);
+                    sizes[victim] = workload.mixedSizes[i];
+                    units[victim] = allocator.allocate(sizes[victim]);
+                    *static_cast<char*>(units[victim]) = 1;
+                });
+            }
+            for (size_t i = 0; i < units.size(); i++) allocator.free(units[i], sizes[i]);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    Recorder recorder;
+    for (Recorder& thread_recorder : recorders) recorder.merge(thread_recorder);
+    return recorder.finish(thread_count, elapsed.count());
+}
+
+// The original benchmark: create a string, append to it & destroy it
+template<typename Allocator>
+SResult stringScenario(Allocator& allocator, const SWorkload& workload) {
+    Recorder recorder;
+    const char* text = "The Big World Is Great And Shit";
+    const char* appended = "Some new stuff";
+    for (size_t round = 0; round < workload.rounds; round++) {
+        recorder.time(WORKING_SET, [&](size_t) {
+            char* string = static_cast<char*>(allocator.allocate(32));
+            std::memcpy(string, text, 32);
+            string = static_cast<char*>(allocator.reallocate(string, 32, 46));
+            std::memcpy(string + 31, appended, 15);
+            allocator.free(string, 46);
+        });
+        allocator.endRound();
+    }
+    return recorder.finish();
+}
+
+// Run a scenario with every allocator, each on a fresh allocator after a warm-up run.
+// Scenarios that never drop all their objects are only run with allocators that reuse freed memory.
+template<typename... Allocators, typename Scenario>
+void runScenario(const std::string& name, bool steady_state, Scenario scenario, const SWorkload& workload, const SWorkload& warm_up, std::vector<SResult>& results) {
+    auto run = [&](auto* allocator) {
+        using Allocator = std::remove_pointer_t<decltype(allocator)>;
+        if (steady_state && !Allocator::reusesMemory) return;
+        scenario(*allocator, warm_up);
+        SResult result = scenario(*allocator, workload);
+        result.scenario = name;
+        result.allocator = Allocator::name;
+        results.push_back(result);
+    };
+    (run(std::make_unique<Allocators>().get()), ...);
+}
+
+#define SCENARIO(name, steady_state, function) \
+    if (only.empty() || only == name) runScenario<MallocAllocator, PoolAllocator<false>, PoolAllocator<true>, MonotonicAllocator, PoolResourceAllocator>( \
+        name, steady_state, [](auto& allocator, const SWorkload& workload) { return function(allocator, workload); }, workload, warm_up, results);
+
+int main(int argc, char** argv) {
+    size_t rounds = 1000;
+    std::string only, csv_path, json_path;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--quick") rounds = 50;
+        else if (argument == "--scenario" && i + 1 < argc) only = argv[++i];
+        else if (argument == "--csv" && i + 1 < argc) csv_path = argv[++i];
+        else if (argument == "--json" && i + 1 < argc) json_path = argv[++i];
+        else {
+            std::cout << "Usage: " << argv[0] << " [--quick] [--scenario name] [--csv file] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    SWorkload workload = createWorkload(rounds);
+    SWorkload warm_up = createWorkload(rounds / 10 + 1);
+    std::vector<SResult> results;
+
+    SCENARIO("lifo", false, lifoScenario)
+    SCENARIO("fifo", false, fifoScenario)
+    SCENARIO("random", false, randomScenario)
+    SCENARIO("mixed", true, mixedScenario)
+    SCENARIO("realloc", false, reallocScenario)
+    SCENARIO("scope", false, scopeScenario)
+    SCENARIO("large", false, largeScenario)
+    SCENARIO("threads", true, threadsScenario)
+    SCENARIO("string", false, stringScenario)
+
+    AppShift::Benchmark::printTable(results, std::cout);
+    if (!csv_path.empty()) {
+        std::ofstream csv(csv_path);
+        AppShift::Benchmark::writeCsv(results, csv);
+    }
+    if (!json_path.empty()) {
+        std::ofstream json(json_path);
+        AppShift::Benchmark::writeJson(results, json);
+    }
     return 0;
 }
@@ -0,0 +1,181 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define UNIT_HEADER sizeof(AppShift::Memory::SMemoryUnitHeader)
+
+size_t blockCount(AppShift::Memory::MemoryPool& mp) {
+    size_t blocks = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) blocks++;
+    return blocks;
+}
+
+// Check the chain links & that every block but the current one is indexed
+int checkChain(AppShift::Memory::MemoryPool& mp) {
+    size_t indexed = 0;
+    AppShift::Memory::SMemoryBlockHeader* prev = nullptr;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) {
+        CHECK(block->prev == prev);
+        CHECK((block == mp.currentBlock) == (block->spaceBin == SIZE_MAX));
+        prev = block;
+    }
+    CHECK(prev == mp.currentBlock);
+
+    for (size_t bin = 0; bin < MEMORYPOOL_SPACE_BINS; bin++)
+        for (AppShift::Memory::SMemoryBlockHeader* block = mp.spaceBins[bin]; block != nullptr; block = block->nextSpaceBlock) indexed++;
+    CHECK(indexed == blockCount(mp) - 1);
+    return 0;
+}
+
+int testGrowth() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.enableAdaptiveBlockSize(32 * 1024);
+
+    // Every new block is twice the size of the previous one, up to the maximum
+    size_t expected[] = { 4096, 8192, 16384, 32768, 32768, 32768 };
+    for (size_t i = 1; i < sizeof(expected) / sizeof(size_t); i++) {
+        while (mp.currentBlock->blockSize - mp.currentBlock->offset >= 256 + UNIT_HEADER) mp.allocate(256);
+        mp.allocate(256);
+        CHECK(mp.currentBlock->blockSize == expected[i]);
+    }
+    CHECK(blockCount(mp) == 6);
+    CHECK(checkChain(mp) == 0);
+
+    // Fixed sizing by default
+    AppShift::Memory::MemoryPool fixed(4096);
+    for (int i = 0; i < 1000; i++) fixed.allocate(256);
+    for (AppShift::Memory::SMemoryBlockHeader* block = fixed.firstBlock; block != nullptr; block = block->next) CHECK(block->blockSize == 4096);
+    return 0;
+}
+
+int testShrink() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.enableAdaptiveBlockSize(64 * 1024);
+
+    std::vector<void*> units;
+    for (int i = 0; i < 1000; i++) units.push_back(mp.allocate(256));
+    CHECK(mp.nextBlockSize == 64 * 1024);
+    for (void* unit : units) mp.free(unit);
+    units.clear();
+
+    // Blocks filled with short lived units bring the size back down to the default
+    for (int i = 0; i < 2000; i++) {
+        units.push_back(mp.allocate(256));
+        if (units.size() == 8) {
+            for (void* unit : units) mp.free(unit);
+            units.clear();
+        }
+    }
+    CHECK(mp.nextBlockSize == mp.defaultBlockSize);
+    CHECK(mp.currentBlock->blockSize <= 2 * mp.defaultBlockSize);
+
+    // And the big blocks are not kept
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.retainedBlocks; block != nullptr; block = block->next)
+        CHECK(block->blockSize <= 2 * mp.defaultBlockSize);
+    CHECK(checkChain(mp) == 0);
+    return 0;
+}
+
+int testDedicatedBlocks() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.allocate(100);
+    AppShift::Memory::SMemoryBlockHeader* current = mp.currentBlock;
+    size_t offset = current->offset;
+
+    // Units bigger than a block get a block of their own, the current block stays
+    char* big = mp.allocate<char>(100000);
+    CHECK(mp.currentBlock == current);
+    CHECK(blockCount(mp) == 2);
+    CHECK(mp.firstBlock != current);
+    CHECK(checkChain(mp) == 0);
+    for (int i = 0; i < 100000; i++) big[i] = (char) i;
+
+    char* aligned = reinterpret_cast<char*>(mp.allocateAligned(50000, 4096));
+    CHECK(reinterpret_cast<uintptr_t>(aligned) % 4096 == 0);
+    CHECK(mp.currentBlock == current);
+    CHECK(blockCount(mp) == 3);
+    CHECK(checkChain(mp) == 0);
+
+    // Small units keep going to the current block
+    mp.allocate(100);
+    CHECK(mp.currentBlock == current);
+    CHECK(current->offset >= offset + 100 + UNIT_HEADER);
+
+    // Freeing the big units releases their blocks
+    mp.free(big);
+    mp.free(aligned);
+    CHECK(blockCount(mp) == 1);
+    CHECK(checkChain(mp) == 0);
+
+    // Inside a scope the big units are released when it ends
+    mp.startScope();
+    for (int i = 0; i < 40; i++) mp.allocate(100);
+    mp.allocate(100000);
+    mp.allocate(100);
+    CHECK(checkChain(mp) == 0);
+    mp.endScope();
+    CHECK(blockCount(mp) == 1);
+    CHECK(mp.currentBlock == current);
+    CHECK(checkChain(mp) == 0);
+    return 0;
+}
+
+int testRandom() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.enableAdaptiveBlockSize(256 * 1024);
+    std::mt19937 random(21);
+    std::vector<std::pair<unsigned char*, size_t>> live;
+
+    for (int round = 0; round < 20000; round++) {
+        if (live.empty() || random() % 3 != 0) {
+            size_t size = random() % 8 == 0 ? 1 + random() % 20000 : 1 + random() % 200;
+            unsigned char* unit = mp.allocate<unsigned char>(size);
+            std::memset(unit, (unsigned char) size, size);
+            live.push_back({ unit, size });
+        }
+        else {
+            size_t index = random() % live.size();
+            for (size_t i = 0; i < live[index].second; i++) CHECK(live[index].first[i] == (unsigned char) live[index].second);
+            mp.free(live[index].first);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        if (round % 1000 == 0) CHECK(checkChain(mp) == 0);
+    }
+    for (auto& unit : live) mp.free(unit.first);
+    CHECK(checkChain(mp) == 0);
+    return 0;
+}
+
+int main() {
+    if (testGrowth() != 0) return 1;
+    if (testShrink() != 0) return 1;
+    if (testDedicatedBlocks() != 0) return 1;
+    if (testRandom() != 0) return 1;
+
+    std::cout << "Adaptive blocks tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <vector>
+#include "../../MemoryPool.h"
+#include "../../MMapBlockProvider.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+#define IS_ALIGNED(pointer, alignment) (reinterpret_cast<uintptr_t>(pointer) % (alignment) == 0)
+
+// Get the block of an allocated pointer
+AppShift::Memory::SMemoryBlockHeader* getBlock(void* unit_pointer_start) {
+    return AppShift::Memory::MemoryPool::getContainer(reinterpret_cast<AppShift::Memory::SMemoryUnitHeader*>(unit_pointer_start) - 1);
+}
+
+int testLayout() {
+    static_assert(sizeof(AppShift::Memory::SMemoryUnitHeader) == sizeof(size_t), "Unit header must only hold the length");
+
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    CHECK(IS_ALIGNED(mp.firstBlock, MEMORYPOOL_BLOCK_ALIGNMENT));
+
+    // Consecutive units are only a length apart
+    char* first = mp.allocate<char>(24);
+    char* second = mp.allocate<char>(24);
+    CHECK(second - first == 24 + sizeof(size_t));
+    CHECK(getBlock(first) == mp.firstBlock);
+
+    // Every block is aligned, and units find their block
+    std::vector<char*> units;
+    for (int i = 0; i < 10000; i++) {
+        char* unit = mp.allocate<char>(16 + i % 33);
+        unit[0] = (char) i;
+        units.push_back(unit);
+        CHECK(getBlock(unit) == mp.currentBlock);
+        CHECK(IS_ALIGNED(mp.currentBlock, MEMORYPOOL_BLOCK_ALIGNMENT));
+    }
+    for (size_t i = 0; i < units.size(); i++) CHECK(units[i][0] == (char) i);
+    for (char* unit : units) mp.free(unit);
+
+    return 0;
+}
+
+int testDedicatedBlocks() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+
+    // Units bigger than the block alignment get a block of their own, before the current block
+    char* small = mp.allocate<char>(100);
+    char* huge = mp.allocate<char>(3 * MEMORYPOOL_BLOCK_ALIGNMENT);
+    huge[3 * MEMORYPOOL_BLOCK_ALIGNMENT - 1] = 1;
+    CHECK(getBlock(huge) == mp.firstBlock);
+    CHECK(getBlock(small) == mp.currentBlock);
+
+    // The dedicated block takes no other units, even after the huge unit is gone
+    char* after = mp.allocate<char>(100);
+    CHECK(getBlock(after) == getBlock(small));
+    huge = mp.reallocate<char>(huge, 4 * MEMORYPOOL_BLOCK_ALIGNMENT);
+    CHECK(getBlock(huge) != mp.currentBlock);
+    CHECK(getBlock(huge)->numberOfAllocated == 1);
+    mp.free(huge);
+    mp.free(after);
+    mp.free(small);
+
+    // Default blocks bigger than the alignment only use their first aligned window
+    AppShift::Memory::MemoryPool big_mp(2 * MEMORYPOOL_BLOCK_ALIGNMENT);
+    for (int i = 0; i < 100; i++) {
+        char* unit = big_mp.allocate<char>(64 * 1024);
+        CHECK(getBlock(unit) == big_mp.currentBlock);
+        CHECK(reinterpret_cast<char*>(unit) - reinterpret_cast<char*>(big_mp.currentBlock) < (ptrdiff_t) MEMORYPOOL_BLOCK_ALIGNMENT);
+    }
+
+    return 0;
+}
+
+int testFeatures() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+
+    // Aligned allocations, scopes, free lists & garbage compression work on the compact headers
+    for (size_t alignment = 16; alignment <= 4096; alignment *= 2) {
+        void* aligned = mp.allocateAligned(100, alignment);
+        CHECK(IS_ALIGNED(aligned, alignment));
+        CHECK(getBlock(aligned) == mp.currentBlock);
+    }
+
+    mp.startScope();
+    for (int i = 0; i < 5000; i++) mp.allocate<char>(48);
+    mp.endScope();
+    CHECK(mp.currentBlock == mp.firstBlock);
+
+    mp.enableFreeLists();
+    std::vector<char*> units;
+    for (int i = 0; i < 5000; i++) units.push_back(mp.allocate<char>(32));
+    for (size_t i = 0; i < units.size(); i += 2) mp.free(units[i]);
+    for (size_t i = 0; i < units.size(); i += 2) {
+        units[i] = mp.allocate<char>(32);
+        CHECK(getBlock(units[i]) != nullptr);
+    }
+    for (size_t i = 1; i < units.size(); i += 2) mp.free(units[i]);
+    mp.compressGarbage();
+    for (size_t i = 0; i < units.size(); i += 2) mp.free(units[i]);
+    CHECK(mp.currentBlock == mp.firstBlock);
+
+    // Providers align the blocks they map
+    AppShift::Memory::MMapBlockProvider provider;
+    AppShift::Memory::MemoryPool mmap_mp(64 * 1024, &provider);
+    for (int i = 0; i < 100; i++) CHECK(IS_ALIGNED(getBlock(mmap_mp.allocate<char>(16 * 1024)), MEMORYPOOL_BLOCK_ALIGNMENT));
+
+    AppShift::Memory::RegionBlockProvider region(64 * MEMORYPOOL_BLOCK_ALIGNMENT);
+    AppShift::Memory::MemoryPool region_mp(64 * 1024, &region);
+    for (int i = 0; i < 100; i++) CHECK(region.contains(region_mp.allocate<char>(16 * 1024)));
+    CHECK(IS_ALIGNED(region_mp.currentBlock, MEMORYPOOL_BLOCK_ALIGNMENT));
+
+    return 0;
+}
+
+int testLargeBatch() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    std::vector<void*> units(1000000);
+    mp.allocateBatch(units.size(), 32, units.data());
+
+    // Blocks of a batch are no bigger than the window units can start in
+    size_t unit_size = sizeof(AppShift::Memory::SMemoryUnitHeader) + 32;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next)
+        CHECK(block->blockSize <= MEMORYPOOL_BLOCK_ALIGNMENT);
+    CHECK(mp.getStats().bytesReserved < 2 * units.size() * unit_size);
+    for (size_t i = 0; i < units.size(); i += 1000) CHECK(getBlock(units[i]) != nullptr);
+    mp.freeBatch(units.data(), units.size());
+    return 0;
+}
+
+int main() {
+    if (testLayout() != 0) return 1;
+    if (testDedicatedBlocks() != 0) return 1;
+    if (testFeatures() != 0) return 1;
+    if (testLargeBatch() != 0) return 1;
+
+    std::cout << "Address masking tests passed" << std::endl;
+    return 0;
+}
@@ -19,10 +19,192 @@
  */
 
 #include <iostream>
+#include <vector>
+#include <random>
+#include <sstream>
 #include "../../MemoryPool.h"
 
-AppShift::Memory::MemoryPool testPool (256 * 1024);
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+// Count the blocks in the pool
+size_t countBlocks(AppShift::Memory::MemoryPool& mp) {
+    size_t count = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) count++;
+    return count;
+}
+
+int testFreeListReuse() {
+    AppShift::Memory::MemoryPool mp(256 * 1024);
+    mp.enableFreeLists();
+
+    char* first = mp.allocate<char>(30);
+    char* second = mp.allocate<char>(30);
+    char* third = mp.allocate<char>(30);
+    size_t offset = mp.currentBlock->offset;
+
+    // An interior unit is reused by an allocation of the same size class
+    mp.free(second);
+    CHECK(mp.currentBlock->numberOfDeleted == 1);
+    char* reused = mp.allocate<char>(20);
+    CHECK(reused == second);
+    CHECK(mp.currentBlock->numberOfDeleted == 0);
+    CHECK(mp.currentBlock->offset == offset);
+
+    // Other size classes still move the offset
+    mp.free(reused);
+    char* bigger = mp.allocate<char>(100);
+    CHECK(bigger != second);
+
+    // Disabling keeps the unit as a plain deleted unit
+    mp.enableFreeLists(false);
+    char* after_disable = mp.allocate<char>(32);
+    CHECK(after_disable != second);
+
+    mp.free(after_disable);
+    mp.free(bigger);
+    mp.free(third);
+    mp.free(first);
+    return 0;
+}
+
+int testRandomOrderFrees() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    mp.enableFreeLists();
+    std::mt19937 random(7);
+    std::vector<unsigned char*> live;
+
+    for (int i = 0; i < 2000; i++) {
+        unsigned char* unit = mp.allocate<unsigned char>(16 + random() % 200);
+        unit[0] = (unsigned char) i;
+        live.push_back(unit);
+    }
+    size_t blocks = countBlocks(mp);
+
+    // Replace random units many times, the pool should not keep growing
+    for (int i = 0; i < 200000; i++) {
+        size_t index = random() % live.size();
+        mp.free(live[index]);
+        live[index] = mp.allocate<unsigned char>(16 + random() % 200);
+    }
+    CHECK(countBlocks(mp) <= blocks * 2);
+
+    for (unsigned char* unit : live) mp.free(unit);
+    return 0;
+}
+
+int testScopesWithFreeLists() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    mp.enableFreeLists();
+
+    char* before = mp.allocate<char>(64);
+    mp.startScope();
+    std::vector<char*> units;
+    for (int i = 0; i < 200; i++) units.push_back(mp.allocate<char>(64));
+
+    // Units freed inside the scope are not reused while it is open
+    mp.free(units[10]);
+    char* inside = mp.allocate<char>(64);
+    CHECK(inside != units[10]);
+    mp.endScope();
+    CHECK(mp.currentScope == nullptr);
+
+    // Nothing of the scope is left in the free lists
+    for (size_t i = 0; i < MEMORYPOOL_FREELIST_BINS; i++) CHECK(mp.freeLists[i] == nullptr);
+
+    mp.free(before);
+    return 0;
+}
+
+int testCompressGarbage() {
+    AppShift::Memory::MemoryPool mp(256 * 1024);
+    size_t unit_size = sizeof(AppShift::Memory::SMemoryUnitHeader) + 32;
+
+    char* first = mp.allocate<char>(32);
+    char* second = mp.allocate<char>(32);
+    char* third = mp.allocate<char>(32);
+    char* fourth = mp.allocate<char>(32);
+
+    // Neighbouring deleted units are merged into one
+    mp.free(second);
+    mp.free(third);
+    CHECK(mp.compressGarbage() == 0);
+    CHECK(mp.currentBlock->numberOfAllocated == 3);
+    CHECK(mp.currentBlock->numberOfDeleted == 1);
+
+    // Deleted units reaching the end of the block are given back to it
+    mp.free(fourth);
+    CHECK(mp.currentBlock->offset == 3 * unit_size);
+    CHECK(mp.compressGarbage() == 2 * unit_size);
+    CHECK(mp.currentBlock->offset == unit_size);
+    CHECK(mp.currentBlock->numberOfAllocated == 1);
+    CHECK(mp.currentBlock->numberOfDeleted == 0);
+
+    // The space is used again
+    CHECK(mp.allocate<char>(32) == second);
+    mp.free(second);
+    mp.free(first);
+    return 0;
+}
+
+int testIncrementalCompress() {
+    AppShift::Memory::MemoryPool mp(1024);
+    std::vector<char*> units;
+    for (int i = 0; i < 100; i++) units.push_back(mp.allocate<char>(100));
+    size_t blocks = countBlocks(mp);
+    CHECK(blocks > 3);
+
+    // Keep one unit alive at the start of each block, delete everything else
+    for (char* unit : units) {
+        AppShift::Memory::SMemoryUnitHeader* header = reinterpret_cast<AppShift::Memory::SMemoryUnitHeader*>(unit) - 1;
+        if (header != reinterpret_cast<AppShift::Memory::SMemoryUnitHeader*>(AppShift::Memory::MemoryPool::getContainer(header) + 1)) mp.free(unit);
+    }
+
+    // Every call goes over a single block
+    size_t reclaimed = 0;
+    for (size_t i = 0; i < blocks; i++) reclaimed += mp.compressGarbage(1);
+    CHECK(reclaimed > 0);
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) {
+        CHECK(block->numberOfDeleted == 0);
+        CHECK(block->offset == sizeof(AppShift::Memory::SMemoryUnitHeader) + 104);
+    }
+    return 0;
+}
+
+int testCompressWithFreeLists() {
+    AppShift::Memory::MemoryPool mp(256 * 1024);
+    mp.enableFreeLists();
+
+    char* first = mp.allocate<char>(32);
+    char* second = mp.allocate<char>(32);
+    char* third = mp.allocate<char>(32);
+    mp.free(first);
+    mp.free(second);
+
+    // The merged unit is reused by a bigger size class
+    mp.compressGarbage();
+    CHECK(mp.allocate<char>(32 + sizeof(AppShift::Memory::SMemoryUnitHeader) + 32) == first);
+
+    // Dump shows deleted units
+    mp.free(first);
+    std::stringstream dump;
+    std::streambuf* cout_buffer = std::cout.rdbuf(dump.rdbuf());
+    mp.dumpPoolData();
+    std::cout.rdbuf(cout_buffer);
+    CHECK(dump.str().find("(deleted)") != std::string::npos);
+    CHECK(dump.str().find("Deleted units: 1") != std::string::npos);
+
+    mp.free(third);
+    return 0;
+}
 
 int main() {
+    if (testFreeListReuse() != 0) return 1;
+    if (testRandomOrderFrees() != 0) return 1;
+    if (testScopesWithFreeLists() != 0) return 1;
+    if (testCompressGarbage() != 0) return 1;
+    if (testIncrementalCompress() != 0) return 1;
+    if (testCompressWithFreeLists() != 0) return 1;
+
+    std::cout << "Advanced garbage collection tests passed" << std::endl;
     return 0;
 }
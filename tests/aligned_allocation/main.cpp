@@ -0,0 +1,111 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+#define IS_ALIGNED(pointer, alignment) (reinterpret_cast<uintptr_t>(pointer) % (alignment) == 0)
+
+struct alignas(64) CacheLineCounter {
+    long long value;
+};
+
+int testAllocateAligned() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+
+    // Any size & alignment, across blocks
+    for (size_t alignment = 16; alignment <= 4096; alignment *= 2) {
+        for (size_t size = 1; size < 300; size += 37) {
+            mp.allocate<char>(size);
+            void* aligned = mp.allocateAligned(size, alignment);
+            CHECK(IS_ALIGNED(aligned, alignment));
+        }
+    }
+
+    // Plain allocations keep their headers aligned
+    for (size_t size = 1; size < 40; size++) CHECK(IS_ALIGNED(mp.allocate(size), alignof(AppShift::Memory::SMemoryUnitHeader)));
+    return 0;
+}
+
+int testTypedAllocation() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+
+    mp.allocate<char>(3);
+    CacheLineCounter* counters = mp.allocate<CacheLineCounter>(8);
+    CHECK(IS_ALIGNED(counters, 64));
+
+    // Placement new of over-aligned types goes through the aligned operator
+    mp.allocate<char>(5);
+    CacheLineCounter* counter = new (&mp) CacheLineCounter();
+    CHECK(IS_ALIGNED(counter, 64));
+    CacheLineCounter* counter_array = new (&mp) CacheLineCounter[4];
+    CHECK(IS_ALIGNED(counter_array, 64));
+
+    // Plain placement new is aligned like the global new
+    for (int i = 0; i < 100; i++) {
+        long double* number = new (&mp) long double(i);
+        CHECK(IS_ALIGNED(number, __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+        CHECK(IS_ALIGNED(new (&mp) char[3], __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+        mp.allocate<char>(8);
+    }
+
+    // Moving re-allocation keeps the alignment
+    counters[0].value = 42;
+    mp.allocate<char>(1);
+    counters = mp.reallocate<CacheLineCounter>(counters, 64);
+    CHECK(IS_ALIGNED(counters, 64));
+    CHECK(counters[0].value == 42);
+    return 0;
+}
+
+int testFreeAndScopes() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    char* first = mp.allocate<char>(8);
+    size_t offset = mp.currentBlock->offset;
+
+    // The padding is a deleted unit, freed with the aligned unit by compressGarbage
+    void* aligned = mp.allocateAligned(100, 256);
+    CHECK(IS_ALIGNED(aligned, 256));
+    CHECK(mp.currentBlock->numberOfDeleted == 1);
+    mp.free(aligned);
+    mp.compressGarbage();
+    CHECK(mp.currentBlock->offset == offset);
+    CHECK(mp.currentBlock->numberOfDeleted == 0);
+
+    // Scopes roll back the padding too
+    mp.startScope();
+    size_t scope_offset = offset;
+    for (int i = 0; i < 1000; i++) CHECK(IS_ALIGNED(mp.allocateAligned(24, 64), 64));
+    mp.endScope();
+    CHECK(mp.currentBlock->offset == scope_offset);
+
+    mp.free(first);
+    return 0;
+}
+
+int main() {
+    if (testAllocateAligned() != 0) return 1;
+    if (testTypedAllocation() != 0) return 1;
+    if (testFreeAndScopes() != 0) return 1;
+
+    std::cout << "Aligned allocation tests passed" << std::endl;
+    return 0;
+}
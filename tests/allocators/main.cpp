@@ -0,0 +1,155 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include "../../MemoryPoolAllocator.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+#define IS_ALIGNED(pointer, alignment) (reinterpret_cast<uintptr_t>(pointer) % (alignment) == 0)
+
+struct alignas(64) CacheLineCounter {
+    long long value;
+};
+
+// Check if a pointer is inside one of the blocks of a pool
+bool isInPool(AppShift::Memory::MemoryPool* mp, const void* pointer) {
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp->firstBlock; block != nullptr; block = block->next) {
+        const char* start = reinterpret_cast<const char*>(block + 1);
+        if (pointer >= start && pointer < start + block->blockSize) return true;
+    }
+    return false;
+}
+
+// Gives a limited number of blocks, then fails
+class LimitedBlockProvider : public AppShift::Memory::MallocBlockProvider {
+public:
+    size_t blocksLeft = 1;
+
+    void* allocateBlock(size_t size) override {
+        if (this->blocksLeft == 0) return nullptr;
+        this->blocksLeft--;
+        return AppShift::Memory::MallocBlockProvider::allocateBlock(size);
+    }
+
+    void* allocateAlignedBlock(size_t size, size_t alignment) override {
+        if (this->blocksLeft == 0) return nullptr;
+        this->blocksLeft--;
+        return AppShift::Memory::MallocBlockProvider::allocateAlignedBlock(size, alignment);
+    }
+};
+
+int testMemoryResource() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    AppShift::Memory::MemoryPoolResource resource(&mp);
+
+    // Containers allocate in the pool
+    std::pmr::vector<int> numbers(&resource);
+    for (int i = 0; i < 10000; i++) numbers.push_back(i);
+    CHECK(isInPool(&mp, numbers.data()));
+    for (int i = 0; i < 10000; i++) CHECK(numbers[i] == i);
+
+    std::pmr::unordered_map<int, std::pmr::string> names(&resource);
+    for (int i = 0; i < 1000; i++) names.emplace(i, "a string long enough to skip the small buffer " + std::to_string(i));
+    for (int i = 0; i < 1000; i += 2) names.erase(i);
+    CHECK(names.size() == 500);
+    CHECK(names[1] == "a string long enough to skip the small buffer 1");
+    CHECK(isInPool(&mp, names[999].data()));
+
+    // Over-aligned types keep their alignment
+    std::pmr::vector<CacheLineCounter> counters(&resource);
+    for (int i = 0; i < 100; i++) {
+        counters.push_back({ i });
+        CHECK(IS_ALIGNED(counters.data(), 64));
+    }
+
+    // Equality follows the pool
+    AppShift::Memory::MemoryPool other_mp(4 * 1024);
+    AppShift::Memory::MemoryPoolResource same_resource(&mp);
+    AppShift::Memory::MemoryPoolResource other_resource(&other_mp);
+    CHECK(resource == same_resource);
+    CHECK(resource != other_resource);
+    CHECK(resource != *std::pmr::new_delete_resource());
+
+    return 0;
+}
+
+int testAllocator() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    AppShift::Memory::MemoryPoolAllocator<int> allocator(&mp);
+
+    std::vector<int, AppShift::Memory::MemoryPoolAllocator<int>> numbers(allocator);
+    for (int i = 0; i < 10000; i++) numbers.push_back(i);
+    CHECK(isInPool(&mp, numbers.data()));
+
+    // Node containers rebind the allocator
+    std::list<int, AppShift::Memory::MemoryPoolAllocator<int>> nodes(allocator);
+    for (int i = 0; i < 1000; i++) nodes.push_back(i);
+    CHECK(isInPool(&mp, &nodes.back()));
+
+    using MapAllocator = AppShift::Memory::MemoryPoolAllocator<std::pair<const int, int>>;
+    std::map<int, int, std::less<int>, MapAllocator> squares{ MapAllocator(&mp) };
+    for (int i = 0; i < 1000; i++) squares[i] = i * i;
+    CHECK(squares[31] == 961);
+
+    // The pool moves with the container
+    AppShift::Memory::MemoryPool other_mp(4 * 1024);
+    std::vector<int, AppShift::Memory::MemoryPoolAllocator<int>> other_numbers{ AppShift::Memory::MemoryPoolAllocator<int>(&other_mp) };
+    other_numbers = std::move(numbers);
+    CHECK(other_numbers.get_allocator().getPool() == &mp);
+    CHECK(other_numbers[9999] == 9999);
+
+    CHECK(allocator == AppShift::Memory::MemoryPoolAllocator<double>(&mp));
+    CHECK(allocator != AppShift::Memory::MemoryPoolAllocator<int>(&other_mp));
+
+    return 0;
+}
+
+int testOutOfMemory() {
+    LimitedBlockProvider provider;
+    AppShift::Memory::MemoryPool mp(4 * 1024, &provider);
+    AppShift::Memory::MemoryPoolResource resource(&mp);
+    AppShift::Memory::MemoryPoolAllocator<int> allocator(&mp);
+
+    // Pool errors reach the containers as std::bad_alloc
+    bool thrown = false;
+    try { std::pmr::vector<int> numbers(100000, 0, &resource); }
+    catch (const std::bad_alloc&) { thrown = true; }
+    CHECK(thrown);
+
+    thrown = false;
+    try { std::vector<int, AppShift::Memory::MemoryPoolAllocator<int>> numbers(100000, 0, allocator); }
+    catch (const std::bad_alloc&) { thrown = true; }
+    CHECK(thrown);
+    return 0;
+}
+
+int main() {
+    if (testMemoryResource() != 0) return 1;
+    if (testAllocator() != 0) return 1;
+    if (testOutOfMemory() != 0) return 1;
+
+    std::cout << "Allocator tests passed" << std::endl;
+    return 0;
+}
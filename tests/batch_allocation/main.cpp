@@ -0,0 +1,153 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define UNIT_HEADER sizeof(AppShift::Memory::SMemoryUnitHeader)
+
+// Live units in all the blocks of a pool
+size_t liveUnits(AppShift::Memory::MemoryPool& mp) {
+    size_t units = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next)
+        units += block->numberOfAllocated - block->numberOfDeleted;
+    return units;
+}
+
+int testAllocateBatch() {
+    AppShift::Memory::MemoryPool mp(4096);
+    void* units[1000];
+
+    // Units fitting the current block are placed one after the other
+    mp.allocateBatch(10, 20, units);
+    for (int i = 1; i < 10; i++) CHECK(reinterpret_cast<char*>(units[i]) - reinterpret_cast<char*>(units[i - 1]) == (long) (UNIT_HEADER + 24));
+    CHECK(mp.currentBlock->numberOfAllocated == 10);
+    CHECK(mp.currentBlock->offset == 10 * (UNIT_HEADER + 24));
+
+    // The rest of a batch that doesn't fit gets a block of its own
+    mp.allocateBatch(1000, 20, units);
+    CHECK(liveUnits(mp) == 1010);
+#ifndef MEMORYPOOL_ADDRESS_MASKING
+    CHECK(mp.currentBlock->blockSize >= 1000 * (UNIT_HEADER + 24) - 4096);
+    CHECK(mp.currentBlock->next == nullptr && mp.currentBlock->prev == mp.firstBlock);
+#endif
+
+    // Every unit can be written & freed on its own
+    for (int i = 0; i < 1000; i++) std::memset(units[i], i & 0xFF, 20);
+    for (int i = 0; i < 1000; i++) CHECK(reinterpret_cast<unsigned char*>(units[i])[19] == (i & 0xFF));
+    for (int i = 999; i >= 0; i--) mp.free(units[i]);
+    CHECK(liveUnits(mp) == 10);
+    CHECK(mp.currentBlock == mp.firstBlock);
+
+    // Units bigger than a block
+    mp.allocateBatch(3, 5000, units);
+    CHECK(liveUnits(mp) == 13);
+    for (int i = 0; i < 3; i++) std::memset(units[i], 1, 5000);
+    return 0;
+}
+
+int testFreeBatch() {
+    AppShift::Memory::MemoryPool mp(4096);
+    void* keep = mp.allocate(16);
+    void* units[300];
+    mp.allocateBatch(300, 40, units);
+    size_t blocks = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) blocks++;
+    CHECK(blocks > 1);
+
+    // Every other unit, the blocks stay
+    std::vector<void*> odd, even;
+    for (int i = 0; i < 300; i++) (i % 2 ? odd : even).push_back(units[i]);
+    odd.push_back(nullptr);
+    mp.freeBatch(odd.data(), odd.size());
+    CHECK(liveUnits(mp) == 151);
+
+    // The rest, the blocks left empty are released
+    mp.freeBatch(even.data(), even.size());
+    CHECK(liveUnits(mp) == 1);
+    CHECK(mp.firstBlock == mp.currentBlock);
+
+    // The only block left is emptied
+    void* last = keep;
+    mp.freeBatch(&last, 1);
+    CHECK(mp.currentBlock->offset == 0);
+    CHECK(mp.currentBlock->numberOfAllocated == 0 && mp.currentBlock->numberOfDeleted == 0);
+
+    // Units freed in allocation order empty the block as well
+    mp.allocateBatch(50, 16, units);
+    mp.freeBatch(units, 50);
+    CHECK(mp.currentBlock->offset == 0);
+    return 0;
+}
+
+int testFreeLists() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    mp.enableFreeLists();
+    void* keep = mp.allocate(16);
+    void* units[100];
+    mp.allocateBatch(100, 48, units);
+    void* tail = mp.allocate(16);
+
+    // Deleted units go to the free lists & are reused by the next batch
+    mp.freeBatch(units, 100);
+    CHECK(mp.currentBlock->numberOfDeleted == 100);
+    size_t offset = mp.currentBlock->offset;
+    void* reused[100];
+    mp.allocateBatch(100, 48, reused);
+    CHECK(mp.currentBlock->offset == offset);
+    CHECK(mp.currentBlock->numberOfDeleted == 0);
+
+    mp.freeBatch(reused, 100);
+    mp.free(tail);
+    mp.free(keep);
+    return 0;
+}
+
+int testStatistics() {
+#ifndef MEMORYPOOL_DISABLE_STATS
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    void* units[64];
+    mp.allocateBatch(64, 24, units);
+    AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.allocations == 64);
+    CHECK(stats.sizeHistogram[4] == 64);
+    CHECK(stats.bytesUsed == 64 * (UNIT_HEADER + 24));
+
+    mp.freeBatch(units, 64);
+    stats = mp.getStats();
+    CHECK(stats.frees == 64);
+    CHECK(stats.bytesUsed == 0);
+#endif
+    return 0;
+}
+
+int main() {
+    if (testAllocateBatch() != 0) return 1;
+    if (testFreeBatch() != 0) return 1;
+    if (testFreeLists() != 0) return 1;
+    if (testStatistics() != 0) return 1;
+
+    std::cout << "Batch allocation tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define UNIT_HEADER sizeof(AppShift::Memory::SMemoryUnitHeader)
+
+size_t blockCount(AppShift::Memory::MemoryPool& mp) {
+    size_t blocks = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) blocks++;
+    return blocks;
+}
+
+// Check the chain links & that every block but the current one is indexed in the bin of its tail space
+int checkIndex(AppShift::Memory::MemoryPool& mp) {
+    size_t indexed = 0;
+    AppShift::Memory::SMemoryBlockHeader* prev = nullptr;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) {
+        CHECK(block->prev == prev);
+        if (block == mp.currentBlock) {
+            CHECK(block->spaceBin == SIZE_MAX);
+        }
+        else {
+            CHECK(block->spaceBin != SIZE_MAX);
+            size_t space = block->blockSize - block->offset;
+            CHECK((space >> block->spaceBin) == 1 || (space == 0 && block->spaceBin == 0) || block->spaceBin == MEMORYPOOL_SPACE_BINS - 1);
+        }
+        prev = block;
+    }
+    CHECK(prev == mp.currentBlock);
+
+    for (size_t bin = 0; bin < MEMORYPOOL_SPACE_BINS; bin++) {
+        for (AppShift::Memory::SMemoryBlockHeader* block = mp.spaceBins[bin]; block != nullptr; block = block->nextSpaceBlock) {
+            CHECK(block->spaceBin == bin);
+            indexed++;
+        }
+    }
+    CHECK(indexed == blockCount(mp) - 1);
+    return 0;
+}
+
+int testOlderBlocks() {
+    AppShift::Memory::MemoryPool mp(4096);
+
+    // A big unit leaves most of the first block unused
+    mp.allocate(1000);
+    AppShift::Memory::SMemoryBlockHeader* first = mp.currentBlock;
+    mp.allocate(3800);
+    CHECK(blockCount(mp) == 2);
+    CHECK(checkIndex(mp) == 0);
+
+    // Units that don't fit the current block go to the first one instead of a new block
+    for (int i = 0; i < 20; i++) mp.allocate(100);
+    CHECK(blockCount(mp) == 2);
+    CHECK(mp.currentBlock == first);
+    CHECK(mp.firstBlock != first);
+    CHECK(checkIndex(mp) == 0);
+    return 0;
+}
+
+int testTailSpace() {
+    AppShift::Memory::MemoryPool mp(4096);
+    void* head = mp.allocate(2000);
+    void* tail = mp.allocate(1500);
+    void* next = mp.allocate(3000);
+    CHECK(blockCount(mp) == 2);
+
+    // Space given back at the end of an older block is found again
+    mp.free(tail);
+    CHECK(checkIndex(mp) == 0);
+    mp.allocate(1500);
+    CHECK(blockCount(mp) == 2);
+    CHECK(mp.currentBlock->offset == 2000 + 1504 + 2 * UNIT_HEADER);
+    CHECK(checkIndex(mp) == 0);
+
+    // Blocks left with no live units are still released
+    mp.free(next);
+    CHECK(blockCount(mp) == 1);
+    CHECK(checkIndex(mp) == 0);
+    mp.free(head);
+    CHECK(checkIndex(mp) == 0);
+    return 0;
+}
+
+int testReallocateInOlderBlock() {
+    AppShift::Memory::MemoryPool mp(4096);
+    void* unit = mp.allocate(1000);
+    AppShift::Memory::SMemoryBlockHeader* first = mp.currentBlock;
+    mp.allocate(3500);
+
+    // The last unit of an older block growing in place takes the space it was indexed with
+    CHECK(mp.reallocate(unit, 3000) == unit);
+    CHECK(checkIndex(mp) == 0);
+    void* other = mp.allocate(2000);
+    CHECK(blockCount(mp) == 3);
+    CHECK(AppShift::Memory::MemoryPool::getContainer(reinterpret_cast<AppShift::Memory::SMemoryUnitHeader*>(other) - 1) != first);
+    CHECK(checkIndex(mp) == 0);
+
+    // Shrinking it gives the space back to the index
+    CHECK(mp.tryExpand(unit, 500));
+    CHECK(checkIndex(mp) == 0);
+    mp.allocate(2500);
+    CHECK(mp.currentBlock == first);
+    CHECK(first->offset <= first->blockSize);
+    CHECK(checkIndex(mp) == 0);
+    return 0;
+}
+
+int testScopes() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.allocate(1000);
+    mp.allocate(3500);
+
+    // Blocks are not moved while a scope is open
+    mp.startScope();
+    mp.allocate(1000);
+    CHECK(blockCount(mp) == 3);
+    mp.allocate(3500);
+    mp.allocate(1000);
+    CHECK(blockCount(mp) == 5);
+    CHECK(checkIndex(mp) == 0);
+    mp.endScope();
+    CHECK(blockCount(mp) == 2);
+    CHECK(checkIndex(mp) == 0);
+
+    mp.allocate(1000);
+    CHECK(blockCount(mp) == 2);
+    CHECK(checkIndex(mp) == 0);
+    return 0;
+}
+
+int testMixedSizes() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    std::mt19937 random(11);
+    std::vector<void*> live;
+
+    // Random sizes & frees keep the index consistent with the blocks
+    for (int i = 0; i < 200000; i++) {
+        if (live.size() < 100 || random() % 3 != 0) {
+            size_t size = random() % 10 == 0 ? 4096 + random() % 60000 : 16 + random() % 512;
+            live.push_back(random() % 8 == 0 ? mp.allocateAligned(size, 64) : mp.allocate(size));
+        }
+        else {
+            size_t index = random() % live.size();
+            mp.free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        if (live.size() > 2000) {
+            while (live.size() > 100) {
+                mp.free(live.back());
+                live.pop_back();
+            }
+        }
+        if (i % 10000 == 0) {
+            mp.compressGarbage();
+            if (checkIndex(mp) != 0) return 1;
+        }
+    }
+    CHECK(checkIndex(mp) == 0);
+    for (void* unit : live) mp.free(unit);
+    CHECK(checkIndex(mp) == 0);
+    return 0;
+}
+
+int main() {
+    if (testOlderBlocks() != 0) return 1;
+    if (testTailSpace() != 0) return 1;
+    if (testReallocateInOlderBlock() != 0) return 1;
+    if (testScopes() != 0) return 1;
+    if (testMixedSizes() != 0) return 1;
+
+    std::cout << "Block reuse tests passed" << std::endl;
+    return 0;
+}
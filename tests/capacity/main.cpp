@@ -0,0 +1,193 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <cstring>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define UNIT_HEADER sizeof(AppShift::Memory::SMemoryUnitHeader)
+
+// Bytes used by live units, counted by going over the units
+size_t liveBytes(AppShift::Memory::SMemoryBlockHeader* block) {
+    size_t bytes = 0;
+    for (size_t offset = 0; offset < block->offset;) {
+        AppShift::Memory::SMemoryUnitHeader* unit = reinterpret_cast<AppShift::Memory::SMemoryUnitHeader*>(reinterpret_cast<char*>(block + 1) + offset);
+        size_t length = unit->length & MEMORYPOOL_UNIT_LENGTH_MASK;
+        if (!(unit->length & MEMORYPOOL_UNIT_DELETED)) bytes += UNIT_HEADER + length;
+        offset += UNIT_HEADER + length;
+    }
+    return bytes;
+}
+
+int testCapacity() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    char* buffer = reinterpret_cast<char*>(mp.allocateWithCapacity(16, 256));
+    void* after = mp.allocate(32);
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(buffer) == 256);
+    std::memset(buffer, 'a', 16);
+
+    // Growth within the capacity never moves, even when the unit is not the last
+    for (size_t size = 32; size <= 256; size += 16) {
+        char* grown = reinterpret_cast<char*>(mp.reallocate(buffer, size));
+        CHECK(grown == buffer);
+    }
+    CHECK(buffer[15] == 'a');
+
+    // Beyond the capacity the unit moves
+    char* moved = reinterpret_cast<char*>(mp.reallocate(buffer, 512));
+    CHECK(moved != buffer);
+    CHECK(moved[0] == 'a' && moved[15] == 'a');
+    mp.free(moved);
+    mp.free(after);
+    return 0;
+}
+
+int testCapacityKept() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    mp.enableFreeLists();
+    void* buffer = mp.allocateWithCapacity(16, 256);
+    void* last = mp.allocateWithCapacity(16, 256);
+
+    // Re-allocations below the capacity keep it, so other allocations don't take it
+    CHECK(mp.reallocate(buffer, 32) == buffer);
+    CHECK(mp.reallocate(last, 32) == last);
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(buffer) == 256);
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(last) == 256);
+    char* other = reinterpret_cast<char*>(mp.allocate(200));
+    CHECK(other > reinterpret_cast<char*>(last) + 256);
+    CHECK(mp.reallocate(buffer, 200) == buffer);
+    CHECK(mp.reallocate(last, 256) == last);
+    return 0;
+}
+
+int testShrink() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    void* first = mp.allocate(1024);
+    void* second = mp.allocate(64);
+
+    // Re-allocating to a smaller size keeps the capacity
+    CHECK(mp.reallocate(first, 256) == first);
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(first) == 1024);
+    CHECK(mp.currentBlock->numberOfAllocated == 2);
+
+    // Shrinking gives the space after the new size back as a deleted unit
+    CHECK(mp.tryExpand(first, 256));
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(first) == 256);
+    CHECK(mp.currentBlock->numberOfAllocated == 3);
+    CHECK(mp.currentBlock->numberOfDeleted == 1);
+    CHECK(liveBytes(mp.currentBlock) == 2 * UNIT_HEADER + 256 + 64);
+
+    // Too little space for a unit stays with the unit
+    CHECK(mp.tryExpand(first, 248));
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(first) == 256);
+    CHECK(mp.currentBlock->numberOfAllocated == 3);
+
+    // The last unit gives the space back to the block
+    size_t offset = mp.currentBlock->offset;
+    CHECK(mp.reallocate(second, 16) == second);
+    CHECK(mp.currentBlock->offset == offset);
+    CHECK(mp.tryExpand(second, 16));
+    CHECK(mp.currentBlock->offset == offset - 48);
+
+#ifndef MEMORYPOOL_DISABLE_STATS
+    CHECK(mp.getStats().bytesUsed == liveBytes(mp.currentBlock));
+#endif
+    return 0;
+}
+
+int testTryExpand() {
+    AppShift::Memory::MemoryPool mp(4096);
+    void* first = mp.allocate(64);
+    void* middle = mp.allocate(64);
+    void* last = mp.allocate(64);
+
+    // Blocked by a live unit
+    CHECK(!mp.tryExpand(first, 128));
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(first) == 64);
+
+    // Grows over the deleted unit that follows, the rest is given back
+    mp.free(middle);
+    CHECK(mp.tryExpand(first, 80));
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(first) == 80);
+    CHECK(mp.currentBlock->numberOfAllocated == 3);
+    CHECK(mp.currentBlock->numberOfDeleted == 1);
+    CHECK(mp.tryExpand(first, 64 + UNIT_HEADER + 64));
+    CHECK(mp.currentBlock->numberOfAllocated == 2);
+    CHECK(mp.currentBlock->numberOfDeleted == 0);
+    CHECK(!mp.tryExpand(first, 256));
+
+    // The last unit grows to the end of its block, but never moves to another one
+    CHECK(mp.tryExpand(last, 1024));
+    CHECK(!mp.tryExpand(last, 8192));
+    CHECK(AppShift::Memory::MemoryPool::getCapacity(last) == 1024);
+
+    // Over deleted units up to the end of the block
+    mp.free(last);
+    CHECK(mp.tryExpand(first, 1024));
+    CHECK(mp.currentBlock->numberOfAllocated == 1);
+    CHECK(mp.currentBlock->offset == UNIT_HEADER + 1024);
+
+#ifndef MEMORYPOOL_DISABLE_STATS
+    CHECK(mp.getStats().bytesUsed == liveBytes(mp.currentBlock));
+#endif
+    return 0;
+}
+
+int testFreeListsAndScopes() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    mp.enableFreeLists();
+    void* first = mp.allocate(512);
+    void* second = mp.allocate(64);
+
+    // The space given back is reused by the next allocation of its size class
+    CHECK(mp.tryExpand(first, 128));
+    void* reused = mp.allocate(512 - 128 - UNIT_HEADER);
+    CHECK(reused == reinterpret_cast<char*>(first) + 128 + UNIT_HEADER);
+    mp.free(reused);
+
+    // Growing over the listed unit takes it off its free list
+    CHECK(mp.tryExpand(first, 512));
+    CHECK(mp.allocate(512 - 128 - UNIT_HEADER) != reused);
+
+    // Counters are exact after a scope that split & merged units before it
+    mp.free(second);
+    size_t allocated = mp.currentBlock->numberOfAllocated;
+    size_t deleted = mp.currentBlock->numberOfDeleted;
+    mp.startScope();
+    CHECK(mp.tryExpand(first, 64));
+    mp.allocate(32);
+    mp.endScope();
+    CHECK(mp.currentBlock->numberOfAllocated == allocated + 1);
+    CHECK(mp.currentBlock->numberOfDeleted == deleted + 1);
+    return 0;
+}
+
+int main() {
+    if (testCapacity() != 0) return 1;
+    if (testCapacityKept() != 0) return 1;
+    if (testShrink() != 0) return 1;
+    if (testTryExpand() != 0) return 1;
+    if (testFreeListsAndScopes() != 0) return 1;
+
+    std::cout << "Capacity tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../../InterProcessMemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+// Shared list of the values written by the processes
+struct SSharedNode {
+    size_t next;
+    int process;
+    int value;
+};
+
+struct SSharedList {
+    size_t head;
+};
+
+// Attach to the pool by name, allocate nodes & free some of them
+int childProcess(const char* name, int process, int count) {
+    AppShift::Memory::InterProcessMemoryPool mp(name);
+    SSharedList* list = reinterpret_cast<SSharedList*>(mp.getRoot());
+    if (list == nullptr) return 1;
+
+    for (int i = 0; i < count; i++) {
+        SSharedNode* node = mp.allocate<SSharedNode>(1);
+        node->process = process;
+        node->value = i;
+
+        // Scratch space that is freed right away
+        char* scratch = mp.allocate<char>(100 + i % 50);
+        scratch[0] = (char) i;
+        mp.free(scratch);
+
+        // Push to the shared list, the head is an offset so it means the same in every process
+        size_t node_offset = mp.toOffset(node);
+        size_t head = __atomic_load_n(&list->head, __ATOMIC_ACQUIRE);
+        do node->next = head;
+        while (!__atomic_compare_exchange_n(&list->head, &head, node_offset, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    }
+
+    return 0;
+}
+
+int testInterProcess() {
+    std::string name = "/appshift_memorypool_test_" + std::to_string(getpid());
+    const int process_count = 4;
+    const int node_count = 5000;
+
+    AppShift::Memory::InterProcessMemoryPool::remove(name.c_str());
+    AppShift::Memory::InterProcessMemoryPool mp(name.c_str(), 16 * 1024 * 1024, 4096);
+
+    SSharedList* list = mp.allocate<SSharedList>(1);
+    list->head = 0;
+    mp.setRoot(list);
+
+    // Children attach to the pool by name and map it at their own address
+    pid_t children[process_count];
+    for (int p = 0; p < process_count; p++) {
+        children[p] = fork();
+        if (children[p] == 0) _exit(childProcess(name.c_str(), p, node_count));
+    }
+
+    bool children_passed = true;
+    for (int p = 0; p < process_count; p++) {
+        int status = 0;
+        waitpid(children[p], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) children_passed = false;
+    }
+    CHECK(children_passed);
+
+    // Every node written by every process is reachable through offsets
+    int counts[process_count] = { 0 };
+    long long sums[process_count] = { 0 };
+    for (SSharedNode* node = mp.fromOffset<SSharedNode>(list->head); node != nullptr; node = mp.fromOffset<SSharedNode>(node->next)) {
+        CHECK(node->process >= 0 && node->process < process_count);
+        counts[node->process]++;
+        sums[node->process] += node->value;
+    }
+    for (int p = 0; p < process_count; p++) {
+        CHECK(counts[p] == node_count);
+        CHECK(sums[p] == (long long) node_count * (node_count - 1) / 2);
+    }
+
+    // A second mapping sees the same data at a different address
+    {
+        AppShift::Memory::InterProcessMemoryPool attached(name.c_str());
+        SSharedList* attached_list = reinterpret_cast<SSharedList*>(attached.getRoot());
+        CHECK(attached_list != list);
+        CHECK(attached_list->head == list->head);
+    }
+
+    // Freeing everything gives the blocks back to the segment
+    SSharedNode* node = mp.fromOffset<SSharedNode>(list->head);
+    while (node != nullptr) {
+        SSharedNode* next = mp.fromOffset<SSharedNode>(node->next);
+        mp.free(node);
+        node = next;
+    }
+    list->head = 0;
+
+    char* big = mp.allocate<char>(64 * 1024);
+    CHECK(big != nullptr);
+    big = mp.reallocate<char>(big, 128 * 1024);
+    big[128 * 1024 - 1] = 1;
+    mp.free(big);
+
+    AppShift::Memory::InterProcessMemoryPool::remove(name.c_str());
+    return 0;
+}
+
+int testInvalidSegments() {
+    std::string name = "/appshift_memorypool_invalid_" + std::to_string(getpid());
+
+    // Attaching to a missing segment fails
+    bool thrown = false;
+    try { AppShift::Memory::InterProcessMemoryPool mp(name.c_str()); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::CANNOT_MAP_SHARED_MEMORY; }
+    CHECK(thrown);
+
+    // Running out of the segment fails without breaking the pool
+    AppShift::Memory::InterProcessMemoryPool mp(name.c_str(), 64 * 1024, 4096);
+    thrown = false;
+    try { mp.allocate(128 * 1024); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::OUT_OF_POOL; }
+    CHECK(thrown);
+    CHECK(mp.allocate(1024) != nullptr);
+
+    // Creating the same segment twice fails
+    thrown = false;
+    try { AppShift::Memory::InterProcessMemoryPool other(name.c_str(), 64 * 1024, 4096); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::CANNOT_MAP_SHARED_MEMORY; }
+    CHECK(thrown);
+
+    AppShift::Memory::InterProcessMemoryPool::remove(name.c_str());
+    return 0;
+}
+
+int main() {
+    if (testInterProcess() != 0) return 1;
+    if (testInvalidSegments() != 0) return 1;
+
+    std::cout << "Inter process tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include "../../ObjectPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+// Objects alive, to check the constructors & destructors called
+int liveNodes = 0;
+
+struct Node {
+    Node* left;
+    Node* right;
+    int key;
+
+    Node(int key) : left(nullptr), right(nullptr), key(key) { liveNodes++; }
+    ~Node() { liveNodes--; }
+};
+
+struct alignas(64) Level {
+    double price;
+    size_t quantity;
+};
+
+struct Triple {
+    char bytes[3];
+};
+
+int testSlots() {
+    AppShift::Memory::MemoryPool mp;
+
+    // Slots smaller than a cache line are packed to a power of 2, the others keep their size
+    CHECK((AppShift::Memory::ObjectPool<Node>::getSlotSize() == 32));
+    CHECK((AppShift::Memory::ObjectPool<Node, false>::getSlotSize() == 24));
+    CHECK((AppShift::Memory::ObjectPool<Triple>::getSlotSize() == sizeof(void*)));
+    CHECK((AppShift::Memory::ObjectPool<Level>::getSlotSize() == 64));
+
+    // Slots have no header & no packed slot is split between cache lines
+    AppShift::Memory::ObjectPool<Node> nodes(&mp, 4096);
+    Node* previous = nodes.create(0);
+    for (int i = 1; i < 1000; i++) {
+        Node* node = nodes.create(i);
+        if (i % nodes.getSlotsPerSlab() != 0) CHECK(reinterpret_cast<char*>(node) - reinterpret_cast<char*>(previous) == 32);
+        CHECK(reinterpret_cast<uintptr_t>(node) % 64 + 32 <= 64);
+        previous = node;
+    }
+    CHECK(liveNodes == 1000);
+    CHECK(nodes.getLiveObjects() == 1000);
+
+    AppShift::Memory::ObjectPool<Level> levels(&mp);
+    for (int i = 0; i < 100; i++) CHECK(reinterpret_cast<uintptr_t>(levels.allocate()) % 64 == 0);
+    return 0;
+}
+
+int testAnyOrder() {
+    AppShift::Memory::MemoryPool mp;
+    AppShift::Memory::ObjectPool<Node> nodes(&mp, 4096);
+    std::mt19937 random(7);
+    std::vector<Node*> live;
+    std::set<Node*> addresses;
+    liveNodes = 0;
+
+    // Slots are reused in any order, so the slabs stop growing
+    for (int i = 0; i < 100000; i++) {
+        if (live.size() < 500 || random() % 2) live.push_back(nodes.create(i));
+        else {
+            size_t index = random() % live.size();
+            nodes.destroy(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    for (Node* node : live) addresses.insert(node);
+    CHECK(addresses.size() == live.size());
+    CHECK(liveNodes == (int) live.size());
+    CHECK(nodes.getLiveObjects() == live.size());
+
+    size_t slabs = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) slabs += block->numberOfAllocated - block->numberOfDeleted;
+    CHECK(slabs <= (live.size() * 2) / nodes.getSlotsPerSlab() + 2);
+
+    for (Node* node : live) nodes.destroy(node);
+    CHECK(liveNodes == 0);
+    return 0;
+}
+
+int testResetAndRelease() {
+    AppShift::Memory::MemoryPool mp;
+    AppShift::Memory::ObjectPool<Node> nodes(&mp, 4096);
+    std::vector<Node*> first;
+    for (int i = 0; i < 1000; i++) first.push_back(nodes.allocate());
+    size_t used = mp.currentBlock->offset;
+
+    // The slots are taken again from the first slab, without new slabs
+    nodes.reset();
+    CHECK(nodes.getLiveObjects() == 0);
+    for (int i = 0; i < 1000; i++) CHECK(nodes.allocate() == first[i]);
+    CHECK(mp.currentBlock->offset == used);
+
+    // The slabs are given back to the memory pool
+    nodes.release();
+    CHECK(mp.currentBlock->numberOfAllocated == mp.currentBlock->numberOfDeleted);
+    CHECK(nodes.allocate() != nullptr);
+    return 0;
+}
+
+int main() {
+    if (testSlots() != 0) return 1;
+    if (testAnyOrder() != 0) return 1;
+    if (testResetAndRelease() != 0) return 1;
+
+    std::cout << "Object pool tests passed" << std::endl;
+    return 0;
+}
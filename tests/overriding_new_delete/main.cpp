@@ -19,10 +19,136 @@
  */
 
 #include <iostream>
-#include "../../MemoryPool.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <list>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include "../../GlobalNewDelete.h"
 
-AppShift::Memory::MemoryPool testPool (256 * 1024);
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+#define IS_ALIGNED(pointer, alignment) (reinterpret_cast<uintptr_t>(pointer) % (alignment) == 0)
+
+struct alignas(64) CacheLineCounter {
+    long long value;
+};
+
+struct alignas(4096) PageBuffer {
+    char data[4096];
+};
+
+int testAllOverloads() {
+    // Plain, array & nothrow overloads allocate in the pool
+    int* number = new int(7);
+    CHECK(AppShift::Memory::isGlobalMemoryPoolPointer(number));
+    CHECK(IS_ALIGNED(number, __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+    delete number;
+
+    long long* numbers = new long long[100];
+    CHECK(AppShift::Memory::isGlobalMemoryPoolPointer(numbers));
+    delete[] numbers;
+
+    int* nothrow_number = new (std::nothrow) int(3);
+    CHECK(AppShift::Memory::isGlobalMemoryPoolPointer(nothrow_number));
+    delete nothrow_number;
+
+    // Zero sized allocations are unique
+    char* empty = new char[0];
+    char* other_empty = new char[0];
+    CHECK(empty != nullptr && empty != other_empty);
+    delete[] empty;
+    delete[] other_empty;
+
+    // Aligned overloads keep the alignment
+    CacheLineCounter* counter = new CacheLineCounter{ 1 };
+    CHECK(IS_ALIGNED(counter, 64));
+    CHECK(AppShift::Memory::isGlobalMemoryPoolPointer(counter));
+    delete counter;
+
+    CacheLineCounter* counters = new CacheLineCounter[9];
+    CHECK(IS_ALIGNED(counters, 64));
+    delete[] counters;
+
+    PageBuffer* page = new PageBuffer;
+    CHECK(IS_ALIGNED(page, 4096));
+    delete page;
+
+    // Big allocations go to malloc, and are still deleted correctly
+    char* big = new char[MEMORYPOOL_GLOBAL_MAX_SIZE + 1];
+    CHECK(!AppShift::Memory::isGlobalMemoryPoolPointer(big));
+    big[MEMORYPOOL_GLOBAL_MAX_SIZE] = 1;
+    delete[] big;
+
+    // Foreign memory is not mistaken for pool memory
+    void* foreign = std::malloc(64);
+    CHECK(!AppShift::Memory::isGlobalMemoryPoolPointer(foreign));
+    std::free(foreign);
+
+    return 0;
+}
+
+int testContainers() {
+    std::map<std::string, std::vector<int>> index;
+    for (int i = 0; i < 20000; i++) {
+        std::vector<int>& values = index["a key long enough to be allocated " + std::to_string(i % 1000)];
+        values.push_back(i);
+    }
+    CHECK(index.size() == 1000);
+    CHECK(index["a key long enough to be allocated 7"].size() == 20);
+    CHECK(AppShift::Memory::isGlobalMemoryPoolPointer(index.begin()->second.data()));
+
+    std::list<std::unique_ptr<std::string>> strings;
+    for (int i = 0; i < 10000; i++) strings.push_back(std::make_unique<std::string>(100, (char) ('a' + i % 26)));
+    for (auto it = strings.begin(); it != strings.end();) it = (*it)->front() == 'a' ? strings.erase(it) : std::next(it);
+    CHECK(strings.size() == 10000 - 385);
+
+    return 0;
+}
+
+int testThreads() {
+    // Objects are created in one thread & deleted in another, including after their thread exited
+    std::vector<std::string*> handed;
+    std::atomic<bool> failed(false);
+
+    std::thread producer([&handed]() {
+        for (int i = 0; i < 10000; i++) handed.push_back(new std::string(50, 'x'));
+    });
+    producer.join();
+
+    std::vector<std::thread> consumers;
+    for (int t = 0; t < 4; t++) {
+        consumers.emplace_back([&handed, &failed, t]() {
+            for (size_t i = t; i < handed.size(); i += 4) {
+                if (*handed[i] != std::string(50, 'x')) failed = true;
+                delete handed[i];
+                std::vector<int> scratch(i % 100 + 1, t);
+                if (scratch.back() != t) failed = true;
+            }
+        });
+    }
+    for (std::thread& consumer : consumers) consumer.join();
+    CHECK(!failed);
+
+    // Many short lived threads reuse the shards
+    for (int round = 0; round < 50; round++) {
+        std::thread worker([&failed]() {
+            std::vector<std::string> words(100, std::string(40, 'w'));
+            if (!AppShift::Memory::isGlobalMemoryPoolPointer(words.data())) failed = true;
+        });
+        worker.join();
+    }
+    CHECK(!failed);
+
+    return 0;
+}
 
 int main() {
+    if (testAllOverloads() != 0) return 1;
+    if (testContainers() != 0) return 1;
+    if (testThreads() != 0) return 1;
+
+    std::cout << "Overriding new & delete tests passed" << std::endl;
     return 0;
 }
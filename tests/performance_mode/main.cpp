@@ -19,10 +19,139 @@
  */
 
 #include <iostream>
-#include "../../MemoryPool.h"
+#include <vector>
+#include <thread>
+#include "../../BasicMemoryPool.h"
+#include "../../MMapBlockProvider.h"
 
-AppShift::Memory::MemoryPool testPool (256 * 1024);
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+#define IS_ALIGNED(pointer, alignment) (reinterpret_cast<uintptr_t>(pointer) % (alignment) == 0)
+
+struct alignas(64) CacheLineCounter {
+    long long value;
+};
+
+int testPerformanceMode() {
+    AppShift::Memory::PerformanceMemoryPool mp(4096);
+    static_assert(!AppShift::Memory::PerformanceMemoryPool::hasUnitHeaders, "Performance mode has no unit headers");
+
+    // Allocations are a pointer bump, units are next to each other
+    char* first = mp.allocate<char>(24);
+    char* second = mp.allocate<char>(24);
+    CHECK(second - first == 24);
+
+    // Over-aligned allocations skip the padding
+    CacheLineCounter* counter = mp.allocate<CacheLineCounter>(1);
+    CHECK(IS_ALIGNED(counter, 64));
+
+    // Blocks are chained when full, & big allocations get a block of their own
+    std::vector<long long*> values;
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(mp.allocate<long long>(1));
+        *values.back() = i;
+    }
+    char* big = mp.allocate<char>(100000);
+    big[99999] = 1;
+    for (int i = 0; i < 10000; i++) CHECK(*values[i] == i);
+
+    // Reset frees everything at once
+    mp.reset();
+    CHECK(mp.currentBlock == mp.firstBlock);
+    CHECK(mp.allocate<char>(24) == first);
+
+    return 0;
+}
+
+int testStandardMode() {
+    AppShift::Memory::StandardMemoryPool mp(4096);
+
+    // The last unit gives its space back
+    char* first = mp.allocate<char>(100);
+    char* second = mp.allocate<char>(100);
+    mp.free(second);
+    CHECK(mp.allocate<char>(100) == second);
+
+    // Re-allocating the last unit grows in place, other units are moved
+    char* grown = mp.reallocate<char>(second, 200);
+    CHECK(grown == second);
+    std::memset(first, 7, 100);
+    char* moved = reinterpret_cast<char*>(mp.reallocate(first, 300));
+    CHECK(moved != first && moved[99] == 7);
+
+    // Blocks left with deleted units only are released
+    std::vector<char*> units;
+    for (int i = 0; i < 1000; i++) units.push_back(mp.allocate<char>(64));
+    for (char* unit : units) mp.free(unit);
+    size_t blocks = 0;
+    for (AppShift::Memory::SMemoryBlockHeader* block = mp.firstBlock; block != nullptr; block = block->next) blocks++;
+    CHECK(blocks <= 2);
+
+    // Scopes roll back the allocations & their counters
+    mp.startScope();
+    for (int i = 0; i < 1000; i++) {
+        char* unit = mp.allocate<char>(50);
+        if (i % 3 == 0) mp.free(unit);
+    }
+    mp.endScope();
+    CHECK(mp.currentBlock->numberOfAllocated >= mp.currentBlock->numberOfDeleted);
+
+    // Aligned allocations can be freed
+    CacheLineCounter* counter = mp.allocate<CacheLineCounter>(3);
+    CHECK(IS_ALIGNED(counter, 64));
+    mp.free(counter);
+
+    return 0;
+}
+
+int testStatisticsAndProvider() {
+    using StatsPool = AppShift::Memory::BasicMemoryPool<
+        AppShift::Memory::Policies::Statistics<true>,
+        AppShift::Memory::Policies::BlockProvider<AppShift::Memory::MMapBlockProvider>>;
+    StatsPool mp(4096);
+
+    for (int i = 0; i < 100; i++) mp.free(mp.allocate<char>(100));
+    for (int i = 0; i < 100; i++) mp.allocate<char>(100);
+
+    AppShift::Memory::SBasicMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.allocations == 200);
+    CHECK(stats.frees == 100);
+    CHECK(stats.bytesAllocated == 200 * 104);
+    CHECK(stats.blocksCreated >= 3);
+
+    return 0;
+}
+
+int testThreadSafety() {
+    using SharedPool = AppShift::Memory::BasicMemoryPool<AppShift::Memory::Policies::ThreadSafety<true>, AppShift::Memory::Policies::Scopes<false>>;
+    SharedPool mp(64 * 1024);
+    bool failed[4] = { false };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&mp, &failed, t]() {
+            std::vector<int*> values;
+            for (int i = 0; i < 20000; i++) {
+                values.push_back(mp.allocate<int>(1));
+                *values.back() = t * 100000 + i;
+            }
+            for (int i = 0; i < 20000; i++) {
+                if (*values[i] != t * 100000 + i) failed[t] = true;
+                mp.free(values[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (int t = 0; t < 4; t++) CHECK(!failed[t]);
+
+    return 0;
+}
 
 int main() {
+    if (testPerformanceMode() != 0) return 1;
+    if (testStandardMode() != 0) return 1;
+    if (testStatisticsAndProvider() != 0) return 1;
+    if (testThreadSafety() != 0) return 1;
+
+    std::cout << "Performance mode tests passed" << std::endl;
     return 0;
 }
@@ -0,0 +1,179 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include "../../MemoryPool.h"
+#include "../../MMapBlockProvider.h"
+#include "../../MemoryPoolImage.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define IMAGE_PATH "pool_image_test.img"
+#define NODES 20000
+
+struct Node {
+    Node* next;
+    size_t value;
+    char name[40];
+};
+
+// Build a list of nodes linked by pointers in a pool
+Node* buildList(AppShift::Memory::MemoryPool& mp) {
+    Node* head = nullptr;
+    for (size_t i = 0; i < NODES; i++) {
+        Node* node = mp.allocate<Node>(1);
+        node->next = head;
+        node->value = i;
+        std::snprintf(node->name, sizeof(node->name), "node %zu", i);
+        head = node;
+
+        // Some garbage between the nodes
+        if (i % 7 == 0) mp.free(mp.allocate<char>(24));
+    }
+    return head;
+}
+
+// Walk a mapped list, translating the pointers when the image is relocated
+int checkList(const AppShift::Memory::MemoryPoolImage& image) {
+    const Node* node = reinterpret_cast<const Node*>(image.getRoot());
+    for (size_t i = NODES; i-- > 0;) {
+        CHECK(node != nullptr);
+        CHECK(node->value == i);
+        char name[40];
+        std::snprintf(name, sizeof(name), "node %zu", i);
+        CHECK(std::strcmp(node->name, name) == 0);
+        node = image.isRelocated() ? image.translate(node->next) : node->next;
+    }
+    CHECK(node == nullptr);
+    return 0;
+}
+
+int testRelocated() {
+    // Small blocks next to each other in the heap share pages, unless they are aligned for masking
+    AppShift::Memory::MemoryPool mp(4096);
+    Node* head = buildList(mp);
+    AppShift::Memory::MemoryPoolImage::save(mp, IMAGE_PATH, head);
+
+    // The saved addresses are still used by the pool
+    AppShift::Memory::MemoryPoolImage image(IMAGE_PATH);
+    CHECK(image.isRelocated());
+#ifndef MEMORYPOOL_ADDRESS_MASKING
+    CHECK(image.segments.size() < mp.getStats().blockCount);
+#endif
+    CHECK(checkList(image) == 0);
+    CHECK(image.translate(head) != head);
+    CHECK(image.translate(reinterpret_cast<void*>(1)) == nullptr);
+    return 0;
+}
+
+int testFixedBase() {
+    AppShift::Memory::MMapBlockProvider provider;
+    {
+        AppShift::Memory::MemoryPool mp(256 * 1024, &provider);
+        AppShift::Memory::MemoryPoolImage::save(mp, IMAGE_PATH, buildList(mp));
+    }
+
+    // The pool is gone, so the image takes its addresses back & the pointers are valid as they are
+    AppShift::Memory::MemoryPoolImage image(IMAGE_PATH);
+#ifdef MAP_FIXED_NOREPLACE
+    CHECK(!image.isRelocated());
+#endif
+    CHECK(checkList(image) == 0);
+    return 0;
+}
+
+int testCopyOnWrite() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    AppShift::Memory::MemoryPoolImage::save(mp, IMAGE_PATH, buildList(mp));
+
+    // Changes to a writable image stay in the process
+    {
+        AppShift::Memory::MemoryPoolImage image(IMAGE_PATH, true);
+        Node* root = reinterpret_cast<Node*>(image.getRoot());
+        root->value = 12345;
+        CHECK(reinterpret_cast<Node*>(image.getRoot())->value == 12345);
+    }
+    AppShift::Memory::MemoryPoolImage image(IMAGE_PATH);
+    CHECK(checkList(image) == 0);
+    return 0;
+}
+
+int testInvalidImages() {
+    bool thrown = false;
+    try { AppShift::Memory::MemoryPoolImage image("missing_pool_image.img"); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::CANNOT_MAP_POOL_IMAGE; }
+    CHECK(thrown);
+
+    // Files that are not complete images are rejected
+    FILE* file = std::fopen(IMAGE_PATH, "wb");
+    std::fputs("not a pool image", file);
+    std::fclose(file);
+    thrown = false;
+    try { AppShift::Memory::MemoryPoolImage image(IMAGE_PATH); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::INVALID_POOL_IMAGE; }
+    CHECK(thrown);
+
+    // Images whose segments table or segments don't fit the file are rejected
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    AppShift::Memory::MemoryPoolImage::save(mp, IMAGE_PATH, buildList(mp));
+    file = std::fopen(IMAGE_PATH, "rb");
+    std::fseek(file, 0, SEEK_END);
+    std::vector<char> contents(static_cast<size_t>(std::ftell(file)));
+    std::fseek(file, 0, SEEK_SET);
+    CHECK(std::fread(contents.data(), 1, contents.size(), file) == contents.size());
+    std::fclose(file);
+
+    std::vector<char> corrupted = contents;
+    size_t segment_count = static_cast<size_t>(-1) / 2;
+    std::memcpy(corrupted.data() + offsetof(AppShift::Memory::SMemoryPoolImageHeader, segmentCount), &segment_count, sizeof(segment_count));
+    file = std::fopen(IMAGE_PATH, "wb");
+    std::fwrite(corrupted.data(), 1, corrupted.size(), file);
+    std::fclose(file);
+    thrown = false;
+    try { AppShift::Memory::MemoryPoolImage image(IMAGE_PATH); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::INVALID_POOL_IMAGE; }
+    CHECK(thrown);
+
+    // A truncated image loses the end of its last segment
+    file = std::fopen(IMAGE_PATH, "wb");
+    std::fwrite(contents.data(), 1, contents.size() - 1, file);
+    std::fclose(file);
+    thrown = false;
+    try { AppShift::Memory::MemoryPoolImage image(IMAGE_PATH); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::INVALID_POOL_IMAGE; }
+    CHECK(thrown);
+    return 0;
+}
+
+int main() {
+    int result = testRelocated();
+    if (result == 0) result = testFixedBase();
+    if (result == 0) result = testCopyOnWrite();
+    if (result == 0) result = testInvalidImages();
+    std::remove(IMAGE_PATH);
+    if (result != 0) return 1;
+
+    std::cout << "Pool image tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../../PoolString.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+using AppShift::Memory::PoolString;
+
+int testLocalStrings() {
+    AppShift::Memory::MemoryPool mp;
+    size_t allocations = mp.getStats().allocations;
+
+    // Short strings are stored in the object
+    PoolString empty(&mp);
+    PoolString str(&mp, "short string");
+    CHECK(empty.empty() && empty.isLocal() && *empty.c_str() == '\0');
+    CHECK(str.isLocal() && str == "short string" && str.size() == 12);
+    str += "abc";
+    CHECK(str.isLocal() && str.size() == MEMORYPOOL_STRING_LOCAL_CAPACITY);
+    CHECK(mp.getStats().allocations == allocations);
+
+    // One more character moves it to the pool
+    str += 'd';
+    CHECK(!str.isLocal() && str == "short stringabcd");
+    CHECK(mp.getStats().allocations == allocations + 1);
+    return 0;
+}
+
+int testGrowth() {
+    AppShift::Memory::MemoryPool mp;
+    PoolString str(&mp);
+    std::string expected;
+
+    // The last unit of the block grows in place
+    str.reserve(64);
+    const char* start = str.data();
+    for (int i = 0; i < 10000; i++) {
+        str += "0123456789";
+        str.push_back((char) ('a' + i % 26));
+        expected += "0123456789";
+        expected.push_back((char) ('a' + i % 26));
+    }
+    CHECK(str.data() == start);
+    CHECK(str == expected && std::strlen(str.c_str()) == expected.size());
+    CHECK(str.capacity() >= str.size());
+
+    // A unit followed by another one moves, with room for the next appends
+    PoolString blocked(&mp, "a string that is long enough");
+    PoolString other(&mp, "another string that is long enough");
+    start = blocked.data();
+    blocked += " to move";
+    CHECK(blocked.data() != start && blocked == "a string that is long enough to move");
+    CHECK(blocked.capacity() >= 2 * 28);
+
+    // Appending a part of itself
+    blocked.append(blocked.view().substr(0, 8));
+    CHECK(blocked == "a string that is long enough to movea string");
+    blocked.append(blocked);
+    CHECK(blocked == "a string that is long enough to movea stringa string that is long enough to movea string");
+    PoolString local(&mp, "abcdefgh");
+    local.append(local);
+    CHECK(local == "abcdefghabcdefgh");
+
+    // Shrinking gives back the space
+    blocked.resize(10);
+    CHECK(blocked == "a string t");
+    blocked.shrink_to_fit();
+    CHECK(blocked.isLocal() && blocked == "a string t");
+    str.resize(100);
+    str.shrink_to_fit();
+    CHECK(str.capacity() < 128 && str.size() == 100);
+    str.resize(104, 'y');
+    CHECK(str.view().substr(98) == expected.substr(98, 2) + "yyyy");
+    return 0;
+}
+
+int testMoves() {
+    AppShift::Memory::MemoryPool mp;
+    AppShift::Memory::MemoryPool other_mp;
+
+    PoolString local(&mp, "local");
+    PoolString moved_local(std::move(local));
+    CHECK(moved_local == "local" && moved_local.isLocal() && local.empty());
+
+    // Moving takes the characters without allocating
+    PoolString str(&mp, "a string long enough to be in the pool");
+    const char* start = str.data();
+    PoolString assigned(&mp, "another string in the pool, to be freed");
+    size_t allocations = mp.getStats().allocations;
+    PoolString moved(std::move(str));
+    CHECK(moved.data() == start && str.empty() && str.isLocal());
+    assigned = std::move(moved);
+    CHECK(assigned.data() == start && moved.empty());
+    CHECK(mp.getStats().allocations == allocations);
+
+    // Characters stay in the pool of the destination
+    PoolString in_other(&other_mp);
+    in_other = std::move(assigned);
+    CHECK(in_other == "a string long enough to be in the pool" && in_other.getPool() == &other_mp);
+    CHECK(in_other.data() != start);
+
+    // Strings in containers are moved when the container grows
+    std::vector<PoolString> strings;
+    for (int i = 0; i < 1000; i++) strings.emplace_back(&mp, std::string(i % 40, 'a' + i % 26));
+    for (int i = 0; i < 1000; i++) CHECK(strings[i] == std::string(i % 40, 'a' + i % 26));
+    return 0;
+}
+
+int testCopies() {
+    AppShift::Memory::MemoryPool mp;
+    AppShift::Memory::MemoryPool other_mp;
+
+    PoolString str(&mp, "a string long enough to be in the pool");
+    PoolString copy(str);
+    CHECK(copy == str && copy.data() != str.data() && copy.getPool() == &mp);
+    PoolString other_copy(str, &other_mp);
+    CHECK(other_copy == str && other_copy.getPool() == &other_mp);
+
+    // Assignments reuse the capacity
+    PoolString target(&other_mp, "a longer string that already is in the other pool");
+    const char* start = target.data();
+    target = str;
+    CHECK(target == str && target.data() == start && target.getPool() == &other_mp);
+    target = std::string_view("short");
+    CHECK(target == "short" && target.data() == start);
+    target = target.view().substr(1, 3);
+    CHECK(target == "hor");
+    target = target;
+    CHECK(target == "hor");
+    return 0;
+}
+
+int testViews() {
+    AppShift::Memory::MemoryPool mp;
+    PoolString str(&mp, "key=value;other=thing");
+
+    // Interoperates with the string_view API
+    std::string_view view = str;
+    CHECK(view == "key=value;other=thing");
+    CHECK(str.find('=') == 3 && str.find("other") == 10 && str.find("none") == PoolString::npos);
+    PoolString value = str.substr(4, 5);
+    CHECK(value == "value" && value.getPool() == &mp);
+    CHECK("value" == value && value != "thing" && PoolString(&mp, "a") < PoolString(&mp, "b"));
+
+    std::unordered_set<PoolString> set;
+    set.insert(PoolString(&mp, "first"));
+    set.insert(PoolString(&mp, "a second string in the pool"));
+    CHECK(set.count(PoolString(&mp, "first")) == 1 && set.count(PoolString(&mp, "third")) == 0);
+
+    str.clear();
+    CHECK(str.empty() && str.view() == "" && str.capacity() >= 21);
+    return 0;
+}
+
+int main() {
+    if (testLocalStrings() != 0) return 1;
+    if (testGrowth() != 0) return 1;
+    if (testMoves() != 0) return 1;
+    if (testCopies() != 0) return 1;
+    if (testViews() != 0) return 1;
+
+    std::cout << "Pool string tests passed" << std::endl;
+    return 0;
+}
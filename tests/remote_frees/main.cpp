@@ -0,0 +1,148 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+int testQueue() {
+    AppShift::Memory::MemoryPool mp(4096);
+    void* first = mp.allocate(100);
+    void* second = mp.allocate(0);
+    void* third = mp.allocate(100);
+
+    // Pushed units stay live until the owner collects them
+    AppShift::Memory::MemoryPool::freeRemote(first);
+    AppShift::Memory::MemoryPool::freeRemote(second);
+    CHECK(mp.remoteFrees.load() == second);
+    CHECK(mp.currentBlock->numberOfDeleted == 0);
+
+    mp.collectRemoteFrees();
+    CHECK(mp.remoteFrees.load() == nullptr);
+    CHECK(mp.currentBlock->numberOfDeleted == 2);
+    mp.free(third);
+    CHECK(mp.getStats().liveUnits == 0);
+    return 0;
+}
+
+int testCollectOnAllocate() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.setBlockRetention(0);
+    std::vector<void*> units;
+    while (mp.firstBlock == mp.currentBlock) units.push_back(mp.allocate(200));
+
+    // The allocation that needs a new block frees the pushed units first, which releases the full block
+    AppShift::Memory::SMemoryBlockHeader* full = mp.firstBlock;
+    for (size_t i = 0; i + 1 < units.size(); i++) AppShift::Memory::MemoryPool::freeRemote(units[i]);
+    while (mp.fitsCurrentBlock(200)) mp.allocate(200);
+    mp.allocate(200);
+    CHECK(mp.remoteFrees.load() == nullptr);
+    CHECK(mp.firstBlock != full);
+
+    // Aligned allocations collect them too
+    void* unit = mp.allocate(100);
+    AppShift::Memory::MemoryPool::freeRemote(unit);
+    while (mp.fitsCurrentBlock(200)) mp.allocate(200);
+    mp.allocateAligned(200, 64);
+    CHECK(mp.remoteFrees.load() == nullptr);
+    return 0;
+}
+
+int testScopes() {
+    AppShift::Memory::MemoryPool mp(4096);
+    mp.allocate(100);
+
+    // A unit of a scope freed by another thread before the scope ends
+    mp.startScope();
+    void* unit = mp.allocate(64);
+    std::thread other([unit]() { AppShift::Memory::MemoryPool::freeRemote(unit); });
+    other.join();
+    mp.endScope();
+    CHECK(mp.remoteFrees.load() == nullptr);
+
+    // Its space is reused, so the queue must not link to it anymore
+    std::memset(mp.allocate(64), 0xff, 64);
+    mp.collectRemoteFrees();
+    CHECK(mp.getStats().liveUnits == 2);
+    return 0;
+}
+
+// Messages allocated by the producer's pool & freed by the consumers
+std::mutex mailboxLock;
+std::vector<unsigned char*> mailbox;
+std::atomic<bool> producing(true);
+std::atomic<bool> failed(false);
+
+void consumer() {
+    while (true) {
+        unsigned char* message = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mailboxLock);
+            if (!mailbox.empty()) {
+                message = mailbox.back();
+                mailbox.pop_back();
+            }
+        }
+        if (message == nullptr) {
+            if (!producing) return;
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 1; i < message[0]; i++) if (message[i] != message[0]) failed = true;
+        AppShift::Memory::MemoryPool::freeRemote(message);
+    }
+}
+
+int testProducerConsumer() {
+    AppShift::Memory::MemoryPool mp(16 * 1024);
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < 4; i++) consumers.emplace_back(consumer);
+
+    for (int i = 0; i < 200000; i++) {
+        size_t size = 8 + i % 200;
+        unsigned char* message = mp.allocate<unsigned char>(size);
+        std::memset(message, (unsigned char) size, size);
+        std::lock_guard<std::mutex> lock(mailboxLock);
+        mailbox.push_back(message);
+    }
+    producing = false;
+    for (std::thread& thread : consumers) thread.join();
+    CHECK(!failed);
+
+    mp.collectRemoteFrees();
+    CHECK(mp.getStats().liveUnits == 0);
+    CHECK(mp.firstBlock == mp.currentBlock);
+    return 0;
+}
+
+int main() {
+    if (testQueue() != 0) return 1;
+    if (testCollectOnAllocate() != 0) return 1;
+    if (testScopes() != 0) return 1;
+    if (testProducerConsumer() != 0) return 1;
+
+    std::cout << "Remote frees tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+// Counts the blocks given to a pool
+class CountingBlockProvider : public AppShift::Memory::MallocBlockProvider {
+public:
+    size_t allocatedBlocks = 0;
+
+    void* allocateBlock(size_t size) override {
+        allocatedBlocks++;
+        return MallocBlockProvider::allocateBlock(size);
+    }
+
+    void* allocateAlignedBlock(size_t size, size_t alignment) override {
+        allocatedBlocks++;
+        return MallocBlockProvider::allocateAlignedBlock(size, alignment);
+    }
+};
+
+// Minor & major page faults of the process so far
+long pageFaults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+int testReserve() {
+    CountingBlockProvider provider;
+    AppShift::Memory::MemoryPool mp(64 * 1024, &provider);
+    CHECK(provider.allocatedBlocks == 1);
+
+    // The blocks for 1MB, with the space of the first block, are created up front & kept
+    mp.reserve(1024 * 1024);
+    size_t reserved_blocks = provider.allocatedBlocks - 1;
+    CHECK(reserved_blocks == 15);
+    CHECK(mp.retainedBlocksCount == reserved_blocks);
+
+    // Reserving less than what is there already creates nothing
+    mp.reserve(512 * 1024);
+    CHECK(provider.allocatedBlocks == reserved_blocks + 1);
+
+    // Allocations take the reserved blocks instead of the provider
+    for (int i = 0; i < 900; i++) mp.allocate(1000);
+    CHECK(provider.allocatedBlocks == reserved_blocks + 1);
+    CHECK(mp.retainedBlocksCount < reserved_blocks);
+    return 0;
+}
+
+int testPreallocateBlocks() {
+    CountingBlockProvider provider;
+    AppShift::Memory::MemoryPool mp(4096, &provider);
+    mp.allocate(100);
+
+    mp.preallocateBlocks(8, true);
+    CHECK(provider.allocatedBlocks == 9);
+    CHECK(mp.retainedBlocksCount == 8);
+
+    // The blocks are used in the order they were created
+    AppShift::Memory::SMemoryBlockHeader* first_reserved = mp.retainedBlocks;
+    mp.allocate(4000);
+    CHECK(mp.currentBlock == first_reserved);
+
+    // Statistics count the kept blocks as reserved
+    AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.blockCount == 2);
+    CHECK(stats.bytesRetained == 7 * (4096 + sizeof(AppShift::Memory::SMemoryBlockHeader)));
+    return 0;
+}
+
+int testConstructorReservation() {
+    CountingBlockProvider provider;
+    {
+        AppShift::Memory::MemoryPool mp(1024 * 1024, &provider, 8 * 1024 * 1024);
+        CHECK(provider.allocatedBlocks == 8);
+
+        // The pages are faulted by the reservation, not by the first allocations
+        long faults = pageFaults();
+        for (int i = 0; i < 7 * 1024; i++) std::memset(mp.allocate(1000), i, 1000);
+        CHECK(pageFaults() - faults < 256);
+        CHECK(provider.allocatedBlocks == 8);
+    }
+    return 0;
+}
+
+int main() {
+    if (testReserve() != 0) return 1;
+    if (testPreallocateBlocks() != 0) return 1;
+    if (testConstructorReservation() != 0) return 1;
+
+    std::cout << "Reservation tests passed" << std::endl;
+    return 0;
+}
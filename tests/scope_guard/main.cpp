@@ -0,0 +1,214 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+// Order in which the tracked objects were destroyed
+std::vector<int> destroyed;
+
+struct Tracked {
+    int id;
+    std::string name;
+
+    Tracked(int id) : id(id), name("tracked object " + std::to_string(id)) {}
+    ~Tracked() { destroyed.push_back(this->id); }
+};
+
+struct alignas(64) OverAligned {
+    int id;
+
+    OverAligned(int id) : id(id) {}
+    ~OverAligned() { destroyed.push_back(this->id); }
+};
+
+struct Throwing {
+    Throwing() { throw 1; }
+    ~Throwing() { destroyed.push_back(-1); }
+};
+
+// Live units of the current block
+size_t liveUnits(AppShift::Memory::MemoryPool& mp) {
+    return mp.currentBlock->numberOfAllocated - mp.currentBlock->numberOfDeleted;
+}
+
+int testDestructionOrder() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    destroyed.clear();
+    {
+        AppShift::Memory::ScopeGuard scope(&mp);
+        for (int i = 0; i < 5; i++) {
+            Tracked* object = scope.make<Tracked>(i);
+            CHECK(object->id == i);
+            CHECK(object->name == "tracked object " + std::to_string(i));
+        }
+
+        // Trivial objects get no finalizer
+        int* number = scope.make<int>(42);
+        CHECK(*number == 42);
+        CHECK(destroyed.empty());
+    }
+
+    CHECK(destroyed == std::vector<int>({ 4, 3, 2, 1, 0 }));
+    CHECK(mp.currentScope == nullptr);
+    CHECK(mp.currentBlock->offset == 0);
+    CHECK(mp.currentBlock->numberOfAllocated == 0);
+    return 0;
+}
+
+int testNesting() {
+    AppShift::Memory::MemoryPool mp(1024);
+    destroyed.clear();
+    {
+        AppShift::Memory::ScopeGuard outer(&mp);
+        outer.make<Tracked>(1);
+        {
+            AppShift::Memory::ScopeGuard inner(&mp);
+            inner.make<Tracked>(2);
+
+            // Objects spread over new blocks
+            for (int i = 0; i < 100; i++) inner.make<Tracked>(100 + i);
+        }
+        CHECK(destroyed.size() == 101);
+        CHECK(destroyed.back() == 2);
+        CHECK(mp.currentBlock == mp.firstBlock);
+        CHECK(mp.currentBlock->next == nullptr);
+        outer.make<Tracked>(3);
+    }
+    CHECK(destroyed.size() == 103);
+    CHECK(destroyed[101] == 3 && destroyed[102] == 1);
+
+    // A guard ends the inner scopes left open
+    destroyed.clear();
+    {
+        AppShift::Memory::ScopeGuard guard(&mp);
+        guard.make<Tracked>(1);
+        mp.startScope();
+        mp.make<Tracked>(2);
+        mp.startScope();
+        mp.make<Tracked>(3);
+    }
+    CHECK(destroyed == std::vector<int>({ 3, 2, 1 }));
+    CHECK(mp.currentScope == nullptr);
+
+    // A guard whose scope was already ended does nothing
+    destroyed.clear();
+    mp.startScope();
+    {
+        AppShift::Memory::ScopeGuard guard(&mp);
+        guard.make<Tracked>(1);
+        mp.endScope();
+        CHECK(destroyed.size() == 1);
+        mp.make<Tracked>(2);
+    }
+    CHECK(destroyed.size() == 1);
+    CHECK(mp.currentScope != nullptr);
+    mp.endScope();
+    CHECK(destroyed.size() == 2);
+    CHECK(mp.currentScope == nullptr);
+    return 0;
+}
+
+int testExactCounters() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    void* before = mp.allocate(32);
+    void* deleted_before = mp.allocate(32);
+    mp.allocate(32);
+    mp.free(deleted_before);
+    size_t allocated = mp.currentBlock->numberOfAllocated;
+    size_t deleted = mp.currentBlock->numberOfDeleted;
+
+    // No frees in the scope
+    {
+        AppShift::Memory::ScopeGuard scope(&mp);
+        for (int i = 0; i < 10; i++) mp.allocate(16);
+    }
+    CHECK(mp.currentBlock->numberOfAllocated == allocated);
+    CHECK(mp.currentBlock->numberOfDeleted == deleted);
+
+    // Frees inside the scope & before it
+    {
+        AppShift::Memory::ScopeGuard scope(&mp);
+        void* units[10];
+        for (int i = 0; i < 10; i++) units[i] = mp.allocate(16);
+        for (int i = 0; i < 10; i += 2) mp.free(units[i]);
+        mp.free(before);
+    }
+    CHECK(mp.currentBlock->numberOfAllocated == allocated);
+    CHECK(mp.currentBlock->numberOfDeleted == deleted + 1);
+    CHECK(liveUnits(mp) == 1);
+
+    // Garbage compressed in a scope merges the units before it
+    {
+        AppShift::Memory::ScopeGuard scope(&mp);
+        void* units[10];
+        for (int i = 0; i < 10; i++) units[i] = mp.allocate(16);
+        for (int i = 2; i < 6; i++) mp.free(units[i]);
+        mp.compressGarbage();
+    }
+    CHECK(mp.currentBlock->numberOfAllocated == allocated - 1);
+    CHECK(mp.currentBlock->numberOfDeleted == deleted);
+    CHECK(liveUnits(mp) == 1);
+    return 0;
+}
+
+int testAlignmentAndExceptions() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    destroyed.clear();
+    {
+        AppShift::Memory::ScopeGuard scope(&mp);
+        for (int i = 0; i < 8; i++) {
+            mp.allocate(i + 1);
+            OverAligned* object = scope.make<OverAligned>(i);
+            CHECK(reinterpret_cast<uintptr_t>(object) % 64 == 0);
+            CHECK(object->id == i);
+        }
+
+        // A constructor that throws leaves no object to destroy
+        bool thrown = false;
+        try { scope.make<Throwing>(); }
+        catch (int) { thrown = true; }
+        CHECK(thrown);
+    }
+    CHECK(destroyed == std::vector<int>({ 7, 6, 5, 4, 3, 2, 1, 0 }));
+
+    // Without a scope objects are only constructed
+    destroyed.clear();
+    Tracked* object = mp.make<Tracked>(1);
+    CHECK(object->id == 1);
+    object->~Tracked();
+    mp.free(object);
+    CHECK(destroyed.size() == 1);
+    return 0;
+}
+
+int main() {
+    if (testDestructionOrder() != 0) return 1;
+    if (testNesting() != 0) return 1;
+    if (testExactCounters() != 0) return 1;
+    if (testAlignmentAndExceptions() != 0) return 1;
+
+    std::cout << "Scope guard tests passed" << std::endl;
+    return 0;
+}
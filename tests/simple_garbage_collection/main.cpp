@@ -21,8 +21,128 @@
 #include <iostream>
 #include "../../MemoryPool.h"
 
-AppShift::Memory::MemoryPool testPool (256 * 1024);
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+int testTailFree() {
+    AppShift::Memory::MemoryPool mp(256 * 1024);
+    char* first = mp.allocate<char>(100);
+    char* second = mp.allocate<char>(100);
+
+    // Freeing the last unit moves the offset back
+    mp.free(second);
+    CHECK(mp.currentBlock->offset == sizeof(AppShift::Memory::SMemoryUnitHeader) + 104);
+    CHECK(mp.allocate<char>(100) == second);
+
+    // Freeing any other unit only marks it
+    mp.free(first);
+    CHECK(mp.currentBlock->numberOfDeleted == 1);
+    mp.free(second);
+    return 0;
+}
+
+int testBlockRetention() {
+    AppShift::Memory::MemoryPool mp(1024);
+    mp.allocate<char>(900);
+
+    // The block of a unit that crosses the boundary is kept when it empties
+    char* crossing = mp.allocate<char>(200);
+    AppShift::Memory::SMemoryBlockHeader* block = mp.currentBlock;
+    mp.free(crossing);
+    CHECK(mp.currentBlock != block);
+    CHECK(mp.retainedBlocks == block);
+    CHECK(mp.retainedBlocksCount == 1);
+
+    // And used again by the next block created
+    crossing = mp.allocate<char>(200);
+    CHECK(mp.currentBlock == block);
+    CHECK(mp.retainedBlocks == nullptr);
+    mp.free(crossing);
+
+    // Trim gives the kept blocks back
+    mp.trim();
+    CHECK(mp.retainedBlocks == nullptr);
+    CHECK(mp.retainedBytes == 0);
+
+    // Without retention blocks are freed right away
+    mp.setBlockRetention(0);
+    crossing = mp.allocate<char>(200);
+    mp.free(crossing);
+    CHECK(mp.retainedBlocks == nullptr);
+
+    // Blocks bigger than the bytes limit are not kept
+    mp.setBlockRetention(4, 2 * 1024);
+    crossing = mp.allocate<char>(4096);
+    mp.free(crossing);
+    CHECK(mp.retainedBlocks == nullptr);
+
+    // Neither are blocks bigger than the next block size, like the block of a big unit
+    AppShift::Memory::MemoryPool big_mp(4096);
+    big_mp.allocate<char>(100);
+    size_t reserved = big_mp.getStats().bytesReserved;
+    char* big = big_mp.allocate<char>(1024 * 1024);
+    CHECK(big_mp.getStats().bytesReserved > reserved + 1024 * 1024);
+    big_mp.free(big);
+    CHECK(big_mp.retainedBlocks == nullptr);
+    CHECK(big_mp.getStats().bytesReserved == reserved);
+    return 0;
+}
+
+int testScopeRetention() {
+    AppShift::Memory::MemoryPool mp(1024);
+    mp.setBlockRetention(8);
+
+    mp.startScope();
+    for (int i = 0; i < 40; i++) mp.allocate<char>(300);
+    mp.endScope();
+
+    // Blocks of the scope are kept up to the limit
+    CHECK(mp.retainedBlocksCount == 8);
+    CHECK(mp.firstBlock == mp.currentBlock);
+    return 0;
+}
+
+// Counts the blocks given to a pool
+class CountingBlockProvider : public AppShift::Memory::MemoryBlockProvider {
+public:
+    size_t allocatedBlocks = 0;
+    size_t freedBlocks = 0;
+
+    void* allocateBlock(size_t size) override {
+        allocatedBlocks++;
+        return std::malloc(size);
+    }
+
+    void freeBlock(void* block, size_t) override {
+        freedBlocks++;
+        std::free(block);
+    }
+};
+
+int testBlockProvider() {
+    CountingBlockProvider provider;
+    {
+        AppShift::Memory::MemoryPool mp(1024, &provider);
+        mp.setBlockRetention(2);
+        CHECK(provider.allocatedBlocks == 1);
+
+        mp.startScope();
+        for (int i = 0; i < 40; i++) mp.allocate<char>(300);
+        mp.endScope();
+        CHECK(provider.freedBlocks == provider.allocatedBlocks - 3);
+    }
+
+    // All the blocks, including the retained ones, go back to the provider
+    CHECK(provider.allocatedBlocks > 1);
+    CHECK(provider.freedBlocks == provider.allocatedBlocks);
+    return 0;
+}
 
 int main() {
+    if (testTailFree() != 0) return 1;
+    if (testBlockRetention() != 0) return 1;
+    if (testScopeRetention() != 0) return 1;
+    if (testBlockProvider() != 0) return 1;
+
+    std::cout << "Simple garbage collection tests passed" << std::endl;
     return 0;
 }
@@ -0,0 +1,209 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define UNIT_HEADER sizeof(AppShift::Memory::SMemoryUnitHeader)
+#define BLOCK_HEADER sizeof(AppShift::Memory::SMemoryBlockHeader)
+
+int testUsage() {
+    AppShift::Memory::MemoryPool mp(64 * 1024);
+    AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.blockCount == 1);
+    CHECK(stats.bytesReserved == BLOCK_HEADER + 64 * 1024);
+    CHECK(stats.bytesUsed == 0);
+    CHECK(stats.bytesWasted == 0);
+
+    // Freeing a unit in the middle leaves it deleted
+    void* first = mp.allocate(104);
+    void* second = mp.allocate(104);
+    void* third = mp.allocate(104);
+    mp.free(second);
+    stats = mp.getStats();
+    CHECK(stats.bytesUsed == 2 * (UNIT_HEADER + 104));
+    CHECK(stats.bytesDeleted == UNIT_HEADER + 104);
+    CHECK(stats.bytesWasted == UNIT_HEADER + 104);
+    CHECK(stats.liveUnits == 2);
+    CHECK(stats.deletedUnits == 1);
+
+    // Space left at the end of a block is wasted once a new block is current
+    size_t tail = mp.currentBlock->blockSize - mp.currentBlock->offset;
+    void* big = mp.allocate(tail);
+    stats = mp.getStats();
+    CHECK(stats.blockCount == 2);
+    CHECK(stats.bytesWasted == UNIT_HEADER + 104 + tail);
+
+    mp.free(big);
+    mp.free(third);
+    mp.free(first);
+    stats = mp.getStats();
+    CHECK(stats.bytesUsed == 0);
+    CHECK(stats.liveUnits == 0);
+    return 0;
+}
+
+#ifndef MEMORYPOOL_DISABLE_STATS
+int testCounters() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    mp.setBlockRetention(1);
+
+    std::vector<void*> units;
+    for (int i = 0; i < 100; i++) units.push_back(mp.allocate(8 + i));
+    for (void* unit : units) mp.free(unit);
+
+    // Each block is counted once when created & once when given back to the provider
+    AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.allocations == 100);
+    CHECK(stats.frees == 100);
+    CHECK(stats.blockCount == 1);
+    CHECK(stats.blocksCreated > 1);
+    CHECK(stats.blocksFreed == stats.blocksCreated - 2);
+    CHECK(stats.bytesRetained == BLOCK_HEADER + 4 * 1024);
+    CHECK(stats.peakBytesReserved >= stats.blocksCreated * (BLOCK_HEADER + 4 * 1024) - stats.blocksFreed * (BLOCK_HEADER + 4 * 1024));
+    CHECK(stats.peakBytesUsed > 100 * UNIT_HEADER);
+    CHECK(stats.bytesUsed == 0);
+
+    mp.trim();
+    stats = mp.getStats();
+    CHECK(stats.blocksFreed == stats.blocksCreated - 1);
+    CHECK(stats.bytesReserved == BLOCK_HEADER + 4 * 1024);
+
+    // Sizes are counted by their highest bit
+    size_t histogram_sum = 0;
+    for (size_t i = 0; i < MEMORYPOOL_STATS_HISTOGRAM_BINS; i++) histogram_sum += stats.sizeHistogram[i];
+    CHECK(histogram_sum == 100);
+    CHECK(stats.sizeHistogram[3] == 8);
+    CHECK(stats.sizeHistogram[4] == 16);
+    CHECK(stats.sizeHistogram[5] == 32);
+    return 0;
+}
+
+int testPeaksAndScopes() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    void* before = mp.allocate(64);
+    size_t used = mp.getStats().bytesUsed;
+
+    // Units left in a scope are given back, deleted or not
+    mp.startScope();
+    std::vector<void*> units;
+    for (int i = 0; i < 200; i++) units.push_back(mp.allocate(48));
+    for (size_t i = 0; i < units.size(); i += 3) mp.free(units[i]);
+    mp.endScope();
+
+    AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.bytesUsed == used);
+    CHECK(stats.peakBytesUsed >= used + 200 * (UNIT_HEADER + 48));
+
+    // Re-allocation in place & reused deleted units keep the used bytes exact
+    mp.enableFreeLists();
+    void* growing = mp.allocate(16);
+    growing = mp.reallocate(growing, 256);
+    void* middle = mp.allocate(32);
+    void* last = mp.allocate(32);
+    mp.free(middle);
+    CHECK(mp.allocate(32) == middle);
+    CHECK(mp.getStats().bytesUsed == used + 3 * UNIT_HEADER + 256 + 64);
+
+    mp.free(last);
+    mp.free(middle);
+    mp.free(growing);
+    mp.free(before);
+    CHECK(mp.getStats().bytesUsed == 0);
+    return 0;
+}
+#endif
+
+int testRandomUsage() {
+    AppShift::Memory::MemoryPool mp(16 * 1024);
+    std::vector<void*> units;
+    std::vector<size_t> sizes;
+    size_t live_bytes = 0;
+    unsigned int seed = 7;
+
+    // The used bytes always match the live units
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        size_t action = (seed >> 16) % 4;
+        size_t size = 8 * (1 + (seed >> 8) % 64);
+
+        if (action < 2 || units.empty()) {
+            units.push_back(mp.allocate(size));
+            sizes.push_back(size);
+            live_bytes += UNIT_HEADER + size;
+        }
+        else {
+            size_t index = (seed >> 4) % units.size();
+            if (action == 2) {
+                mp.free(units[index]);
+                live_bytes -= UNIT_HEADER + sizes[index];
+                units[index] = units.back();
+                sizes[index] = sizes.back();
+                units.pop_back();
+                sizes.pop_back();
+            }
+            else {
+                // Units shrunk in place may keep a few bytes more than asked
+                units[index] = mp.reallocate(units[index], size);
+                size = AppShift::Memory::MemoryPool::getCapacity(units[index]);
+                live_bytes += size - sizes[index];
+                sizes[index] = size;
+            }
+        }
+        if (i % 1000 == 0) mp.compressGarbage();
+    }
+
+    AppShift::Memory::SMemoryPoolStats stats = mp.getStats();
+    CHECK(stats.bytesUsed == live_bytes);
+    CHECK(stats.liveUnits == units.size());
+    return 0;
+}
+
+int testJson() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    mp.allocate(100);
+
+    std::ostringstream stream;
+    mp.dumpStatsJson(stream);
+    std::string json = stream.str();
+    CHECK(json.rfind("{\"blockCount\":1,", 0) == 0);
+    CHECK(json.find("\"bytesUsed\":" + std::to_string(mp.getStats().bytesUsed) + ",") != std::string::npos);
+    CHECK(json.find("\"sizeHistogram\":[") != std::string::npos);
+    CHECK(json.substr(json.size() - 2) == "]}");
+    return 0;
+}
+
+int main() {
+    if (testUsage() != 0) return 1;
+#ifndef MEMORYPOOL_DISABLE_STATS
+    if (testCounters() != 0) return 1;
+    if (testPeaksAndScopes() != 0) return 1;
+#endif
+    if (testRandomUsage() != 0) return 1;
+    if (testJson() != 0) return 1;
+
+    std::cout << "Statistics tests passed" << std::endl;
+    return 0;
+}
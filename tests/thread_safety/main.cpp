@@ -19,10 +19,111 @@
  */
 
 #include <iostream>
-#include "../../MemoryPool.h"
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include "../../ThreadSafeMemoryPool.h"
 
-AppShift::Memory::MemoryPool testPool (256 * 1024);
+// Messages handed between the threads
+std::mutex mailboxLock;
+std::vector<unsigned char*> mailbox;
+std::atomic<bool> failed(false);
+
+// Allocate messages, hand half of them to other threads & free what others handed over
+void handOffWorker(AppShift::Memory::ThreadSafeMemoryPool* mp, unsigned char id, int rounds) {
+    std::vector<unsigned char*> own;
+
+    for (int i = 0; i < rounds; i++) {
+        size_t size = 8 + (i * 7 + id * 13) % 200;
+        unsigned char* message = mp->allocate<unsigned char>(size);
+        message[0] = (unsigned char) size;
+        std::memset(message + 1, id, size - 1);
+
+        if (i % 2 == 0) {
+            std::lock_guard<std::mutex> lock(mailboxLock);
+            mailbox.push_back(message);
+        }
+        else own.push_back(message);
+
+        // Free a message of another thread
+        unsigned char* foreign = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mailboxLock);
+            if (!mailbox.empty()) {
+                foreign = mailbox.back();
+                mailbox.pop_back();
+            }
+        }
+        if (foreign != nullptr) {
+            for (size_t j = 2; j < foreign[0]; j++) if (foreign[j] != foreign[1]) failed = true;
+            mp->free(foreign);
+        }
+
+        // Grow some of the own messages, then free them in LIFO order
+        if (own.size() == 16) {
+            own.back() = mp->reallocate<unsigned char>(own.back(), 512);
+            if (own.back()[1] != id) failed = true;
+            while (!own.empty()) {
+                mp->free(own.back());
+                own.pop_back();
+            }
+        }
+    }
+
+    for (unsigned char* message : own) mp->free(message);
+}
+
+// Benchmark allocation throughput of the pool or malloc with a given number of threads
+double benchmark(AppShift::Memory::ThreadSafeMemoryPool* mp, size_t thread_count, int operations) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([mp, operations]() {
+            void* batch[64];
+            for (int i = 0; i < operations; i += 64) {
+                for (int j = 0; j < 64; j++) batch[j] = mp != nullptr ? mp->allocate(16 + j) : std::malloc(16 + j);
+                for (int j = 63; j >= 0; j--) {
+                    if (mp != nullptr) mp->free(batch[j]);
+                    else std::free(batch[j]);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (double) thread_count * operations / elapsed.count() / 1000000;
+}
 
 int main() {
+    size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+
+    // Correctness: objects are handed between threads & freed by others
+    {
+        AppShift::Memory::ThreadSafeMemoryPool mp(64 * 1024);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < max_threads; t++) threads.emplace_back(handOffWorker, &mp, (unsigned char) (t + 1), 200000);
+        for (std::thread& thread : threads) thread.join();
+        for (unsigned char* message : mailbox) mp.free(message);
+        mailbox.clear();
+    }
+
+    if (failed) {
+        std::cout << "Thread safety test failed: corrupted message" << std::endl;
+        return 1;
+    }
+    std::cout << "Thread safety test passed" << std::endl;
+
+    // Scaling: allocations per second from 1 to N threads
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        AppShift::Memory::ThreadSafeMemoryPool mp;
+        double pool_rate = benchmark(&mp, thread_count, 4000000);
+        double malloc_rate = benchmark(nullptr, thread_count, 4000000);
+        std::cout << thread_count << " threads: ThreadSafeMemoryPool " << pool_rate << " M ops/s, malloc " << malloc_rate << " M ops/s" << std::endl;
+    }
+
     return 0;
 }
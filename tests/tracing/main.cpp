@@ -0,0 +1,173 @@
+/**
+ * AppShift Memory Pool v2.0.0
+ *
+ * Copyright 2020-present Sapir Shemer, DevShift (devshift.biz)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author Sapir Shemer
+ */
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include "../../MemoryPool.h"
+
+#define CHECK(condition) if (!(condition)) { std::cout << "Failed: " #condition " (line " << __LINE__ << ")" << std::endl; return 1; }
+
+#define TRACE_PATH "memorypool_test.trace"
+
+using AppShift::Memory::ETraceEvent;
+
+// Read all the events of a trace
+std::vector<AppShift::Memory::STraceEvent> readTrace(const char* path) {
+    std::vector<AppShift::Memory::STraceEvent> events;
+    AppShift::Memory::MemoryPoolTraceReader reader(path);
+    AppShift::Memory::STraceEvent event;
+    while (reader.next(event)) events.push_back(event);
+    return events;
+}
+
+int testRecording() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    mp.startTracing(TRACE_PATH);
+
+    void* first = mp.allocate(100);
+    void* aligned = mp.allocateAligned(32, 64);
+    void* moved = mp.reallocate(first, 5000);
+    mp.startScope();
+    mp.allocate<int>(10);
+    mp.endScope();
+    mp.free(aligned);
+    mp.free(moved);
+    mp.stopTracing();
+
+    // Calls made by the pool itself, like the moving re-allocation, are not recorded
+    std::vector<AppShift::Memory::STraceEvent> events = readTrace(TRACE_PATH);
+    CHECK(events.size() == 8);
+    CHECK(events[0].type == ETraceEvent::ALLOCATE && events[0].size == 100 && events[0].alignment == 0 && events[0].address == reinterpret_cast<uintptr_t>(first));
+    CHECK(events[1].type == ETraceEvent::ALLOCATE && events[1].size == 32 && events[1].alignment == 64 && events[1].address == reinterpret_cast<uintptr_t>(aligned));
+    CHECK(events[2].type == ETraceEvent::REALLOCATE && events[2].address == reinterpret_cast<uintptr_t>(first) && events[2].size == 5000);
+    CHECK(events[2].newAddress == reinterpret_cast<uintptr_t>(moved));
+    CHECK(events[3].type == ETraceEvent::START_SCOPE);
+    CHECK(events[4].type == ETraceEvent::ALLOCATE && events[4].size == 10 * sizeof(int) && events[4].alignment == alignof(int));
+    CHECK(events[5].type == ETraceEvent::END_SCOPE);
+    CHECK(events[6].type == ETraceEvent::FREE && events[6].address == reinterpret_cast<uintptr_t>(aligned));
+    CHECK(events[7].type == ETraceEvent::FREE && events[7].address == reinterpret_cast<uintptr_t>(moved));
+    for (size_t i = 1; i < events.size(); i++) CHECK(events[i].time >= events[i - 1].time);
+
+    // Nothing is recorded after the trace is stopped
+    mp.free(mp.allocate(8));
+    CHECK(readTrace(TRACE_PATH).size() == 8);
+    return 0;
+}
+
+int testThreads() {
+    std::vector<AppShift::Memory::STraceEvent> events;
+
+    // Every thread records in its own pool, the threads get different numbers
+    std::thread other([]() {
+        AppShift::Memory::MemoryPool mp;
+        mp.startTracing(TRACE_PATH);
+        mp.free(mp.allocate(16));
+    });
+    other.join();
+    events = readTrace(TRACE_PATH);
+    CHECK(events.size() == 2);
+    uint32_t other_thread = events[0].thread;
+
+    AppShift::Memory::MemoryPool mp;
+    mp.startTracing(TRACE_PATH);
+    mp.free(mp.allocate(16));
+    mp.stopTracing();
+    events = readTrace(TRACE_PATH);
+    CHECK(events.size() == 2);
+    CHECK(events[0].thread != other_thread);
+    return 0;
+}
+
+int testRemoteFrees() {
+    AppShift::Memory::MemoryPool mp(4 * 1024);
+    mp.startTracing(TRACE_PATH);
+    void* first = mp.allocate(1000);
+    void* second = mp.allocate(1000);
+    mp.allocate(1000);
+
+    // Units freed by another thread are recorded when the pool collects them
+    std::thread other([first, second]() {
+        AppShift::Memory::MemoryPool::freeRemote(first);
+        AppShift::Memory::MemoryPool::freeRemote(second);
+    });
+    other.join();
+    void* last = mp.allocate(3000);
+    mp.stopTracing();
+
+    std::vector<AppShift::Memory::STraceEvent> events = readTrace(TRACE_PATH);
+    CHECK(events.size() == 6);
+    CHECK(events[3].type == ETraceEvent::FREE && events[3].address == reinterpret_cast<uintptr_t>(second));
+    CHECK(events[4].type == ETraceEvent::FREE && events[4].address == reinterpret_cast<uintptr_t>(first));
+    CHECK(events[5].type == ETraceEvent::ALLOCATE && events[5].address == reinterpret_cast<uintptr_t>(last));
+    return 0;
+}
+
+int testLargeTrace() {
+    AppShift::Memory::MemoryPool mp;
+    mp.startTracing(TRACE_PATH);
+    std::vector<void*> units;
+    for (int i = 0; i < 100000; i++) units.push_back(mp.allocate(8 + i % 300));
+    for (int i = 99999; i >= 0; i--) mp.free(units[i]);
+    mp.stopTracing();
+
+    // Events cross the buffer flushes, addresses close to each other take few bytes
+    std::vector<AppShift::Memory::STraceEvent> events = readTrace(TRACE_PATH);
+    CHECK(events.size() == 200000);
+    CHECK(events[99999].address == reinterpret_cast<uintptr_t>(units[99999]));
+    CHECK(events[100000].type == ETraceEvent::FREE && events[100000].address == reinterpret_cast<uintptr_t>(units[99999]));
+
+    std::FILE* file = std::fopen(TRACE_PATH, "rb");
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    CHECK(size < 200000 * 12);
+    return 0;
+}
+
+int testErrors() {
+    AppShift::Memory::MemoryPool mp;
+    bool thrown = false;
+    try { mp.startTracing("missing_directory/trace"); }
+    catch (AppShift::Memory::EMemoryErrors error) { thrown = error == AppShift::Memory::EMemoryErrors::CANNOT_OPEN_TRACE; }
+    CHECK(thrown);
+    CHECK(mp.trace == nullptr);
+
+    // Files that are not traces are rejected
+    std::FILE* file = std::fopen(TRACE_PATH, "wb");
+    std::fputs("not a trace file", file);
+    std::fclose(file);
+    AppShift::Memory::MemoryPoolTraceReader reader(TRACE_PATH);
+    CHECK(!reader.isValid());
+    return 0;
+}
+
+int main() {
+    if (testRecording() != 0) return 1;
+    if (testThreads() != 0) return 1;
+    if (testRemoteFrees() != 0) return 1;
+    if (testLargeTrace() != 0) return 1;
+    if (testErrors() != 0) return 1;
+    std::remove(TRACE_PATH);
+
+    std::cout << "Tracing tests passed" << std::endl;
+    return 0;
+}